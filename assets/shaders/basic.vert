@@ -13,6 +13,9 @@ layout (location = 4) out vec4 outLightSpaceFragPos_0;
 layout (location = 5) out vec4 outLightSpaceFragPos_1;
 layout (location = 6) out vec4 outLightSpaceFragPos_2;
 
+// Specialization constant shared with basic.frag, light space positions of unused shadow maps are skipped.
+layout (constant_id = 2) const int ShadowMapCount = 3;
+
 // Per frame data
 layout (std140, set = 0, binding = 0) uniform CameraBuffer
 {
@@ -40,7 +43,13 @@ void main()
     outColor = VIColor;
     outNormal = LSNormal;
     outTexCoords = TexCoords;
-    outLightSpaceFragPos_0 = u_depthInfo.LightMatrix[0] * u_Object.ModelMatrix * vec4(LSPosition, 1.f);
-    outLightSpaceFragPos_1 = u_depthInfo.LightMatrix[1] * u_Object.ModelMatrix * vec4(LSPosition, 1.f);
-    outLightSpaceFragPos_2 = u_depthInfo.LightMatrix[2] * u_Object.ModelMatrix * vec4(LSPosition, 1.f);
+    outLightSpaceFragPos_0 = vec4(0.f);
+    outLightSpaceFragPos_1 = vec4(0.f);
+    outLightSpaceFragPos_2 = vec4(0.f);
+    if (ShadowMapCount > 0)
+        outLightSpaceFragPos_0 = u_depthInfo.LightMatrix[0] * wsPos;
+    if (ShadowMapCount > 1)
+        outLightSpaceFragPos_1 = u_depthInfo.LightMatrix[1] * wsPos;
+    if (ShadowMapCount > 2)
+        outLightSpaceFragPos_2 = u_depthInfo.LightMatrix[2] * wsPos;
 }
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 460
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
+
+#include "basic_lighting.glsl"
+
+// Bindless material data
+struct MaterialData
+{
+    uint DiffuseTexture;
+    uint NormalTexture;
+    uint SpecularTexture;
+    uint Padding;
+};
+layout(set = 2, binding = 0) uniform sampler2D u_Textures[];
+layout(std430, set = 2, binding = 1) readonly buffer Materials
+{
+    MaterialData u_Materials[];
+};
+
+// Per draw data
+layout(push_constant) uniform PushConstants
+{
+    uint MaterialIndex;
+} u_PushConstants;
+
+void main()
+{
+    MaterialData material = u_Materials[u_PushConstants.MaterialIndex];
+    outColor = texture(u_Textures[material.DiffuseTexture], inTexCoords);
+    if (outColor.a <= 0.1f)
+        discard;
+    outColor = vec4(ComputeLighting(), 1.f) * outColor;
+}
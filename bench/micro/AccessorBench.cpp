@@ -0,0 +1,55 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "MicroBench.h"
+#include "AccessorDecoder.h"
+#include <vkmmc/Vertex.h>
+
+// Attribute and index decode of the glTF loader against a memcpy of the same source bytes,
+// which is the bound for any conversion that has to read the whole accessor.
+void RunAccessorBench()
+{
+	using namespace vkmmc;
+	constexpr uint32_t count = 1 << 20;
+	std::vector<Vertex> vertices(count);
+	std::vector<uint32_t> indices(count);
+	std::vector<uint8_t> source(count * 12);
+	std::vector<uint8_t> copy(count * 12);
+	for (size_t i = 0; i < source.size(); ++i)
+		source[i] = (uint8_t)(i * 31);
+	// Float data has to be finite, conversion of NaNs could take a slow path.
+	float* floats = reinterpret_cast<float*>(source.data());
+	for (uint32_t i = 0; i < count * 3; ++i)
+		floats[i] = (float)(i % 1000) * 0.01f;
+	constexpr size_t vertexStride = sizeof(Vertex);
+
+	auto run = [&](const char* name, size_t bytes, auto&& decode)
+		{
+			const double memcpyNs = microbench::Measure([&]() { memcpy(copy.data(), source.data(), bytes); microbench::DoNotOptimize(copy.data()); });
+			const double ns = microbench::Measure([&]() { decode(); microbench::DoNotOptimize(vertices.data()); microbench::DoNotOptimize(indices.data()); });
+			microbench::Report(name, ns, bytes, memcpyNs);
+		};
+
+	printf("%u elements, ratio against memcpy of the source bytes\n", count);
+	// Vertex attributes scatter into the interleaved array, the element copy is the floor of that store pattern.
+	run("float3 per element copy -> Vertex", count * 12, [&]()
+		{
+			for (uint32_t i = 0; i < count; ++i)
+				memcpy(&vertices[i].Position[0], source.data() + i * 12, 12);
+		});
+	run("position float3 -> Vertex", count * 12, [&]()
+		{ accessor::DecodeStrided<float, 3, false>(&vertices[0].Position[0], vertexStride, source.data(), 12, count); });
+	run("normal int8x4 normalized -> Vertex", count * 4, [&]()
+		{ accessor::DecodeStrided<int8_t, 3, true>(&vertices[0].Normal[0], vertexStride, source.data(), 4, count); });
+	run("texcoord uint16x2 normalized -> Vertex", count * 4, [&]()
+		{ accessor::DecodeStrided<uint16_t, 2, true>(&vertices[0].TexCoords[0], vertexStride, source.data(), 4, count); });
+	run("color uint8x4 normalized -> Vertex", count * 4, [&]()
+		{ accessor::DecodeStrided<uint8_t, 3, true>(&vertices[0].Color[0], vertexStride, source.data(), 4, count); });
+	run("index uint16 + offset", count * 2, [&]()
+		{ accessor::DecodeIndices<uint16_t>(indices.data(), source.data(), 2, count, 17); });
+	run("index uint32 + offset", count * 4, [&]()
+		{ accessor::DecodeIndices<uint32_t>(indices.data(), source.data(), 4, count, 17); });
+	run("index uint32 packed", count * 4, [&]()
+		{ accessor::DecodeIndices<uint32_t>(indices.data(), source.data(), 4, count, 0); });
+}
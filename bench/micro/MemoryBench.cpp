@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "MicroBench.h"
+#include "DeviceMemoryAllocator.h"
+
+namespace
+{
+	constexpr uint32_t ResourceCount = 2048;
+	constexpr uint32_t ChurnIterations = 100000;
+	constexpr VkDeviceSize BlockSize = 256ull * 1024 * 1024;
+
+	// Deterministic sizes, same workload on every run.
+	struct Random
+	{
+		uint64_t State = 0x2545f4914f6cdd1dull;
+		uint32_t Next()
+		{
+			State = State * 6364136223846793005ull + 1442695040888963407ull;
+			return (uint32_t)(State >> 33);
+		}
+	};
+
+	struct Request
+	{
+		VkDeviceSize Size;
+		VkDeviceSize Alignment;
+	};
+
+	// Log uniform sizes from 256 B to 256 KB, like a mix of uniform buffers, meshes and small textures.
+	// One in four is an optimal image with 64 KB alignment.
+	std::vector<Request> MakeWorkload(uint32_t count, Random& random)
+	{
+		std::vector<Request> requests(count);
+		for (Request& request : requests)
+		{
+			const uint32_t log2 = 8 + random.Next() % 10;
+			request.Size = (1ull << log2) + random.Next() % (1u << log2);
+			request.Alignment = random.Next() % 4 ? 256 : 64 * 1024;
+		}
+		return requests;
+	}
+
+	// vkAllocateMemory per resource on the first device found. False if there is no device.
+	bool MeasureDriverAllocations(const std::vector<Request>& requests, double& pairNs)
+	{
+		VkApplicationInfo appInfo{ .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO, .apiVersion = VK_API_VERSION_1_1 };
+		VkInstanceCreateInfo instanceInfo{ .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO, .pApplicationInfo = &appInfo };
+		VkInstance instance;
+		if (vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS)
+			return false;
+		uint32_t gpuCount = 1;
+		VkPhysicalDevice gpu = VK_NULL_HANDLE;
+		vkEnumeratePhysicalDevices(instance, &gpuCount, &gpu);
+		VkDevice device = VK_NULL_HANDLE;
+		const float priority = 1.f;
+		VkDeviceQueueCreateInfo queueInfo{ .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO, .queueFamilyIndex = 0, .queueCount = 1, .pQueuePriorities = &priority };
+		VkDeviceCreateInfo deviceInfo{ .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, .queueCreateInfoCount = 1, .pQueueCreateInfos = &queueInfo };
+		if (!gpuCount || vkCreateDevice(gpu, &deviceInfo, nullptr, &device) != VK_SUCCESS)
+		{
+			vkDestroyInstance(instance, nullptr);
+			return false;
+		}
+		VkPhysicalDeviceMemoryProperties properties;
+		vkGetPhysicalDeviceMemoryProperties(gpu, &properties);
+		uint32_t memoryType = 0;
+		while (memoryType < properties.memoryTypeCount && !(properties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+			++memoryType;
+
+		std::vector<VkDeviceMemory> memories(requests.size());
+		pairNs = microbench::Measure([&]()
+			{
+				for (size_t i = 0; i < requests.size(); ++i)
+				{
+					VkMemoryAllocateInfo allocInfo{ .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, .allocationSize = requests[i].Size, .memoryTypeIndex = memoryType };
+					if (vkAllocateMemory(device, &allocInfo, nullptr, &memories[i]) != VK_SUCCESS)
+						memories[i] = VK_NULL_HANDLE;
+				}
+				for (VkDeviceMemory memory : memories)
+					vkFreeMemory(device, memory, nullptr);
+			}, 1, 3) / (double)requests.size();
+		vkDestroyDevice(device, nullptr);
+		vkDestroyInstance(instance, nullptr);
+		return true;
+	}
+}
+
+// TLSF block sub-allocation against one vkAllocateMemory per resource, and fragmentation of a block under churn.
+void RunMemoryBench()
+{
+	Random random;
+	const std::vector<Request> requests = MakeWorkload(ResourceCount, random);
+	VkDeviceSize requested = 0;
+	for (const Request& request : requests)
+		requested += request.Size;
+
+	// Allocate the whole workload and free it again.
+	std::vector<VkDeviceSize> offsets(requests.size());
+	std::vector<uint32_t> nodes(requests.size());
+	vkmmc::MemoryBlock block;
+	block.Init(VK_NULL_HANDLE, BlockSize, 0, nullptr);
+	VkDeviceSize peakUsed = 0;
+	const double tlsfNs = microbench::Measure([&]()
+		{
+			for (size_t i = 0; i < requests.size(); ++i)
+				block.Allocate(requests[i].Size, requests[i].Alignment, offsets[i], nodes[i]);
+			peakUsed = block.GetUsedSize();
+			for (uint32_t node : nodes)
+				block.Free(node);
+		}) / (double)requests.size();
+
+	double driverNs = 0.0;
+	const bool hasDevice = MeasureDriverAllocations(requests, driverNs);
+	if (hasDevice)
+		microbench::Report("vkAllocateMemory+vkFreeMemory", driverNs);
+	else
+		printf("%-40s %12s (no Vulkan device)\n", "vkAllocateMemory+vkFreeMemory", "skipped");
+	microbench::Report("MemoryBlock Allocate+Free", tlsfNs, 0, driverNs);
+	printf("%u resources, %.1f MB requested, %.1f MB used in block (%.2f%% unsplit tails), 1 driver allocation instead of %u\n",
+		ResourceCount, (double)requested / (1024.0 * 1024.0), (double)peakUsed / (1024.0 * 1024.0),
+		100.0 * (double)(peakUsed - requested) / (double)requested, ResourceCount);
+
+	// Churn: keep the block around 70% full, free a random resource and allocate a new one each iteration.
+	std::vector<uint32_t> live;
+	std::vector<Request> churn = MakeWorkload(ChurnIterations, random);
+	VkDeviceSize offset;
+	uint32_t node;
+	for (const Request& request : churn)
+	{
+		if (block.GetUsedSize() + request.Size > BlockSize * 7 / 10)
+			break;
+		if (block.Allocate(request.Size, request.Alignment, offset, node))
+			live.push_back(node);
+	}
+	uint32_t failures = 0;
+	const double churnNs = microbench::Measure([&]()
+		{
+			for (const Request& request : churn)
+			{
+				if (live.empty())
+					break;
+				const uint32_t index = random.Next() % (uint32_t)live.size();
+				block.Free(live[index]);
+				if (block.Allocate(request.Size, request.Alignment, offset, node))
+					live[index] = node;
+				else
+				{
+					live[index] = live.back();
+					live.pop_back();
+					++failures;
+				}
+			}
+		}, 1, 1) / (double)churn.size();
+	microbench::Report("MemoryBlock churn Free+Allocate", churnNs);
+	const VkDeviceSize freeSize = BlockSize - block.GetUsedSize();
+	printf("After %u churn iterations: %u live, %.1f%% used, fragmentation %.3f (largest free range %.1f MB of %.1f MB free), %u failed\n",
+		2 * ChurnIterations, (uint32_t)live.size(), 100.0 * (double)block.GetUsedSize() / (double)BlockSize,
+		1.0 - (double)block.GetLargestFreeRange() / (double)freeSize,
+		(double)block.GetLargestFreeRange() / (1024.0 * 1024.0), (double)freeSize / (1024.0 * 1024.0), failures);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace microbench
+{
+	// The compiler has to assume the data behind the pointer is read. MSVC has no inline asm on x64, the pointer
+	// is published through a volatile there.
+	inline void DoNotOptimize(const void* data)
+	{
+#ifdef _MSC_VER
+		static const void* volatile sink;
+		sink = data;
+#else
+		asm volatile("" : : "r"(data) : "memory");
+#endif
+	}
+
+	// Best of several runs of fn, in nanoseconds per call. The first run warms caches and is discarded.
+	template <typename Fn>
+	double Measure(Fn&& fn, uint32_t iterations = 1, uint32_t repeats = 7)
+	{
+		using Clock = std::chrono::steady_clock;
+		double best = 1e30;
+		for (uint32_t r = 0; r <= repeats; ++r)
+		{
+			const Clock::time_point start = Clock::now();
+			for (uint32_t i = 0; i < iterations; ++i)
+				fn();
+			const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (double)iterations;
+			if (r && ns < best)
+				best = ns;
+		}
+		return best;
+	}
+
+	inline void PrintHeader(const char* suite)
+	{
+		printf("\n== %s\n", suite);
+	}
+
+	// Time of a case with its throughput over bytes, and the ratio against a baseline time when given.
+	inline void Report(const char* name, double ns, size_t bytes = 0, double baselineNs = 0.0)
+	{
+		printf("%-40s %12.1f ns", name, ns);
+		if (bytes)
+			printf(" %8.2f GB/s", (double)bytes / ns);
+		if (baselineNs > 0.0)
+			printf(" %6.2fx", ns / baselineNs);
+		printf("\n");
+	}
+}
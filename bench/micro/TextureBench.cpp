@@ -0,0 +1,26 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "MicroBench.h"
+#include "Texture.h"
+
+// Box filter of one RGBA8 level against a memcpy of the source level.
+void RunTextureBench()
+{
+	constexpr uint32_t size = 2048;
+	std::vector<unsigned char> source(size * size * 4);
+	std::vector<unsigned char> copy(source.size());
+	std::vector<unsigned char> level(source.size() / 4);
+	for (size_t i = 0; i < source.size(); ++i)
+		source[i] = (unsigned char)(i * 31);
+
+	const double memcpyNs = microbench::Measure([&]() { memcpy(copy.data(), source.data(), source.size()); microbench::DoNotOptimize(copy.data()); });
+	microbench::Report("memcpy 2048x2048 rgba8", memcpyNs, source.size());
+	const double ns = microbench::Measure([&]()
+		{
+			vkmmc::io::DownsampleBox(source.data(), size, size, level.data(), 4);
+			microbench::DoNotOptimize(level.data());
+		});
+	microbench::Report("DownsampleBox 2048x2048 rgba8", ns, source.size(), memcpyNs);
+}
@@ -0,0 +1,52 @@
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "MicroBench.h"
+#include "WorkerPool.h"
+
+namespace
+{
+	// Iterations of one ParallelFor, about the job count of a recorded frame.
+	constexpr uint32_t JobCount = 64;
+	constexpr uint32_t MaxThreads = 8;
+
+	// Fixed cpu work per iteration, tens of microseconds like recording a secondary command buffer.
+	uint64_t Work(uint32_t seed)
+	{
+		uint64_t hash = seed * 0x9e3779b97f4a7c15ull;
+		for (uint32_t i = 0; i < 20000; ++i)
+			hash = (hash ^ (hash >> 29)) * 0xbf58476d1ce4e5b9ull + i;
+		return hash;
+	}
+}
+
+// ParallelFor scaling with the number of participating threads (caller plus workers).
+void RunWorkerPoolBench()
+{
+	std::vector<uint64_t> results(JobCount);
+	const double serialNs = microbench::Measure([&]()
+		{
+			for (uint32_t i = 0; i < JobCount; ++i)
+				results[i] = Work(i);
+			microbench::DoNotOptimize(results.data());
+		}, 1, 5);
+	microbench::Report("serial", serialNs);
+	printf("%u hardware threads\n", std::thread::hardware_concurrency());
+	for (uint32_t threads = 2; threads <= MaxThreads; threads *= 2)
+	{
+		vkmmc::WorkerPool pool;
+		pool.Init(threads - 1);
+		const double ns = microbench::Measure([&]()
+			{
+				pool.ParallelFor(JobCount, [&](uint32_t i) { results[i] = Work(i); });
+				microbench::DoNotOptimize(results.data());
+			}, 1, 5);
+		pool.Destroy();
+		char name[64];
+		snprintf(name, sizeof(name), "ParallelFor %u threads", threads);
+		microbench::Report(name, ns);
+		printf("%-40s %12.2fx speedup, %.0f%% efficiency\n", "", serialNs / ns, 100.0 * serialNs / ns / (double)threads);
+	}
+}
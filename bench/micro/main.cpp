@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <cstring>
+
+#include "MicroBench.h"
+
+// Suites, one per source file.
+void RunAccessorBench();
+void RunMemoryBench();
+void RunProfilerBench();
+void RunTextureBench();
+void RunWorkerPoolBench();
+
+struct Suite
+{
+	const char* Name;
+	void (*Run)();
+};
+
+static const Suite Suites[] =
+{
+	{ "accessor", &RunAccessorBench },
+	{ "memory", &RunMemoryBench },
+	{ "profiler", &RunProfilerBench },
+	{ "texture", &RunTextureBench },
+	{ "workers", &RunWorkerPoolBench },
+};
+
+int main(int argc, char** argv)
+{
+	// Run everything, or only the suites given by name.
+	bool found = argc < 2;
+	for (const Suite& suite : Suites)
+	{
+		bool run = argc < 2;
+		for (int i = 1; i < argc && !run; ++i)
+			run = !strcmp(argv[i], suite.Name);
+		if (!run)
+			continue;
+		found = true;
+		microbench::PrintHeader(suite.Name);
+		suite.Run();
+	}
+	if (!found)
+	{
+		printf("Usage: vkmmc_microbench [");
+		for (size_t i = 0; i < sizeof(Suites) / sizeof(Suites[0]); ++i)
+			printf("%s%s", i ? "|" : "", Suites[i].Name);
+		printf("]...\n");
+		return 1;
+	}
+	return 0;
+}
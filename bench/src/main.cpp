@@ -0,0 +1,123 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <vkmmc/RenderEngine.h>
+#include <vkmmc/Scene.h>
+#include <vkmmc/Camera.h>
+
+#include <glm/gtc/constants.hpp>
+
+// Command line of the benchmark.
+struct BenchSpecs
+{
+	const char* ScenePath = "../../assets/models/vulkanscene_shadow.gltf";
+	const char* MetricsFile = nullptr;
+	uint32_t Frames = 1000;
+	// Pipeline variants and streamed textures settle before the measured frames.
+	uint32_t WarmupFrames = 100;
+	uint32_t Width = 1920;
+	uint32_t Height = 1080;
+	bool Headless = true;
+};
+
+void PrintUsage()
+{
+	printf("Usage: vkmmc_bench [scene.gltf] [--frames N] [--warmup N] [--size W H] [--metrics file] [--window]\n");
+}
+
+bool ParseArgs(int32_t argc, char** argv, BenchSpecs& specs)
+{
+	for (int32_t i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (!strcmp(arg, "--frames") && hasValue)
+			specs.Frames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(arg, "--warmup") && hasValue)
+			specs.WarmupFrames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		else if (!strcmp(arg, "--size") && i + 2 < argc)
+		{
+			specs.Width = (uint32_t)strtoul(argv[++i], nullptr, 10);
+			specs.Height = (uint32_t)strtoul(argv[++i], nullptr, 10);
+		}
+		else if (!strcmp(arg, "--metrics") && hasValue)
+			specs.MetricsFile = argv[++i];
+		else if (!strcmp(arg, "--window"))
+			specs.Headless = false;
+		else if (arg[0] != '-')
+			specs.ScenePath = arg;
+		else
+			return false;
+	}
+	return specs.Frames > 0 && specs.Width > 0 && specs.Height > 0;
+}
+
+// Orbit around the scene origin, one turn over the whole run. Depends on the frame only, never on the clock.
+void UpdateCamera(vkmmc::Camera& camera, uint32_t frame, uint32_t frameCount)
+{
+	const float radius = 10.f;
+	const float height = 7.f;
+	const float angle = glm::two_pi<float>() * (float)frame / (float)frameCount;
+	camera.SetPosition({ radius * sinf(angle), height, radius * cosf(angle) });
+	// Yaw faces the origin, pitch looks down to it.
+	camera.SetRotation({ -atanf(height / radius), angle, 0.f });
+}
+
+int main(int32_t argc, char** argv)
+{
+	BenchSpecs specs;
+	if (!ParseArgs(argc, argv, specs))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	vkmmc::InitializationSpecs engineSpecs
+	{
+		specs.Width, specs.Height, "VkMMC Benchmark"
+	};
+	engineSpecs.Headless = specs.Headless;
+	engineSpecs.FrameStatsHistory = specs.Frames;
+	engineSpecs.FrameMetricsFile = specs.MetricsFile;
+	vkmmc::IRenderEngine* engine = vkmmc::IRenderEngine::MakeInstance();
+	if (!engine->Init(engineSpecs))
+	{
+		printf("Failed to initialize render engine.\n");
+		return 1;
+	}
+	vkmmc::IScene* scene = vkmmc::IScene::LoadScene(engine, specs.ScenePath);
+	engine->SetScene(scene);
+
+	vkmmc::Camera camera;
+	camera.SetAspectRatio((float)specs.Width / (float)specs.Height);
+	// Stats of a frame are recorded when the next one begins, the extra frame closes the last measured one.
+	const uint32_t frameCount = specs.WarmupFrames + specs.Frames + 1;
+	for (uint32_t i = 0; i < frameCount; ++i)
+	{
+		if (i == specs.WarmupFrames + 1)
+			engine->ResetFrameStats();
+		UpdateCamera(camera, i, frameCount);
+		engine->UpdateSceneView(camera.GetView(), camera.GetProjection());
+		if (!engine->RenderProcess())
+			break;
+	}
+
+	const vkmmc::FrameStatsSummary summary = engine->GetFrameStatsSummary();
+	printf("Scene:         %s\n", specs.ScenePath);
+	printf("Frames:        %u (%u warm up) at %ux%u%s\n", summary.FrameCount, specs.WarmupFrames,
+		specs.Width, specs.Height, specs.Headless ? ", headless" : "");
+	printf("Frame time:    avg %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+		summary.AverageMs, summary.P50Ms, summary.P95Ms, summary.P99Ms, summary.MaxMs);
+	printf("GPU time:      avg %.3f ms\n", summary.GpuAverageMs);
+	printf("Per frame:     %.1f draw calls, %.0f triangles, %.1f set bindings, %.1f buffer binds, %.2f KB uploaded\n",
+		summary.DrawCalls, summary.Triangles, summary.SetBindings, summary.BufferBinds, summary.UploadBytes / 1024.0);
+	printf("Device memory: %.2f MB\n", (double)summary.MemoryUsed / (1024.0 * 1024.0));
+
+	// Engine destroys the scene on shutdown.
+	engine->Shutdown();
+	vkmmc::IRenderEngine::FreeRenderEngine();
+	return 0;
+}
@@ -19,6 +19,32 @@ namespace vkmmc
 		uint32_t WindowWidth;
 		uint32_t WindowHeight;
 		char WindowTitle[32];
+		// Render to offscreen images without window nor present. Devices without surface support are valid.
+		bool Headless = false;
+		// Frames kept for the stats summary, engine default when 0.
+		uint32_t FrameStatsHistory = 0;
+		// Per frame metrics stream (.csv or JSON Lines), engine default when null.
+		const char* FrameMetricsFile = nullptr;
+	};
+
+	// Frame time percentiles and averages of the render stats over the last frames.
+	struct FrameStatsSummary
+	{
+		uint32_t FrameCount = 0;
+		double AverageMs = 0.0;
+		double P50Ms = 0.0;
+		double P95Ms = 0.0;
+		double P99Ms = 0.0;
+		double MaxMs = 0.0;
+		// Zero when the device has no timestamp support.
+		double GpuAverageMs = 0.0;
+		double DrawCalls = 0.0;
+		double Triangles = 0.0;
+		double SetBindings = 0.0;
+		double BufferBinds = 0.0;
+		double UploadBytes = 0.0;
+		// Device memory of live resources in the last frame.
+		uint64_t MemoryUsed = 0;
 	};
 
 	// Abstract class of main renderer
@@ -50,6 +76,10 @@ namespace vkmmc
 		virtual void SetAppEventCallback(std::function<void(void*)>&& fn) = 0;
 		virtual RenderHandle GetDefaultTexture() const = 0;
 		virtual Material GetDefaultMaterial() const = 0;
+
+		virtual FrameStatsSummary GetFrameStatsSummary() const = 0;
+		// Forget the frames recorded so far, e.g. to keep warm up frames out of the summary.
+		virtual void ResetFrameStats() = 0;
 	};
 
 }
\ No newline at end of file
@@ -2,7 +2,7 @@
 
 #include <cstdint>
 #include <type_traits>
-#include <xhash>
+#include <functional>
 
 
 namespace vkmmc
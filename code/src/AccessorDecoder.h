@@ -0,0 +1,73 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace vkmmc
+{
+	// Typed decoders of glTF accessor data. Independent from cgltf, the loader resolves the
+	// accessor layout and calls the instantiation for its component type.
+	namespace accessor
+	{
+		template <typename T, bool Normalized>
+		inline float DecodeComponent(T value)
+		{
+			if constexpr (std::is_floating_point_v<T> || !Normalized)
+				return (float)value;
+			else if constexpr (std::is_signed_v<T>)
+			{
+				// Signed normalized: max(c / MAX, -1.0) as specified by glTF.
+				const float v = (float)value * (1.f / (float)std::numeric_limits<T>::max());
+				return v < -1.f ? -1.f : v;
+			}
+			else
+				return (float)value * (1.f / (float)std::numeric_limits<T>::max());
+		}
+
+		// Convert elementCount elements of Count components from a strided source to a strided float destination.
+		// Count and component type are known at compile time so the inner loop gets fully unrolled
+		// and the conversion vectorized by the compiler.
+		template <typename T, uint32_t Count, bool Normalized>
+		void DecodeStrided(float* dst, size_t dstStride, const uint8_t* src, size_t srcStride, size_t elementCount)
+		{
+			uint8_t* dstBytes = reinterpret_cast<uint8_t*>(dst);
+			for (size_t i = 0; i < elementCount; ++i)
+			{
+				const T* s = reinterpret_cast<const T*>(src + i * srcStride);
+				float* d = reinterpret_cast<float*>(dstBytes + i * dstStride);
+				for (uint32_t c = 0; c < Count; ++c)
+					d[c] = DecodeComponent<T, Normalized>(s[c]);
+			}
+		}
+
+		template <typename T, uint32_t Count>
+		void DecodeStrided(float* dst, size_t dstStride, const uint8_t* src, size_t srcStride, size_t elementCount, bool normalized)
+		{
+			if (normalized)
+				DecodeStrided<T, Count, true>(dst, dstStride, src, srcStride, elementCount);
+			else
+				DecodeStrided<T, Count, false>(dst, dstStride, src, srcStride, elementCount);
+		}
+
+		// Widen indices to uint32 adding offset. Tightly packed uint32 without offset is a plain copy.
+		template <typename T>
+		void DecodeIndices(uint32_t* dst, const uint8_t* src, size_t srcStride, uint32_t indexCount, uint32_t offset)
+		{
+			if constexpr (std::is_same_v<T, uint32_t>)
+			{
+				if (srcStride == sizeof(uint32_t) && offset == 0)
+				{
+					memcpy(dst, src, indexCount * sizeof(uint32_t));
+					return;
+				}
+			}
+			for (uint32_t i = 0; i < indexCount; ++i)
+				dst[i] = (uint32_t)*reinterpret_cast<const T*>(src + i * srcStride) + offset;
+		}
+	}
+}
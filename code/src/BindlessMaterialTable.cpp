@@ -0,0 +1,242 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "BindlessMaterialTable.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "RenderContext.h"
+#include "Debug.h"
+#include <algorithm>
+
+namespace vkmmc
+{
+	bool BindlessMaterialTable::IsSupported(const RenderContext& renderContext)
+	{
+		return renderContext.DescriptorIndexing;
+	}
+
+	void BindlessMaterialTable::Init(const RenderContext& renderContext, TextureCache* cache, TextureStreamer* streamer)
+	{
+		check(IsSupported(renderContext) && m_layout == VK_NULL_HANDLE && cache);
+		m_cache = cache;
+		m_streamer = streamer;
+
+		// Leave room for the rest of the sampled images of the pipeline (shadow maps...).
+		const VkPhysicalDeviceLimits& limits = renderContext.GPUProperties.limits;
+		constexpr uint32_t reserved = 16;
+		m_textureCapacity = globals::MaxBindlessTextures;
+		m_textureCapacity = __min(m_textureCapacity, limits.maxPerStageDescriptorSamplers - reserved);
+		m_textureCapacity = __min(m_textureCapacity, limits.maxPerStageDescriptorSampledImages - reserved);
+		m_textureCapacity = __min(m_textureCapacity, limits.maxDescriptorSetSamplers - reserved);
+		m_textureCapacity = __min(m_textureCapacity, limits.maxDescriptorSetSampledImages - reserved);
+
+		// Layout
+		VkDescriptorSetLayoutBinding bindings[2];
+		bindings[0] = { .binding = 0, .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+			.descriptorCount = m_textureCapacity, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT, .pImmutableSamplers = nullptr };
+		bindings[1] = { .binding = 1, .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+			.descriptorCount = 1, .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT, .pImmutableSamplers = nullptr };
+		// Slots without texture are never accessed.
+		VkDescriptorBindingFlagsEXT bindingFlags[2] = { VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT, 0 };
+		VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT,
+			.pNext = nullptr,
+			.bindingCount = 2,
+			.pBindingFlags = bindingFlags
+		};
+		VkDescriptorSetLayoutCreateInfo layoutInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+			.pNext = &bindingFlagsInfo,
+			.flags = 0,
+			.bindingCount = 2,
+			.pBindings = bindings
+		};
+		vkcheck(vkCreateDescriptorSetLayout(renderContext.Device, &layoutInfo, nullptr, &m_layout));
+
+		// Pool and sets
+		VkDescriptorPoolSize poolSizes[2] =
+		{
+			{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_textureCapacity * globals::MaxOverlappedFrames },
+			{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, globals::MaxOverlappedFrames },
+		};
+		VkDescriptorPoolCreateInfo poolInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.maxSets = globals::MaxOverlappedFrames,
+			.poolSizeCount = 2,
+			.pPoolSizes = poolSizes
+		};
+		vkcheck(vkCreateDescriptorPool(renderContext.Device, &poolInfo, nullptr, &m_pool));
+		VkDescriptorSetLayout layouts[globals::MaxOverlappedFrames];
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+			layouts[i] = m_layout;
+		VkDescriptorSetAllocateInfo allocInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.descriptorPool = m_pool,
+			.descriptorSetCount = globals::MaxOverlappedFrames,
+			.pSetLayouts = layouts
+		};
+		vkcheck(vkAllocateDescriptorSets(renderContext.Device, &allocInfo, m_sets));
+
+		// Material buffer, shared by every frame. New materials are written in unused slots.
+		const VkDeviceSize bufferSize = globals::MaxBindlessMaterials * sizeof(BindlessMaterialData);
+		m_materialBuffer = Memory::CreateBuffer(renderContext.Allocator, bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, MEMORY_USAGE_CPU_TO_GPU);
+		VkDescriptorBufferInfo bufferInfo{ .buffer = m_materialBuffer.Buffer, .offset = 0, .range = bufferSize };
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+		{
+			VkWriteDescriptorSet write
+			{
+				.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+				.pNext = nullptr,
+				.dstSet = m_sets[i],
+				.dstBinding = 1,
+				.dstArrayElement = 0,
+				.descriptorCount = 1,
+				.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				.pBufferInfo = &bufferInfo
+			};
+			vkUpdateDescriptorSets(renderContext.Device, 1, &write, 0, nullptr);
+		}
+
+		SamplerBuilder builder;
+		builder.MaxAnisotropy = 16.f;
+		m_sampler = builder.Build(renderContext);
+		Logf(LogLevel::Ok, "Bindless material table created (%u textures, %u materials).\n", m_textureCapacity, globals::MaxBindlessMaterials);
+	}
+
+	void BindlessMaterialTable::Destroy(const RenderContext& renderContext)
+	{
+		if (m_layout == VK_NULL_HANDLE)
+			return;
+		m_sampler.Destroy(renderContext);
+		Memory::DestroyBuffer(renderContext.Allocator, m_materialBuffer);
+		vkDestroyDescriptorPool(renderContext.Device, m_pool, nullptr);
+		vkDestroyDescriptorSetLayout(renderContext.Device, m_layout, nullptr);
+		m_layout = VK_NULL_HANDLE;
+		m_pool = VK_NULL_HANDLE;
+		m_textureSlots.clear();
+		m_pendingWrites.clear();
+		m_retiredTextureSlots.clear();
+		m_retiredMaterialSlots.clear();
+	}
+
+	uint32_t BindlessMaterialTable::AddTexture(RenderHandle handle)
+	{
+		check(!m_textureSlots.contains(handle) && m_cache->Contains(handle));
+		uint32_t slot;
+		if (!m_freeTextureSlots.empty())
+		{
+			slot = m_freeTextureSlots.back();
+			m_freeTextureSlots.pop_back();
+		}
+		else
+		{
+			check(m_textureCount < m_textureCapacity && "Bindless texture array is full.");
+			slot = m_textureCount++;
+		}
+		m_textureSlots[handle] = slot;
+		m_pendingWrites.push_back({ slot, handle, (1 << globals::MaxOverlappedFrames) - 1 });
+		// Streamed textures update their slot when resident levels change.
+		if (m_streamer && m_streamer->IsStreamed(handle))
+			m_streamer->AddBinding(handle, m_sets, m_sampler.GetSampler(), 0, slot);
+		return slot;
+	}
+
+	void BindlessMaterialTable::RemoveTexture(RenderHandle handle)
+	{
+		auto it = m_textureSlots.find(handle);
+		if (it == m_textureSlots.end())
+			return;
+		// Descriptor keeps pointing to the old view, partially bound slots are fine while no material uses them.
+		// Frames in flight may still sample it, the slot is not reused until they are done.
+		m_retiredTextureSlots.push_back({ it->second, m_frame + globals::MaxOverlappedFrames });
+		m_textureSlots.erase(it);
+		m_pendingWrites.erase(std::remove_if(m_pendingWrites.begin(), m_pendingWrites.end(),
+			[handle](const PendingWrite& p) { return p.Texture == handle; }), m_pendingWrites.end());
+	}
+
+	uint32_t BindlessMaterialTable::GetTextureIndex(RenderHandle handle) const
+	{
+		auto it = m_textureSlots.find(handle);
+		return it != m_textureSlots.end() ? it->second : UINT32_MAX;
+	}
+
+	uint32_t BindlessMaterialTable::AddMaterial(const RenderContext& renderContext, const BindlessMaterialData& material)
+	{
+		uint32_t index;
+		if (!m_freeMaterialSlots.empty())
+		{
+			index = m_freeMaterialSlots.back();
+			m_freeMaterialSlots.pop_back();
+		}
+		else
+		{
+			check(m_materialCount < globals::MaxBindlessMaterials && "Bindless material buffer is full.");
+			index = m_materialCount++;
+		}
+		Memory::MemCopy(renderContext.Allocator, m_materialBuffer, &material, sizeof(BindlessMaterialData), index * sizeof(BindlessMaterialData));
+		return index;
+	}
+
+	void BindlessMaterialTable::RemoveMaterial(uint32_t index)
+	{
+		check(index < m_materialCount);
+		// Frames in flight may still read it, overwriting it now would change their draws.
+		m_retiredMaterialSlots.push_back({ index, m_frame + globals::MaxOverlappedFrames });
+	}
+
+	void BindlessMaterialTable::Update(const RenderContext& renderContext, uint32_t frameIndex)
+	{
+		++m_frame;
+		ReleaseRetiredSlots(m_retiredTextureSlots, m_freeTextureSlots);
+		ReleaseRetiredSlots(m_retiredMaterialSlots, m_freeMaterialSlots);
+
+		const uint32_t frameBit = 1 << frameIndex;
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		std::vector<VkWriteDescriptorSet> writes;
+		imageInfos.reserve(m_pendingWrites.size());
+		writes.reserve(m_pendingWrites.size());
+		for (PendingWrite& pending : m_pendingWrites)
+		{
+			if (!(pending.FrameMask & frameBit))
+				continue;
+			pending.FrameMask &= ~frameBit;
+			// Take the current texture, streamer may have replaced it since it was added.
+			const Texture* texture = m_cache->Get(pending.Texture);
+			check(texture);
+			imageInfos.push_back({ m_sampler.GetSampler(), texture->GetImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+			writes.push_back(
+				{
+					.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+					.pNext = nullptr,
+					.dstSet = m_sets[frameIndex],
+					.dstBinding = 0,
+					.dstArrayElement = pending.Slot,
+					.descriptorCount = 1,
+					.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+					.pImageInfo = &imageInfos.back()
+				});
+		}
+		if (!writes.empty())
+			vkUpdateDescriptorSets(renderContext.Device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+		m_pendingWrites.erase(std::remove_if(m_pendingWrites.begin(), m_pendingWrites.end(),
+			[](const PendingWrite& p) { return p.FrameMask == 0; }), m_pendingWrites.end());
+	}
+
+	void BindlessMaterialTable::ReleaseRetiredSlots(std::vector<RetiredSlot>& retired, std::vector<uint32_t>& freeSlots)
+	{
+		for (const RetiredSlot& slot : retired)
+		{
+			if (m_frame >= slot.Frame)
+				freeSlots.push_back(slot.Slot);
+		}
+		retired.erase(std::remove_if(retired.begin(), retired.end(),
+			[this](const RetiredSlot& slot) { return m_frame >= slot.Frame; }), retired.end());
+	}
+}
@@ -0,0 +1,91 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include "RenderHandle.h"
+#include "Texture.h"
+#include "Globals.h"
+#include <vector>
+#include <unordered_map>
+
+namespace vkmmc
+{
+	class TextureCache;
+	class TextureStreamer;
+
+	// Material parameters in the storage buffer (std430).
+	struct BindlessMaterialData
+	{
+		uint32_t DiffuseTexture;
+		uint32_t NormalTexture;
+		uint32_t SpecularTexture;
+		uint32_t Padding;
+	};
+
+	/**
+	 * Every texture in one partially bound array and material parameters in a storage buffer indexed by material.
+	 * One descriptor set per frame slot. New textures are written in each set at the beginning of the frame,
+	 * when the slot is not in use by the gpu.
+	 * Requires VK_EXT_descriptor_indexing (runtimeDescriptorArray and descriptorBindingPartiallyBound).
+	 */
+	class BindlessMaterialTable
+	{
+		struct PendingWrite
+		{
+			uint32_t Slot;
+			RenderHandle Texture;
+			uint32_t FrameMask;
+		};
+		// Removed slot, reused once the frames that could still read it are done.
+		struct RetiredSlot
+		{
+			uint32_t Slot;
+			uint32_t Frame;
+		};
+	public:
+		static bool IsSupported(const RenderContext& renderContext);
+
+		void Init(const RenderContext& renderContext, TextureCache* cache, TextureStreamer* streamer);
+		void Destroy(const RenderContext& renderContext);
+		bool IsInitialized() const { return m_layout != VK_NULL_HANDLE; }
+
+		// Texture must be owned by the texture cache, image view is taken from there when the descriptor is written.
+		uint32_t AddTexture(RenderHandle handle);
+		void RemoveTexture(RenderHandle handle);
+		uint32_t GetTextureIndex(RenderHandle handle) const;
+
+		uint32_t AddMaterial(const RenderContext& renderContext, const BindlessMaterialData& material);
+		void RemoveMaterial(uint32_t index);
+
+		// Flush pending descriptor writes of the frame slot and release retired slots.
+		// Call once per frame, when the frame slot is not in use by the gpu.
+		void Update(const RenderContext& renderContext, uint32_t frameIndex);
+
+		VkDescriptorSetLayout GetLayout() const { return m_layout; }
+		VkDescriptorSet GetSet(uint32_t frameIndex) const { return m_sets[frameIndex]; }
+
+	private:
+		void ReleaseRetiredSlots(std::vector<RetiredSlot>& retired, std::vector<uint32_t>& freeSlots);
+
+		VkDescriptorSetLayout m_layout{ VK_NULL_HANDLE };
+		VkDescriptorPool m_pool{ VK_NULL_HANDLE };
+		VkDescriptorSet m_sets[globals::MaxOverlappedFrames]{ VK_NULL_HANDLE };
+		Sampler m_sampler;
+		AllocatedBuffer m_materialBuffer;
+		TextureCache* m_cache{ nullptr };
+		TextureStreamer* m_streamer{ nullptr };
+
+		uint32_t m_textureCapacity{ 0 };
+		uint32_t m_textureCount{ 0 };
+		std::vector<uint32_t> m_freeTextureSlots;
+		std::unordered_map<RenderHandle, uint32_t, RenderHandle::Hasher> m_textureSlots;
+		std::vector<PendingWrite> m_pendingWrites;
+		std::vector<RetiredSlot> m_retiredTextureSlots;
+
+		uint32_t m_materialCount{ 0 };
+		std::vector<uint32_t> m_freeMaterialSlots;
+		std::vector<RetiredSlot> m_retiredMaterialSlots;
+		uint32_t m_frame{ 0 };
+	};
+}
@@ -0,0 +1,213 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "CpuProfiler.h"
+#include "WorkerPool.h"
+#include "Globals.h"
+#include "Debug.h"
+#include <cstdio>
+#include <imgui/imgui.h>
+
+namespace vkmmc
+{
+	CpuProfiler GCpuProfiler;
+
+	ProfileZone::ProfileZone(const char* name, const char* file, uint32_t line, bool counter)
+		: Name(name), File(file), Line(line), Counter(counter), Id(0)
+	{
+		GCpuProfiler.RegisterZone(this);
+	}
+
+	CpuProfiler::CpuProfiler()
+		: m_microsecondsPerTick(0.0),
+		m_frameMilliseconds(0.0),
+		m_frameNumber(0),
+		m_captureFrames(0),
+		m_captureFramesLeft(0),
+		m_imguiCaptureFrames(60)
+	{
+		m_baseTime = std::chrono::steady_clock::now();
+		m_baseTick = Now();
+		m_frameStartTick = m_baseTick;
+#if !VKMMC_PROFILER_RDTSC
+		m_microsecondsPerTick = (double)std::chrono::steady_clock::period::num * 1e6 / (double)std::chrono::steady_clock::period::den;
+#endif
+	}
+
+	void CpuProfiler::RegisterZone(ProfileZone* zone)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		zone->Id = (uint32_t)m_zones.size();
+		m_zones.push_back(zone);
+	}
+
+	CpuProfiler::ThreadEvents* CpuProfiler::CreateThreadEvents()
+	{
+		std::unique_ptr<ThreadEvents> thread = std::make_unique<ThreadEvents>();
+		const uint32_t poolIndex = WorkerPool::GetThreadIndex();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		thread->ThreadId = (uint32_t)m_threads.size();
+		if (poolIndex)
+			sprintf_s(thread->Name, "Worker %u", poolIndex - 1);
+		else
+			sprintf_s(thread->Name, "Thread %u", thread->ThreadId);
+		m_threads.push_back(std::move(thread));
+		return m_threads.back().get();
+	}
+
+	bool CpuProfiler::CollectEvents(std::vector<uint64_t>& heads, std::vector<ProfileEvent>& events) const
+	{
+		bool complete = true;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		heads.resize(m_threads.size(), 0);
+		for (size_t i = 0; i < m_threads.size(); ++i)
+		{
+			const ThreadEvents& thread = *m_threads[i];
+			uint64_t first = heads[i];
+			const uint64_t last = thread.Head.load(std::memory_order_acquire);
+			if (last - first > ThreadEventCapacity)
+			{
+				first = last - ThreadEventCapacity;
+				complete = false;
+			}
+			const size_t offset = events.size();
+			for (uint64_t j = first; j < last; ++j)
+			{
+				const ProfileEventSlot& slot = thread.Events[j & (ThreadEventCapacity - 1)];
+				events.push_back({ slot.Zone.load(std::memory_order_relaxed), slot.Start.load(std::memory_order_relaxed),
+					slot.End.load(std::memory_order_relaxed), slot.Depth.load(std::memory_order_relaxed), thread.ThreadId });
+			}
+			// The owner thread keeps writing, drop the events it overwrote while we were copying. The slot of
+			// event j is being rewritten as soon as the head reaches j + ThreadEventCapacity.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			const uint64_t head = thread.Head.load(std::memory_order_relaxed);
+			if (head - first >= ThreadEventCapacity)
+			{
+				const uint64_t overwritten = __min(head - first - ThreadEventCapacity + 1, last - first);
+				events.erase(events.begin() + offset, events.begin() + offset + (size_t)overwritten);
+				complete = false;
+			}
+			heads[i] = last;
+		}
+		return complete;
+	}
+
+	void CpuProfiler::NewFrame()
+	{
+		static ProfileZone frameZone("Frame", __FILE__, __LINE__);
+		const uint64_t now = Now();
+		Record(GetThreadEvents(), &frameZone, m_frameStartTick, now, 0);
+#if VKMMC_PROFILER_RDTSC
+		// Longer intervals give better precision, the calibration converges as the app runs.
+		const double elapsedUs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_baseTime).count() * 1e-3;
+		if (now > m_baseTick)
+			m_microsecondsPerTick = elapsedUs / (double)(now - m_baseTick);
+#endif
+		m_frameMilliseconds = TicksToMicroseconds(now - m_frameStartTick) * 1e-3;
+		m_frameStartTick = now;
+		++m_frameNumber;
+
+		// Aggregate the frame that just ended.
+		std::vector<ProfileEvent> events;
+		CollectEvents(m_frameHeads, events);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_frameStats.resize(m_zones.size());
+			for (size_t i = 0; i < m_zones.size(); ++i)
+			{
+				ZoneStats& stats = m_frameStats[i];
+				stats.Zone = m_zones[i];
+				stats.Milliseconds = 0.0;
+				stats.Calls = 0;
+			}
+		}
+		for (const ProfileEvent& event : events)
+		{
+			ZoneStats& stats = m_frameStats[event.Zone->Id];
+			if (event.Zone->Counter)
+				stats.Value = event.End;
+			else
+			{
+				stats.Milliseconds += TicksToMicroseconds(event.End - event.Start) * 1e-3;
+				++stats.Calls;
+			}
+			stats.Depth = event.Depth;
+		}
+
+		if (m_captureFrames)
+		{
+			if (!m_captureFramesLeft)
+			{
+				// Capture starts with the frame beginning now.
+				m_captureHeads = m_frameHeads;
+				m_captureFramesLeft = m_captureFrames;
+			}
+			else if (!--m_captureFramesLeft)
+			{
+				std::vector<ProfileEvent> captureEvents;
+				if (!CollectEvents(m_captureHeads, captureEvents))
+					Logf(LogLevel::Warn, "Profiler ring buffers overflowed, trace of %u frames is incomplete.\n", m_captureFrames);
+				WriteTrace(m_captureFile.c_str(), captureEvents);
+				m_captureFrames = 0;
+			}
+		}
+	}
+
+	void CpuProfiler::RequestCapture(uint32_t frameCount, const char* filepath)
+	{
+		check(filepath);
+		if (m_captureFrames || !frameCount)
+			return;
+		m_captureFile = filepath;
+		m_captureFrames = frameCount;
+		m_captureFramesLeft = 0;
+	}
+
+	bool CpuProfiler::WriteTrace(const char* filepath, const std::vector<ProfileEvent>& events) const
+	{
+		FILE* file = nullptr;
+		if (fopen_s(&file, filepath, "w") || !file)
+		{
+			Logf(LogLevel::Error, "Failed to open %s to write profiler trace.\n", filepath);
+			return false;
+		}
+		fprintf_s(file, "{\n\t\"displayTimeUnit\": \"ms\",\n\t\"traceEvents\": [\n");
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (size_t i = 0; i < m_threads.size(); ++i)
+			{
+				fprintf_s(file, "%s\t\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %u, \"args\": { \"name\": \"%s\" } }",
+					i ? ",\n" : "", m_threads[i]->ThreadId, m_threads[i]->Name);
+			}
+		}
+		for (const ProfileEvent& event : events)
+		{
+			const double start = TicksToMicroseconds(event.Start - m_baseTick);
+			if (event.Zone->Counter)
+			{
+				fprintf_s(file, ",\n\t\t{ \"name\": \"%s\", \"ph\": \"C\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"args\": { \"value\": %llu } }",
+					event.Zone->Name, event.ThreadId, start, (unsigned long long)event.End);
+			}
+			else
+			{
+				fprintf_s(file, ",\n\t\t{ \"name\": \"%s\", \"cat\": \"cpu\", \"ph\": \"X\", \"pid\": 0, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f }",
+					event.Zone->Name, event.ThreadId, start, TicksToMicroseconds(event.End - event.Start));
+			}
+		}
+		fprintf_s(file, "\n\t]\n}\n");
+		fclose(file);
+		Logf(LogLevel::Ok, "Profiler trace with %zu events written to %s.\n", events.size(), filepath);
+		return true;
+	}
+
+	void CpuProfiler::ImGuiDraw()
+	{
+		ImGui::Begin("Profiler");
+		ImGui::SliderInt("Frames", &m_imguiCaptureFrames, 1, 600);
+		if (IsCapturing())
+			ImGui::Text("Capturing %u frames...", m_captureFrames);
+		else if (ImGui::Button("Capture trace"))
+			RequestCapture((uint32_t)m_imguiCaptureFrames, globals::CpuTraceFile);
+		ImGui::End();
+	}
+}
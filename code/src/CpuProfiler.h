@@ -0,0 +1,219 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+
+// Zones and counters compile out when disabled.
+#ifndef VKMMC_PROFILING
+#define VKMMC_PROFILING 1
+#endif
+
+namespace vkmmc
+{
+	// Static descriptor of a profiled scope or counter, registered in the profiler on first use.
+	struct ProfileZone
+	{
+		ProfileZone(const char* name, const char* file, uint32_t line, bool counter = false);
+
+		const char* Name;
+		const char* File;
+		uint32_t Line;
+		bool Counter;
+		// Index in the profiler zone array.
+		uint32_t Id;
+	};
+
+	struct ProfileEvent
+	{
+		const ProfileZone* Zone;
+		uint64_t Start;
+		// End tick for zones, value for counters.
+		uint64_t End;
+		uint32_t Depth;
+		uint32_t ThreadId;
+	};
+
+	// Event in a thread ring buffer. Atomic fields, the main thread reads them while the owner may be overwriting
+	// them. Relaxed accesses compile to plain loads and stores.
+	struct ProfileEventSlot
+	{
+		std::atomic<const ProfileZone*> Zone;
+		std::atomic<uint64_t> Start;
+		std::atomic<uint64_t> End;
+		std::atomic<uint32_t> Depth;
+	};
+
+	/**
+	 * Hierarchical CPU profiler. Every thread writes its zones in its own ring buffer without locks, the main
+	 * thread aggregates the zones of the last frame and exports captures of several frames as Chrome trace JSON
+	 * (chrome://tracing, ui.perfetto.dev).
+	 */
+	class CpuProfiler
+	{
+	public:
+		// Events per thread, power of two.
+		static constexpr uint32_t ThreadEventCapacity = 1 << 15;
+
+		struct ThreadEvents
+		{
+			uint32_t ThreadId;
+			char Name[32];
+			// Events written, the event i is in Events[i % ThreadEventCapacity]. Written by the owner thread only.
+			std::atomic<uint64_t> Head{ 0 };
+			ProfileEventSlot Events[ThreadEventCapacity];
+			// Nesting of the open zones.
+			uint32_t Depth{ 0 };
+		};
+
+		struct ZoneStats
+		{
+			const ProfileZone* Zone;
+			// Zones: sum of the last frame from every thread. Counters: last value.
+			double Milliseconds;
+			uint64_t Value;
+			uint32_t Calls;
+			uint32_t Depth;
+		};
+
+		CpuProfiler();
+
+		static inline uint64_t Now();
+		inline ThreadEvents* GetThreadEvents();
+		static inline void Record(ThreadEvents* thread, const ProfileZone* zone, uint64_t start, uint64_t end, uint32_t depth);
+
+		// Main thread, at the start of each frame. Aggregates the frame that just ended and writes pending captures.
+		void NewFrame();
+		// Export the next frameCount frames to filepath.
+		void RequestCapture(uint32_t frameCount, const char* filepath);
+		inline bool IsCapturing() const { return m_captureFrames > 0; }
+
+		void RegisterZone(ProfileZone* zone);
+		// Stats of the last frame, only valid in the main thread.
+		const std::vector<ZoneStats>& GetFrameStats() const { return m_frameStats; }
+		double GetFrameMilliseconds() const { return m_frameMilliseconds; }
+		double TicksToMicroseconds(uint64_t ticks) const { return (double)ticks * m_microsecondsPerTick; }
+
+		void ImGuiDraw();
+
+	private:
+		ThreadEvents* CreateThreadEvents();
+		// Events of every thread written since heads, heads moved to the last event read.
+		// False if a thread overwrote part of them before they were read, those are dropped.
+		bool CollectEvents(std::vector<uint64_t>& heads, std::vector<ProfileEvent>& events) const;
+		bool WriteTrace(const char* filepath, const std::vector<ProfileEvent>& events) const;
+
+		// Calibrated against steady_clock every frame.
+		double m_microsecondsPerTick;
+		uint64_t m_baseTick;
+		std::chrono::steady_clock::time_point m_baseTime;
+		std::vector<std::unique_ptr<ThreadEvents>> m_threads;
+		std::vector<ProfileZone*> m_zones;
+		mutable std::mutex m_mutex;
+
+		// Main thread state
+		uint64_t m_frameStartTick;
+		std::vector<uint64_t> m_frameHeads;
+		std::vector<ZoneStats> m_frameStats;
+		double m_frameMilliseconds;
+		uint32_t m_frameNumber;
+		std::vector<uint64_t> m_captureHeads;
+		std::string m_captureFile;
+		// Frames requested, 0 without capture. Frames left is 0 until the capture starts in the next frame.
+		uint32_t m_captureFrames;
+		uint32_t m_captureFramesLeft;
+		int m_imguiCaptureFrames;
+	};
+	extern CpuProfiler GCpuProfiler;
+
+	// Zone open until the end of the C++ scope.
+	struct ProfileScope
+	{
+		inline ProfileScope(const ProfileZone* zone);
+		inline ~ProfileScope();
+
+		const ProfileZone* m_zone;
+		CpuProfiler::ThreadEvents* m_thread;
+		uint64_t m_start;
+	};
+}
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define VKMMC_PROFILER_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define VKMMC_PROFILER_RDTSC 1
+#else
+#define VKMMC_PROFILER_RDTSC 0
+#endif
+
+namespace vkmmc
+{
+	inline uint64_t CpuProfiler::Now()
+	{
+#if VKMMC_PROFILER_RDTSC
+		return __rdtsc();
+#else
+		return (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	inline CpuProfiler::ThreadEvents* CpuProfiler::GetThreadEvents()
+	{
+		thread_local ThreadEvents* threadEvents = nullptr;
+		if (!threadEvents)
+			threadEvents = CreateThreadEvents();
+		return threadEvents;
+	}
+
+	inline void CpuProfiler::Record(ThreadEvents* thread, const ProfileZone* zone, uint64_t start, uint64_t end, uint32_t depth)
+	{
+		const uint64_t head = thread->Head.load(std::memory_order_relaxed);
+		// A reader that sees any field of this event also sees the head of the previous one, and knows the slot
+		// may be overwritten (pairs with the acquire fence in CollectEvents). Compiler barrier only on x86.
+		std::atomic_thread_fence(std::memory_order_release);
+		ProfileEventSlot& slot = thread->Events[head & (ThreadEventCapacity - 1)];
+		slot.Zone.store(zone, std::memory_order_relaxed);
+		slot.Start.store(start, std::memory_order_relaxed);
+		slot.End.store(end, std::memory_order_relaxed);
+		slot.Depth.store(depth, std::memory_order_relaxed);
+		// Readers see the event complete once the head moves past it.
+		thread->Head.store(head + 1, std::memory_order_release);
+	}
+
+	inline ProfileScope::ProfileScope(const ProfileZone* zone)
+		: m_zone(zone), m_thread(GCpuProfiler.GetThreadEvents())
+	{
+		++m_thread->Depth;
+		m_start = CpuProfiler::Now();
+	}
+
+	inline ProfileScope::~ProfileScope()
+	{
+		const uint64_t end = CpuProfiler::Now();
+		CpuProfiler::Record(m_thread, m_zone, m_start, end, --m_thread->Depth);
+	}
+}
+
+#if VKMMC_PROFILING
+#define PROFILE_SCOPE(name) \
+	static vkmmc::ProfileZone __profileZone##name(#name, __FILE__, __LINE__); \
+	vkmmc::ProfileScope __profileScope##name(&__profileZone##name)
+#define PROFILE_COUNTER(name, value) \
+	do { \
+		static vkmmc::ProfileZone __profileCounter##name(#name, __FILE__, __LINE__, true); \
+		const uint64_t __profileNow = vkmmc::CpuProfiler::Now(); \
+		vkmmc::CpuProfiler::Record(vkmmc::GCpuProfiler.GetThreadEvents(), &__profileCounter##name, __profileNow, (uint64_t)(value), 0); \
+	} while (0)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+#endif
@@ -2,11 +2,14 @@
 #include "Debug.h"
 #include "Logger.h"
 
-#include <Windows.h>
+#include <cstdlib>
 #include <string>
-#include <DbgHelp.h>
 #include "imgui.h"
 
+#ifdef _WIN32
+#include <Windows.h>
+#include <DbgHelp.h>
+
 #pragma comment(lib,"Dbghelp.lib")
 
 namespace win
@@ -117,6 +120,7 @@ namespace win
 		vkmmc::Log(vkmmc::LogLevel::Debug, "\n=================================================\n\n");
 	}
 }
+#endif
 
 void vkmmc_debug::PrintCallstack(size_t count, size_t offset)
 {
@@ -0,0 +1,420 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "DeviceMemoryAllocator.h"
+#include "Debug.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace vkmmc
+{
+	// Blocks of big heaps. Small heaps (resizable bar...) use an eighth of the heap.
+	constexpr VkDeviceSize DefaultBlockSize = 256ull * 1024 * 1024;
+	constexpr VkDeviceSize SmallHeapSize = 1024ull * 1024 * 1024;
+
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+	}
+
+	static VkDeviceSize AlignDown(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return alignment > 1 ? value / alignment * alignment : value;
+	}
+
+	void MemoryBlock::Init(VkDeviceMemory memory, VkDeviceSize size, uint32_t poolIndex, void* mapped)
+	{
+		m_memory = memory;
+		m_mapped = mapped;
+		m_size = size;
+		m_poolIndex = poolIndex;
+		m_firstLevelBitmap = 0;
+		memset(m_secondLevelBitmap, 0, sizeof(m_secondLevelBitmap));
+		for (uint32_t i = 0; i < FirstLevelCount; ++i)
+			for (uint32_t j = 0; j < SecondLevelCount; ++j)
+				m_heads[i][j] = InvalidNode;
+		// Whole block free.
+		uint32_t node = NewNode();
+		m_nodes[node] = { 0, size, InvalidNode, InvalidNode, InvalidNode, InvalidNode, true };
+		InsertFree(node);
+	}
+
+	void MemoryBlock::Mapping(VkDeviceSize size, uint32_t& fl, uint32_t& sl)
+	{
+		check(size > 0);
+		const uint32_t msb = (uint32_t)std::bit_width(size) - 1;
+		if (msb < SecondLevelLog2)
+		{
+			// Small sizes, linear bins in first level 0.
+			fl = 0;
+			sl = (uint32_t)size;
+		}
+		else
+		{
+			fl = msb - SecondLevelLog2 + 1;
+			sl = (uint32_t)(size >> (msb - SecondLevelLog2)) & (SecondLevelCount - 1);
+		}
+	}
+
+	bool MemoryBlock::Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& node)
+	{
+		check(size > 0);
+		// Any range in the bin found is big enough for the size plus the worst alignment padding.
+		VkDeviceSize searchSize = size + (alignment > 1 ? alignment - 1 : 0);
+		const uint32_t msb = (uint32_t)std::bit_width(searchSize) - 1;
+		if (msb >= SecondLevelLog2)
+			searchSize += (1ull << (msb - SecondLevelLog2)) - 1;
+		if (searchSize > m_size)
+			return false;
+		uint32_t fl, sl;
+		Mapping(searchSize, fl, sl);
+
+		uint32_t slMap = m_secondLevelBitmap[fl] & (~0u << sl);
+		if (!slMap)
+		{
+			const uint64_t flMap = fl + 1 < 64 ? m_firstLevelBitmap & (~0ull << (fl + 1)) : 0;
+			if (!flMap)
+				return false;
+			fl = (uint32_t)std::countr_zero(flMap);
+			slMap = m_secondLevelBitmap[fl];
+			check(slMap);
+		}
+		sl = (uint32_t)std::countr_zero(slMap);
+		node = m_heads[fl][sl];
+		check(node != InvalidNode);
+		RemoveFree(node);
+
+		// Front padding stays as a free range. Previous range is always in use (free ranges are merged).
+		const VkDeviceSize alignedOffset = AlignUp(m_nodes[node].Offset, alignment);
+		const VkDeviceSize padding = alignedOffset - m_nodes[node].Offset;
+		if (padding > 0)
+		{
+			uint32_t front = NewNode();
+			Node& n = m_nodes[node];
+			m_nodes[front] = { n.Offset, padding, n.PrevPhysical, node, InvalidNode, InvalidNode, true };
+			if (n.PrevPhysical != InvalidNode)
+				m_nodes[n.PrevPhysical].NextPhysical = front;
+			n.PrevPhysical = front;
+			n.Offset = alignedOffset;
+			n.Size -= padding;
+			InsertFree(front);
+		}
+		check(m_nodes[node].Size >= size);
+
+		// Split the tail if it is worth it. Next range is always in use.
+		if (m_nodes[node].Size - size >= MinSplitSize)
+		{
+			uint32_t back = NewNode();
+			Node& n = m_nodes[node];
+			m_nodes[back] = { n.Offset + size, n.Size - size, node, n.NextPhysical, InvalidNode, InvalidNode, true };
+			if (n.NextPhysical != InvalidNode)
+				m_nodes[n.NextPhysical].PrevPhysical = back;
+			n.NextPhysical = back;
+			n.Size = size;
+			InsertFree(back);
+		}
+
+		m_nodes[node].Free = false;
+		offset = m_nodes[node].Offset;
+		++m_allocationCount;
+		m_usedSize += m_nodes[node].Size;
+		return true;
+	}
+
+	void MemoryBlock::Free(uint32_t node)
+	{
+		check(node < (uint32_t)m_nodes.size() && !m_nodes[node].Free);
+		--m_allocationCount;
+		m_usedSize -= m_nodes[node].Size;
+		m_nodes[node].Free = true;
+
+		// Merge with previous range
+		uint32_t prev = m_nodes[node].PrevPhysical;
+		if (prev != InvalidNode && m_nodes[prev].Free)
+		{
+			RemoveFree(prev);
+			Node& p = m_nodes[prev];
+			p.Size += m_nodes[node].Size;
+			p.NextPhysical = m_nodes[node].NextPhysical;
+			if (p.NextPhysical != InvalidNode)
+				m_nodes[p.NextPhysical].PrevPhysical = prev;
+			m_unusedNodes.push_back(node);
+			node = prev;
+		}
+		// Merge with next range
+		uint32_t next = m_nodes[node].NextPhysical;
+		if (next != InvalidNode && m_nodes[next].Free)
+		{
+			RemoveFree(next);
+			Node& n = m_nodes[node];
+			n.Size += m_nodes[next].Size;
+			n.NextPhysical = m_nodes[next].NextPhysical;
+			if (n.NextPhysical != InvalidNode)
+				m_nodes[n.NextPhysical].PrevPhysical = node;
+			m_unusedNodes.push_back(next);
+		}
+		InsertFree(node);
+	}
+
+	VkDeviceSize MemoryBlock::GetLargestFreeRange() const
+	{
+		if (!m_firstLevelBitmap)
+			return 0;
+		// Ranges are not sorted inside a bin, check the whole highest one.
+		const uint32_t fl = 63 - (uint32_t)std::countl_zero(m_firstLevelBitmap);
+		const uint32_t sl = 31 - (uint32_t)std::countl_zero(m_secondLevelBitmap[fl]);
+		VkDeviceSize largest = 0;
+		for (uint32_t node = m_heads[fl][sl]; node != InvalidNode; node = m_nodes[node].NextFree)
+			largest = __max(largest, m_nodes[node].Size);
+		return largest;
+	}
+
+	uint32_t MemoryBlock::NewNode()
+	{
+		if (!m_unusedNodes.empty())
+		{
+			uint32_t node = m_unusedNodes.back();
+			m_unusedNodes.pop_back();
+			return node;
+		}
+		m_nodes.push_back({});
+		return (uint32_t)m_nodes.size() - 1;
+	}
+
+	void MemoryBlock::InsertFree(uint32_t node)
+	{
+		uint32_t fl, sl;
+		Mapping(m_nodes[node].Size, fl, sl);
+		Node& n = m_nodes[node];
+		n.PrevFree = InvalidNode;
+		n.NextFree = m_heads[fl][sl];
+		if (n.NextFree != InvalidNode)
+			m_nodes[n.NextFree].PrevFree = node;
+		m_heads[fl][sl] = node;
+		m_firstLevelBitmap |= 1ull << fl;
+		m_secondLevelBitmap[fl] |= 1u << sl;
+	}
+
+	void MemoryBlock::RemoveFree(uint32_t node)
+	{
+		uint32_t fl, sl;
+		Mapping(m_nodes[node].Size, fl, sl);
+		Node& n = m_nodes[node];
+		if (n.PrevFree != InvalidNode)
+			m_nodes[n.PrevFree].NextFree = n.NextFree;
+		else
+			m_heads[fl][sl] = n.NextFree;
+		if (n.NextFree != InvalidNode)
+			m_nodes[n.NextFree].PrevFree = n.PrevFree;
+		if (m_heads[fl][sl] == InvalidNode)
+		{
+			m_secondLevelBitmap[fl] &= ~(1u << sl);
+			if (!m_secondLevelBitmap[fl])
+				m_firstLevelBitmap &= ~(1ull << fl);
+		}
+		n.PrevFree = InvalidNode;
+		n.NextFree = InvalidNode;
+	}
+
+	void DeviceMemoryAllocator::Init(VkDevice device, VkPhysicalDevice physicalDevice)
+	{
+		m_device = device;
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		m_bufferImageGranularity = properties.limits.bufferImageGranularity;
+		m_nonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+		m_pools.resize(m_memoryProperties.memoryTypeCount * 2);
+		m_dedicatedCounts.resize(m_memoryProperties.memoryTypeCount, 0);
+		m_dedicatedSizes.resize(m_memoryProperties.memoryTypeCount, 0);
+	}
+
+	void DeviceMemoryAllocator::Destroy()
+	{
+		DeviceMemoryStats stats = GetStats();
+		if (stats.AllocationCount || stats.DedicatedAllocationCount)
+			Logf(LogLevel::Warn, "Device memory allocator destroyed with %u allocations alive (%u dedicated).\n",
+				stats.AllocationCount, stats.DedicatedAllocationCount);
+		for (std::vector<MemoryBlock*>& pool : m_pools)
+		{
+			for (MemoryBlock* block : pool)
+			{
+				if (block->GetMapped())
+					vkUnmapMemory(m_device, block->GetMemory());
+				vkFreeMemory(m_device, block->GetMemory(), nullptr);
+				delete block;
+			}
+			pool.clear();
+		}
+	}
+
+	VkDeviceSize DeviceMemoryAllocator::GetBlockSize(uint32_t memoryType) const
+	{
+		const VkMemoryHeap& heap = m_memoryProperties.memoryHeaps[m_memoryProperties.memoryTypes[memoryType].heapIndex];
+		return heap.size <= SmallHeapSize ? AlignUp(heap.size / 8, 1024) : DefaultBlockSize;
+	}
+
+	uint32_t DeviceMemoryAllocator::GetPoolIndex(uint32_t memoryType, EResourceType resourceType) const
+	{
+		// Without granularity restrictions every resource can share the same blocks.
+		if (m_bufferImageGranularity <= 1)
+			resourceType = RESOURCE_LINEAR;
+		return memoryType * 2 + (uint32_t)resourceType;
+	}
+
+	DeviceMemoryAllocator::Result DeviceMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, uint32_t memoryType, EResourceType resourceType, bool preferDedicated,
+		VkBuffer dedicatedBuffer, VkImage dedicatedImage)
+	{
+		check(memoryType < m_memoryProperties.memoryTypeCount);
+		const bool hostVisible = m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+		Result result;
+		result.MemoryType = memoryType;
+		const VkDeviceSize blockSize = GetBlockSize(memoryType);
+		if (!preferDedicated && requirements.size <= blockSize / 2)
+		{
+			const uint32_t poolIndex = GetPoolIndex(memoryType, resourceType);
+			const VkDeviceSize alignment = requirements.alignment;
+			std::vector<MemoryBlock*>& pool = m_pools[poolIndex];
+			for (MemoryBlock* block : pool)
+			{
+				if (block->Allocate(requirements.size, alignment, result.Offset, result.Node))
+				{
+					result.Block = block;
+					break;
+				}
+			}
+			if (!result.Block)
+			{
+				VkMemoryAllocateInfo allocInfo{ .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, .pNext = nullptr };
+				allocInfo.allocationSize = blockSize;
+				allocInfo.memoryTypeIndex = memoryType;
+				VkDeviceMemory memory;
+				if (vkAllocateMemory(m_device, &allocInfo, nullptr, &memory) == VK_SUCCESS)
+				{
+					void* mapped = nullptr;
+					if (hostVisible)
+						vkcheck(vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &mapped));
+					MemoryBlock* block = new MemoryBlock();
+					block->Init(memory, blockSize, poolIndex, mapped);
+					pool.push_back(block);
+					check(block->Allocate(requirements.size, alignment, result.Offset, result.Node));
+					result.Block = block;
+				}
+				else
+				{
+					Logf(LogLevel::Warn, "Failed to allocate memory block of %llu bytes, trying dedicated allocation.\n", blockSize);
+				}
+			}
+			if (result.Block)
+			{
+				result.Memory = result.Block->GetMemory();
+				result.Size = requirements.size;
+				if (result.Block->GetMapped())
+					result.Mapped = static_cast<char*>(result.Block->GetMapped()) + result.Offset;
+				return result;
+			}
+		}
+
+		// Dedicated allocation
+		VkMemoryDedicatedAllocateInfo dedicatedInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO,
+			.pNext = nullptr,
+			.image = dedicatedImage,
+			.buffer = dedicatedBuffer
+		};
+		VkMemoryAllocateInfo allocInfo{ .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, .pNext = &dedicatedInfo };
+		allocInfo.allocationSize = requirements.size;
+		allocInfo.memoryTypeIndex = memoryType;
+		vkcheck(vkAllocateMemory(m_device, &allocInfo, nullptr, &result.Memory));
+		result.Size = requirements.size;
+		if (hostVisible)
+			vkcheck(vkMapMemory(m_device, result.Memory, 0, VK_WHOLE_SIZE, 0, &result.Mapped));
+		++m_dedicatedCounts[memoryType];
+		m_dedicatedSizes[memoryType] += requirements.size;
+		return result;
+	}
+
+	void DeviceMemoryAllocator::Free(const Result& allocation)
+	{
+		if (!allocation.Block)
+		{
+			check(m_dedicatedCounts[allocation.MemoryType] > 0);
+			if (allocation.Mapped)
+				vkUnmapMemory(m_device, allocation.Memory);
+			vkFreeMemory(m_device, allocation.Memory, nullptr);
+			--m_dedicatedCounts[allocation.MemoryType];
+			m_dedicatedSizes[allocation.MemoryType] -= allocation.Size;
+			return;
+		}
+
+		MemoryBlock* block = allocation.Block;
+		block->Free(allocation.Node);
+		if (block->IsEmpty())
+		{
+			// Keep one empty block per pool to avoid allocation spikes.
+			std::vector<MemoryBlock*>& pool = m_pools[block->GetPoolIndex()];
+			uint32_t emptyCount = 0;
+			for (MemoryBlock* it : pool)
+				emptyCount += it->IsEmpty() ? 1 : 0;
+			if (emptyCount > 1)
+			{
+				pool.erase(std::find(pool.begin(), pool.end(), block));
+				if (block->GetMapped())
+					vkUnmapMemory(m_device, block->GetMemory());
+				vkFreeMemory(m_device, block->GetMemory(), nullptr);
+				delete block;
+			}
+		}
+	}
+
+	void DeviceMemoryAllocator::Flush(const Result& allocation, VkDeviceSize offset, VkDeviceSize size) const
+	{
+		check(allocation.Mapped && offset + size <= allocation.Size);
+		if (m_memoryProperties.memoryTypes[allocation.MemoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+			return;
+		// Range must be aligned to nonCoherentAtomSize or reach the end of the memory.
+		const VkDeviceSize memorySize = allocation.Block ? allocation.Block->GetSize() : allocation.Size;
+		const VkDeviceSize begin = AlignDown(allocation.Offset + offset, m_nonCoherentAtomSize);
+		const VkDeviceSize end = AlignUp(allocation.Offset + offset + size, m_nonCoherentAtomSize);
+		VkMappedMemoryRange range
+		{
+			.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+			.pNext = nullptr,
+			.memory = allocation.Memory,
+			.offset = begin,
+			.size = end < memorySize ? end - begin : VK_WHOLE_SIZE
+		};
+		vkcheck(vkFlushMappedMemoryRanges(m_device, 1, &range));
+	}
+
+	DeviceMemoryStats DeviceMemoryAllocator::GetStats(uint32_t memoryType) const
+	{
+		DeviceMemoryStats stats;
+		VkDeviceSize freeSize = 0;
+		VkDeviceSize largestFreeRange = 0;
+		for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; ++i)
+		{
+			if (memoryType != UINT32_MAX && memoryType != i)
+				continue;
+			for (uint32_t poolIndex = i * 2; poolIndex < i * 2 + 2; ++poolIndex)
+			{
+				for (const MemoryBlock* block : m_pools[poolIndex])
+				{
+					++stats.BlockCount;
+					stats.AllocationCount += block->GetAllocationCount();
+					stats.AllocatedSize += block->GetSize();
+					stats.UsedSize += block->GetUsedSize();
+					freeSize += block->GetSize() - block->GetUsedSize();
+					largestFreeRange = __max(largestFreeRange, block->GetLargestFreeRange());
+				}
+			}
+			stats.DedicatedAllocationCount += m_dedicatedCounts[i];
+			stats.AllocatedSize += m_dedicatedSizes[i];
+			stats.UsedSize += m_dedicatedSizes[i];
+		}
+		stats.Fragmentation = freeSize ? 1.f - (float)largestFreeRange / (float)freeSize : 0.f;
+		return stats;
+	}
+}
@@ -0,0 +1,142 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace vkmmc
+{
+	/**
+	 * One VkDeviceMemory sub-allocated with a two level segregated fit allocator (TLSF).
+	 * Free ranges are binned by size (power of two and linear subdivision), allocation and free are O(1)
+	 * and adjacent free ranges are merged on free.
+	 */
+	class MemoryBlock
+	{
+		static constexpr uint32_t InvalidNode = UINT32_MAX;
+		static constexpr uint32_t SecondLevelLog2 = 4;
+		static constexpr uint32_t SecondLevelCount = 1 << SecondLevelLog2;
+		static constexpr uint32_t FirstLevelCount = 64 - SecondLevelLog2 + 1;
+		// Remaining ranges smaller than this stay attached to the allocation.
+		static constexpr VkDeviceSize MinSplitSize = 256;
+
+		struct Node
+		{
+			VkDeviceSize Offset;
+			VkDeviceSize Size;
+			uint32_t PrevPhysical;
+			uint32_t NextPhysical;
+			uint32_t PrevFree;
+			uint32_t NextFree;
+			bool Free;
+		};
+
+	public:
+		// mapped: pointer to the whole block if it is host visible (mapped for its whole lifetime).
+		void Init(VkDeviceMemory memory, VkDeviceSize size, uint32_t poolIndex, void* mapped);
+		VkDeviceMemory GetMemory() const { return m_memory; }
+		void* GetMapped() const { return m_mapped; }
+		VkDeviceSize GetSize() const { return m_size; }
+		uint32_t GetPoolIndex() const { return m_poolIndex; }
+
+		// Returns false if there is not a free range big enough.
+		bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset, uint32_t& node);
+		void Free(uint32_t node);
+
+		bool IsEmpty() const { return m_allocationCount == 0; }
+		uint32_t GetAllocationCount() const { return m_allocationCount; }
+		VkDeviceSize GetUsedSize() const { return m_usedSize; }
+		// Size of the biggest free range.
+		VkDeviceSize GetLargestFreeRange() const;
+
+	private:
+		static void Mapping(VkDeviceSize size, uint32_t& fl, uint32_t& sl);
+		uint32_t NewNode();
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+
+		VkDeviceMemory m_memory{ VK_NULL_HANDLE };
+		void* m_mapped{ nullptr };
+		VkDeviceSize m_size{ 0 };
+		uint32_t m_poolIndex{ 0 };
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_unusedNodes;
+		uint64_t m_firstLevelBitmap{ 0 };
+		uint32_t m_secondLevelBitmap[FirstLevelCount];
+		uint32_t m_heads[FirstLevelCount][SecondLevelCount];
+		uint32_t m_allocationCount{ 0 };
+		VkDeviceSize m_usedSize{ 0 };
+	};
+
+	struct DeviceMemoryStats
+	{
+		uint32_t BlockCount = 0;
+		uint32_t AllocationCount = 0;
+		uint32_t DedicatedAllocationCount = 0;
+		// Device memory allocated from the driver (blocks and dedicated allocations).
+		VkDeviceSize AllocatedSize = 0;
+		// Memory in use by resources.
+		VkDeviceSize UsedSize = 0;
+		// Biggest contiguous free range over total free space in blocks. 0 means no fragmentation.
+		float Fragmentation = 0.f;
+	};
+
+	/**
+	 * Device memory sub-allocated from big blocks, one list of blocks per memory type.
+	 * Linear resources (buffers) and optimal tiling images are kept in different blocks when the device
+	 * has a bufferImageGranularity bigger than 1, so they never share a granularity page.
+	 * Resources bigger than half a block, and images the driver wants dedicated, get their own allocation.
+	 * Host visible memory is mapped once when it is allocated, resources write through the mapped pointer.
+	 */
+	class DeviceMemoryAllocator
+	{
+	public:
+		enum EResourceType
+		{
+			RESOURCE_LINEAR,
+			RESOURCE_OPTIMAL,
+		};
+
+		struct Result
+		{
+			VkDeviceMemory Memory{ VK_NULL_HANDLE };
+			VkDeviceSize Offset{ 0 };
+			VkDeviceSize Size{ 0 };
+			MemoryBlock* Block{ nullptr };
+			uint32_t Node{ 0 };
+			uint32_t MemoryType{ 0 };
+			// Start of the allocation in host memory, null if memory is not host visible.
+			void* Mapped{ nullptr };
+		};
+
+		void Init(VkDevice device, VkPhysicalDevice physicalDevice);
+		void Destroy();
+
+		// dedicatedBuffer/dedicatedImage: resource to bind if the allocation ends up dedicated (one of both, other one null).
+		Result Allocate(const VkMemoryRequirements& requirements, uint32_t memoryType, EResourceType resourceType, bool preferDedicated,
+			VkBuffer dedicatedBuffer, VkImage dedicatedImage);
+		void Free(const Result& allocation);
+		// Make host writes visible to the device. Nothing to do with coherent memory.
+		void Flush(const Result& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+
+		// Stats of one memory type, or of all of them with UINT32_MAX.
+		DeviceMemoryStats GetStats(uint32_t memoryType = UINT32_MAX) const;
+		const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return m_memoryProperties; }
+
+	private:
+		VkDeviceSize GetBlockSize(uint32_t memoryType) const;
+		uint32_t GetPoolIndex(uint32_t memoryType, EResourceType resourceType) const;
+
+		VkDevice m_device{ VK_NULL_HANDLE };
+		VkPhysicalDeviceMemoryProperties m_memoryProperties;
+		VkDeviceSize m_bufferImageGranularity{ 1 };
+		VkDeviceSize m_nonCoherentAtomSize{ 1 };
+		// Blocks per memory type and resource type.
+		std::vector<std::vector<MemoryBlock*>> m_pools;
+		// Dedicated allocations per memory type.
+		std::vector<uint32_t> m_dedicatedCounts;
+		std::vector<VkDeviceSize> m_dedicatedSizes;
+	};
+}
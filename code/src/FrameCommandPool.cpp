@@ -0,0 +1,85 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "FrameCommandPool.h"
+#include "RenderContext.h"
+#include "InitVulkanTypes.h"
+#include "WorkerPool.h"
+#include "Debug.h"
+
+namespace vkmmc
+{
+	void FrameCommandPool::Init(const RenderContext& renderContext, uint32_t threadCount)
+	{
+		check(threadCount > 0 && m_pools[0].empty());
+		VkCommandPoolCreateInfo poolInfo = vkinit::CommandPoolCreateInfo(renderContext.GraphicsQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+		{
+			m_pools[i].resize(threadCount);
+			for (ThreadPool& pool : m_pools[i])
+				vkcheck(vkCreateCommandPool(renderContext.Device, &poolInfo, nullptr, &pool.Pool));
+		}
+	}
+
+	void FrameCommandPool::Destroy(const RenderContext& renderContext)
+	{
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+		{
+			for (ThreadPool& pool : m_pools[i])
+				vkDestroyCommandPool(renderContext.Device, pool.Pool, nullptr);
+			m_pools[i].clear();
+		}
+	}
+
+	void FrameCommandPool::BeginFrame(const RenderContext& renderContext, uint32_t frameIndex)
+	{
+		check(frameIndex < globals::MaxOverlappedFrames);
+		m_frameIndex = frameIndex;
+		for (ThreadPool& pool : m_pools[frameIndex])
+		{
+			vkcheck(vkResetCommandPool(renderContext.Device, pool.Pool, 0));
+			pool.UsedCount = 0;
+		}
+	}
+
+	VkCommandBuffer FrameCommandPool::BeginSecondary(const RenderContext& renderContext, VkRenderPass renderPass, VkFramebuffer framebuffer)
+	{
+		const uint32_t threadIndex = WorkerPool::GetThreadIndex();
+		check(threadIndex < (uint32_t)m_pools[m_frameIndex].size());
+		ThreadPool& pool = m_pools[m_frameIndex][threadIndex];
+		if (pool.UsedCount == (uint32_t)pool.CommandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo = vkinit::CommandBufferCreateAllocateInfo(pool.Pool, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+			VkCommandBuffer cmd;
+			vkcheck(vkAllocateCommandBuffers(renderContext.Device, &allocInfo, &cmd));
+			pool.CommandBuffers.push_back(cmd);
+		}
+		VkCommandBuffer cmd = pool.CommandBuffers[pool.UsedCount++];
+
+		VkCommandBufferInheritanceInfo inheritanceInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+			.pNext = nullptr,
+			.renderPass = renderPass,
+			.subpass = 0,
+			.framebuffer = framebuffer,
+			.occlusionQueryEnable = VK_FALSE,
+			.queryFlags = 0,
+			.pipelineStatistics = 0
+		};
+		VkCommandBufferBeginInfo beginInfo
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.pNext = nullptr,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+			.pInheritanceInfo = &inheritanceInfo
+		};
+		vkcheck(vkBeginCommandBuffer(cmd, &beginInfo));
+		return cmd;
+	}
+
+	void FrameCommandPool::EndSecondary(VkCommandBuffer cmd) const
+	{
+		vkcheck(vkEndCommandBuffer(cmd));
+	}
+}
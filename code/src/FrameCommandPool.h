@@ -0,0 +1,42 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include "Globals.h"
+
+namespace vkmmc
+{
+	struct RenderContext;
+
+	/**
+	 * Secondary command buffers recorded inside a render pass. One command pool per frame in flight and per
+	 * thread, so threads recording commands never share a pool. Pools of a frame slot are reset at once when
+	 * its fence has signaled and their command buffers are reused the next time the slot is recorded.
+	 */
+	class FrameCommandPool
+	{
+		struct ThreadPool
+		{
+			VkCommandPool Pool{ VK_NULL_HANDLE };
+			std::vector<VkCommandBuffer> CommandBuffers;
+			uint32_t UsedCount{ 0 };
+		};
+	public:
+		// threadCount: calling thread plus worker threads (see WorkerPool::GetThreadIndex).
+		void Init(const RenderContext& renderContext, uint32_t threadCount);
+		void Destroy(const RenderContext& renderContext);
+
+		// Frame slot fence has signaled, command buffers recorded last time the slot was used are reset.
+		void BeginFrame(const RenderContext& renderContext, uint32_t frameIndex);
+		// Secondary command buffer of the calling thread, begun to continue subpass 0 of renderPass.
+		VkCommandBuffer BeginSecondary(const RenderContext& renderContext, VkRenderPass renderPass, VkFramebuffer framebuffer);
+		void EndSecondary(VkCommandBuffer cmd) const;
+
+	private:
+		std::vector<ThreadPool> m_pools[globals::MaxOverlappedFrames];
+		uint32_t m_frameIndex{ 0 };
+	};
+}
@@ -0,0 +1,273 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "FrameMetrics.h"
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include "Memory.h"
+#include "Debug.h"
+#include <algorithm>
+#include <cstring>
+#include <imgui/imgui.h>
+
+namespace frame_metrics_internal
+{
+	// Nearest rank of a sorted array.
+	double Percentile(const std::vector<double>& sorted, double percentile)
+	{
+		const size_t rank = (size_t)(percentile * (double)sorted.size() + 0.999999);
+		return sorted[__min(__max(rank, (size_t)1), sorted.size()) - 1];
+	}
+
+	bool EndsWith(const char* str, const char* suffix)
+	{
+		const size_t strLen = strlen(str);
+		const size_t suffixLen = strlen(suffix);
+		return strLen >= suffixLen && !strcmp(str + strLen - suffixLen, suffix);
+	}
+}
+
+namespace vkmmc
+{
+	RenderStats GRenderStats;
+
+	void RenderStats::Reset()
+	{
+		TrianglesCount = 0;
+		DrawCalls = 0;
+		SetBindingCount = 0;
+		BufferBindCount = 0;
+		UploadBytes = 0;
+	}
+
+	void RenderStats::Add(const DrawStats& stats)
+	{
+		TrianglesCount += stats.TrianglesCount;
+		DrawCalls += stats.DrawCalls;
+		SetBindingCount += stats.SetBindingCount;
+		BufferBindCount += stats.BufferBindCount;
+	}
+
+	void FrameMetricsRecorder::Init(uint32_t capacity, const char* filepath)
+	{
+		check(capacity > 0 && m_records.empty());
+		m_records.resize(capacity);
+		m_sortedTimes.reserve(capacity);
+		m_head = 0;
+		m_count = 0;
+		m_summary = FrameTimeSummary();
+		m_lastGpuFrame = UINT32_MAX;
+		if (!filepath)
+			return;
+		if (fopen_s(&m_file, filepath, "w") || !m_file)
+		{
+			Logf(LogLevel::Error, "Failed to open %s to write frame metrics.\n", filepath);
+			m_file = nullptr;
+			return;
+		}
+		m_csv = frame_metrics_internal::EndsWith(filepath, ".csv");
+		if (m_csv)
+			fprintf_s(m_file, "frame,metric,value\n");
+		Logf(LogLevel::Info, "Streaming frame metrics to %s.\n", filepath);
+	}
+
+	void FrameMetricsRecorder::Destroy()
+	{
+		if (m_file)
+		{
+			fclose(m_file);
+			m_file = nullptr;
+		}
+		m_records.clear();
+		m_sortedTimes.clear();
+		m_head = 0;
+		m_count = 0;
+	}
+
+	void FrameMetricsRecorder::Record(uint32_t frame, const GpuProfiler& gpuProfiler, const Allocator* allocator)
+	{
+		if (m_records.empty())
+			return;
+		// Slots are reused, scope arrays keep their capacity.
+		FrameMetrics& metrics = m_records[m_head];
+		metrics.Frame = frame;
+		metrics.CpuMilliseconds = GCpuProfiler.GetFrameMilliseconds();
+		// Gpu results are some frames late and stay the same until another frame resolves.
+		const uint32_t gpuFrame = gpuProfiler.GetResultsFrame();
+		metrics.HasGpu = gpuFrame != GpuProfiler::InvalidFrame && gpuFrame != m_lastGpuFrame;
+		metrics.GpuFrame = gpuFrame;
+		metrics.GpuMilliseconds = metrics.HasGpu ? gpuProfiler.GetFrameMilliseconds() : 0.0;
+		m_lastGpuFrame = gpuFrame;
+		metrics.DrawCalls = GRenderStats.DrawCalls.load();
+		metrics.Triangles = GRenderStats.TrianglesCount.load();
+		metrics.SetBindings = GRenderStats.SetBindingCount.load();
+		metrics.BufferBinds = GRenderStats.BufferBindCount.load();
+		metrics.UploadBytes = GRenderStats.UploadBytes.load();
+		metrics.MemoryUsed = 0;
+		if (allocator)
+		{
+			for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+				metrics.MemoryUsed += allocator->Categories[i].Size;
+		}
+
+		metrics.CpuScopes.clear();
+		for (const CpuProfiler::ZoneStats& stats : GCpuProfiler.GetFrameStats())
+		{
+			if (stats.Calls && !stats.Zone->Counter)
+				metrics.CpuScopes.push_back({ stats.Zone->Name, stats.Milliseconds });
+		}
+		// Renderers qualified by their pass, the same renderer runs in several passes.
+		metrics.GpuScopes.clear();
+		if (metrics.HasGpu)
+		{
+			const std::string* passName = nullptr;
+			for (const GpuProfileScope& scope : gpuProfiler.GetResults())
+			{
+				if (!scope.Depth)
+				{
+					passName = &scope.Name;
+					metrics.GpuScopes.push_back({ scope.Name, scope.Milliseconds });
+				}
+				else
+					metrics.GpuScopes.push_back({ (passName ? *passName + "/" : std::string()) + scope.Name, scope.Milliseconds });
+			}
+		}
+
+		m_head = (m_head + 1) % (uint32_t)m_records.size();
+		m_count = __min(m_count + 1, (uint32_t)m_records.size());
+
+		m_sortedTimes.clear();
+		double sum = 0.0;
+		for (uint32_t i = 0; i < m_count; ++i)
+		{
+			m_sortedTimes.push_back(m_records[i].CpuMilliseconds);
+			sum += m_records[i].CpuMilliseconds;
+		}
+		std::sort(m_sortedTimes.begin(), m_sortedTimes.end());
+		m_summary.FrameCount = m_count;
+		m_summary.Average = sum / (double)m_count;
+		m_summary.P50 = frame_metrics_internal::Percentile(m_sortedTimes, 0.50);
+		m_summary.P95 = frame_metrics_internal::Percentile(m_sortedTimes, 0.95);
+		m_summary.P99 = frame_metrics_internal::Percentile(m_sortedTimes, 0.99);
+		m_summary.Max = m_sortedTimes.back();
+
+		if (m_file)
+			WriteRecord(metrics);
+	}
+
+	const FrameMetrics* FrameMetricsRecorder::GetLatest() const
+	{
+		if (!m_count)
+			return nullptr;
+		return &m_records[(m_head + (uint32_t)m_records.size() - 1) % (uint32_t)m_records.size()];
+	}
+
+	FrameStatsSummary FrameMetricsRecorder::ComputeStatsSummary() const
+	{
+		FrameStatsSummary summary;
+		if (!m_count)
+			return summary;
+		summary.FrameCount = m_count;
+		summary.AverageMs = m_summary.Average;
+		summary.P50Ms = m_summary.P50;
+		summary.P95Ms = m_summary.P95;
+		summary.P99Ms = m_summary.P99;
+		summary.MaxMs = m_summary.Max;
+		uint32_t gpuCount = 0;
+		for (uint32_t i = 0; i < m_count; ++i)
+		{
+			const FrameMetrics& metrics = m_records[i];
+			if (metrics.HasGpu)
+			{
+				summary.GpuAverageMs += metrics.GpuMilliseconds;
+				++gpuCount;
+			}
+			summary.DrawCalls += metrics.DrawCalls;
+			summary.Triangles += metrics.Triangles;
+			summary.SetBindings += metrics.SetBindings;
+			summary.BufferBinds += metrics.BufferBinds;
+			summary.UploadBytes += (double)metrics.UploadBytes;
+		}
+		const double count = (double)m_count;
+		summary.GpuAverageMs /= (double)__max(gpuCount, 1u);
+		summary.DrawCalls /= count;
+		summary.Triangles /= count;
+		summary.SetBindings /= count;
+		summary.BufferBinds /= count;
+		summary.UploadBytes /= count;
+		summary.MemoryUsed = GetLatest()->MemoryUsed;
+		return summary;
+	}
+
+	void FrameMetricsRecorder::Reset()
+	{
+		m_head = 0;
+		m_count = 0;
+		m_summary = FrameTimeSummary();
+	}
+
+	void FrameMetricsRecorder::WriteRecord(const FrameMetrics& metrics)
+	{
+		if (m_csv)
+		{
+			const uint32_t frame = metrics.Frame;
+			fprintf_s(m_file, "%u,cpu_ms,%.4f\n", frame, metrics.CpuMilliseconds);
+			fprintf_s(m_file, "%u,draw_calls,%u\n", frame, metrics.DrawCalls);
+			fprintf_s(m_file, "%u,triangles,%u\n", frame, metrics.Triangles);
+			fprintf_s(m_file, "%u,set_bindings,%u\n", frame, metrics.SetBindings);
+			fprintf_s(m_file, "%u,buffer_binds,%u\n", frame, metrics.BufferBinds);
+			fprintf_s(m_file, "%u,upload_bytes,%llu\n", frame, (unsigned long long)metrics.UploadBytes);
+			fprintf_s(m_file, "%u,memory_used,%llu\n", frame, (unsigned long long)metrics.MemoryUsed);
+			for (const FrameMetricsScope& scope : metrics.CpuScopes)
+				fprintf_s(m_file, "%u,cpu/%s,%.4f\n", frame, scope.Name.c_str(), scope.Milliseconds);
+			// Gpu rows under the frame they were measured in, once.
+			if (metrics.HasGpu)
+			{
+				fprintf_s(m_file, "%u,gpu_ms,%.4f\n", metrics.GpuFrame, metrics.GpuMilliseconds);
+				for (const FrameMetricsScope& scope : metrics.GpuScopes)
+					fprintf_s(m_file, "%u,gpu/%s,%.4f\n", metrics.GpuFrame, scope.Name.c_str(), scope.Milliseconds);
+			}
+			return;
+		}
+
+		fprintf_s(m_file, "{\"frame\": %u, \"cpuMs\": %.4f, ", metrics.Frame, metrics.CpuMilliseconds);
+		// Gpu fields name the frame they were measured in, only on the record that resolved them.
+		if (metrics.HasGpu)
+			fprintf_s(m_file, "\"gpuFrame\": %u, \"gpuMs\": %.4f, ", metrics.GpuFrame, metrics.GpuMilliseconds);
+		fprintf_s(m_file, "\"drawCalls\": %u, \"triangles\": %u, "
+			"\"setBindings\": %u, \"bufferBinds\": %u, \"uploadBytes\": %llu, \"memoryUsed\": %llu, \"cpu\": [",
+			metrics.DrawCalls, metrics.Triangles,
+			metrics.SetBindings, metrics.BufferBinds, (unsigned long long)metrics.UploadBytes, (unsigned long long)metrics.MemoryUsed);
+		for (size_t i = 0; i < metrics.CpuScopes.size(); ++i)
+		{
+			fprintf_s(m_file, "%s{\"name\": \"%s\", \"ms\": %.4f}", i ? ", " : "",
+				metrics.CpuScopes[i].Name.c_str(), metrics.CpuScopes[i].Milliseconds);
+		}
+		fprintf_s(m_file, "]");
+		if (metrics.HasGpu)
+		{
+			fprintf_s(m_file, ", \"gpu\": [");
+			for (size_t i = 0; i < metrics.GpuScopes.size(); ++i)
+			{
+				fprintf_s(m_file, "%s{\"name\": \"%s\", \"ms\": %.4f}", i ? ", " : "",
+					metrics.GpuScopes[i].Name.c_str(), metrics.GpuScopes[i].Milliseconds);
+			}
+			fprintf_s(m_file, "]");
+		}
+		fprintf_s(m_file, "}\n");
+	}
+
+	void FrameMetricsRecorder::ImGuiDraw() const
+	{
+		const FrameMetrics* metrics = GetLatest();
+		if (!metrics)
+			return;
+		ImGui::Text("Frame:\t%.4f ms (p50 %.2f, p95 %.2f, p99 %.2f of %u)", metrics->CpuMilliseconds,
+			m_summary.P50, m_summary.P95, m_summary.P99, m_summary.FrameCount);
+		ImGui::Text("Draw calls:	%u", metrics->DrawCalls);
+		ImGui::Text("Triangles:		%u", metrics->Triangles);
+		ImGui::Text("Binding count: %u", metrics->SetBindings);
+		ImGui::Text("Buffer binds:  %u", metrics->BufferBinds);
+		ImGui::Text("Uploaded:      %.2f KB", (double)metrics->UploadBytes / 1024.0);
+	}
+}
@@ -0,0 +1,118 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <vector>
+#include <string>
+#include "RenderEngine.h"
+
+namespace vkmmc
+{
+	struct Allocator;
+	class GpuProfiler;
+
+	// Draw counters of one record job, plain integers. Added to GRenderStats once the job is recorded.
+	struct DrawStats
+	{
+		uint32_t TrianglesCount = 0;
+		uint32_t DrawCalls = 0;
+		uint32_t SetBindingCount = 0;
+		uint32_t BufferBindCount = 0;
+	};
+
+	// Counters of the frame being recorded, thread safe.
+	struct RenderStats
+	{
+		std::atomic<uint32_t> TrianglesCount{ 0 };
+		std::atomic<uint32_t> DrawCalls{ 0 };
+		std::atomic<uint32_t> SetBindingCount{ 0 };
+		// Vertex and index buffer binds.
+		std::atomic<uint32_t> BufferBindCount{ 0 };
+		// Bytes written by the cpu in host visible buffers.
+		std::atomic<uint64_t> UploadBytes{ 0 };
+		void Reset();
+		void Add(const DrawStats& stats);
+	};
+	extern RenderStats GRenderStats;
+
+	struct FrameMetricsScope
+	{
+		std::string Name;
+		double Milliseconds = 0.0;
+	};
+
+	struct FrameMetrics
+	{
+		uint32_t Frame = 0;
+		double CpuMilliseconds = 0.0;
+		// Gpu results resolved since the previous record. They belong to GpuFrame, some frames behind.
+		// False without timestamp support.
+		bool HasGpu = false;
+		uint32_t GpuFrame = 0;
+		double GpuMilliseconds = 0.0;
+		uint32_t DrawCalls = 0;
+		uint32_t Triangles = 0;
+		uint32_t SetBindings = 0;
+		uint32_t BufferBinds = 0;
+		uint64_t UploadBytes = 0;
+		// Device memory of live resources.
+		uint64_t MemoryUsed = 0;
+		std::vector<FrameMetricsScope> CpuScopes;
+		std::vector<FrameMetricsScope> GpuScopes;
+	};
+
+	struct FrameTimeSummary
+	{
+		uint32_t FrameCount = 0;
+		double Average = 0.0;
+		double P50 = 0.0;
+		double P95 = 0.0;
+		double P99 = 0.0;
+		double Max = 0.0;
+	};
+
+	/**
+	 * Ring of the last frame metrics with rolling frame time percentiles. Each record can be streamed to disk,
+	 * as CSV rows of frame,metric,value when the file ends in .csv and as JSON Lines otherwise.
+	 */
+	class FrameMetricsRecorder
+	{
+	public:
+		// Null filepath keeps the records in memory only.
+		void Init(uint32_t capacity, const char* filepath);
+		void Destroy();
+
+		// Main thread, after the profiler closed the frame and before the render stats are reset.
+		void Record(uint32_t frame, const GpuProfiler& gpuProfiler, const Allocator* allocator);
+
+		inline uint32_t GetRecordCount() const { return m_count; }
+		// Null before the first record.
+		const FrameMetrics* GetLatest() const;
+		// Frame time of the records in the ring.
+		inline const FrameTimeSummary& GetSummary() const { return m_summary; }
+		// Frame time percentiles and mean of the counters in the ring.
+		FrameStatsSummary ComputeStatsSummary() const;
+		// Empty the ring, the stream keeps going.
+		void Reset();
+
+		void ImGuiDraw() const;
+
+	private:
+		void WriteRecord(const FrameMetrics& metrics);
+
+		std::vector<FrameMetrics> m_records;
+		uint32_t m_head{ 0 };
+		uint32_t m_count{ 0 };
+		FrameTimeSummary m_summary;
+		// Frame of the last gpu results taken, each is recorded once.
+		uint32_t m_lastGpuFrame{ UINT32_MAX };
+		// Scratch for the percentiles.
+		std::vector<double> m_sortedTimes;
+		FILE* m_file{ nullptr };
+		bool m_csv{ false };
+	};
+}
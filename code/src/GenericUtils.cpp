@@ -43,6 +43,17 @@ namespace vkmmc
 		}
 	}
 
+	uint64_t hash::Fnv1a(const void* data, size_t size, uint64_t seed)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			seed ^= bytes[i];
+			seed *= 1099511628211ull;
+		}
+		return seed;
+	}
+
 	glm::vec3 math::ToRot(const glm::vec3& direction)
 	{
 		return glm::vec3(asin(-direction.y), atan2(direction.x, direction.z), 0.f);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -11,6 +12,12 @@ namespace vkmmc
 		void GetRootDir(const char* filepath, char* rootPath, size_t size);
 	}
 
+	namespace hash
+	{
+		// FNV-1a. Pass the result of a previous call as seed to hash several buffers.
+		uint64_t Fnv1a(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+	}
+
 	// Math
 	namespace math
 	{
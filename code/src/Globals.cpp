@@ -19,6 +19,13 @@ namespace vkmmc
 		const char* DepthFragmentShader = SHADER_ROOT_PATH "depth.frag.spv";
 		const char* QuadVertexShader = SHADER_ROOT_PATH "quad.vert.spv";
 		const char* QuadFragmentShader = SHADER_ROOT_PATH "quad.frag.spv";
+		const char* BindlessFragmentShader = SHADER_ROOT_PATH "basic_bindless.frag.spv";
+		const char* TextureCacheDirectory = ASSET_ROOT_PATH "cache/textures/";
+		const char* MemoryTelemetryFile = "memory_telemetry.json";
+		const char* PipelineCacheFile = ASSET_ROOT_PATH "cache/pipeline_cache.bin";
+		const char* ShaderCacheDirectory = ASSET_ROOT_PATH "cache/shaders/";
+		const char* CpuTraceFile = "cpu_trace.json";
+		const char* FrameMetricsFile = nullptr;
 
 	}
 }
\ No newline at end of file
@@ -3,9 +3,10 @@
 
 #pragma once
 
+#include <cstdint>
+
 #define UNIFORM_ID_SCENE_MODEL_TRANSFORM_ARRAY "Models"
 #define UNIFORM_ID_SCENE_ENV_DATA "Environment"
-#define UNIFORM_ID_SHADOW_MAP_VP "ShadowMapVP"
 #define UNIFORM_ID_LIGHT_VP "LightVP"
 #define UNIFORM_ID_CAMERA "Camera"
 
@@ -23,7 +24,50 @@ namespace vkmmc
 		extern const char* DepthFragmentShader;
 		extern const char* QuadVertexShader;
 		extern const char* QuadFragmentShader;
+		extern const char* BindlessFragmentShader;
+		// Compressed textures generated at import time
+		extern const char* TextureCacheDirectory;
+		// Memory telemetry dumped at shutdown, null to disable.
+		extern const char* MemoryTelemetryFile;
+		// Driver pipeline cache loaded at startup and saved at shutdown, null to disable persistence.
+		extern const char* PipelineCacheFile;
+		// Shader reflection cache, null to reflect every run.
+		extern const char* ShaderCacheDirectory;
+		// Chrome trace written by the CPU profiler captures.
+		extern const char* CpuTraceFile;
+		// Metrics of every frame, CSV when it ends in .csv and JSON Lines otherwise. Null to disable.
+		extern const char* FrameMetricsFile;
+		// Pipelines are rebuilt in background when their shader binaries change.
+		constexpr bool EnableShaderHotReload = true;
+		constexpr uint32_t ShaderHotReloadPollMs = 500;
+		constexpr bool CompressTexturesOnImport = true;
+		// Texture streaming
+		constexpr bool EnableTextureStreaming = true;
+		constexpr size_t TextureStreamingBudget = 512ull * 1024 * 1024;
+		// Max size of the levels resident at load time
+		constexpr uint32_t TextureStreamingResidentSize = 64;
+		constexpr size_t TextureStreamingUploadSizePerFrame = 32ull * 1024 * 1024;
+		constexpr uint32_t TextureStreamingMaxPendingLoads = 8;
+		// Bindless materials, only when the device supports descriptor indexing
+		constexpr bool EnableBindlessTextures = true;
+		constexpr uint32_t MaxBindlessTextures = 4096;
+		constexpr uint32_t MaxBindlessMaterials = 1024;
 		constexpr uint32_t MaxOverlappedFrames = 2;
+		// Ring buffer for per frame transient data, shared by the frames in flight.
+		constexpr uint32_t TransientBufferSize = 4 * 1024 * 1024;
+		// Renderers record secondary command buffers in worker threads.
+		constexpr bool EnableParallelRecording = true;
+		constexpr uint32_t MinItemsPerRecordJob = 128;
+		constexpr uint32_t MaxRecordJobsPerRenderer = 8;
+		// Lighting pipelines specialized for the active lights and shadow maps, built on demand.
+		constexpr bool EnableShaderVariants = true;
+		// GPU timestamps per pass and renderer, vertex and fragment invocations when supported.
+		constexpr bool EnableGpuProfiler = true;
+		constexpr bool EnableGpuPipelineStatistics = true;
+		constexpr uint32_t MaxGpuProfileScopes = 64;
+		constexpr uint32_t MaxGpuStatisticsQueries = 256;
+		// Frames kept in memory for the frame time percentiles.
+		constexpr uint32_t FrameMetricsHistory = 1024;
 		constexpr uint32_t MaxRenderObjects = 1000;
 		constexpr uint32_t MaxShadowMapAttachments = 3;
 	}
@@ -0,0 +1,221 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "GpuProfiler.h"
+#include "RenderContext.h"
+#include "Debug.h"
+#include <imgui/imgui.h>
+
+namespace vkmmc
+{
+	void GpuProfiler::Init(const RenderContext& renderContext)
+	{
+		check(m_frames[0].TimestampPool == VK_NULL_HANDLE);
+		uint32_t familyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(renderContext.GPUDevice, &familyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> families(familyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(renderContext.GPUDevice, &familyCount, families.data());
+		const uint32_t validBits = families[renderContext.GraphicsQueueFamily].timestampValidBits;
+		if (!validBits || renderContext.GPUProperties.limits.timestampPeriod <= 0.f)
+		{
+			Log(LogLevel::Warn, "Graphics queue does not support timestamps, GPU profiler disabled.\n");
+			return;
+		}
+		m_timestampPeriod = (double)renderContext.GPUProperties.limits.timestampPeriod;
+		m_timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+		m_statistics = globals::EnableGpuPipelineStatistics && renderContext.GPUFeatures.pipelineStatisticsQuery;
+
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+		{
+			VkQueryPoolCreateInfo poolInfo
+			{
+				.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+				.pNext = nullptr,
+				.flags = 0,
+				.queryType = VK_QUERY_TYPE_TIMESTAMP,
+				.queryCount = globals::MaxGpuProfileScopes * 2,
+				.pipelineStatistics = 0
+			};
+			vkcheck(vkCreateQueryPool(renderContext.Device, &poolInfo, nullptr, &m_frames[i].TimestampPool));
+			if (m_statistics)
+			{
+				poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+				poolInfo.queryCount = globals::MaxGpuStatisticsQueries;
+				poolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+					| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+				vkcheck(vkCreateQueryPool(renderContext.Device, &poolInfo, nullptr, &m_frames[i].StatisticsPool));
+			}
+		}
+		Logf(LogLevel::Ok, "GPU profiler initialized (%.2f ns per tick, pipeline statistics %s).\n",
+			m_timestampPeriod, m_statistics ? "enabled" : "disabled");
+	}
+
+	void GpuProfiler::Destroy(const RenderContext& renderContext)
+	{
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+		{
+			vkDestroyQueryPool(renderContext.Device, m_frames[i].TimestampPool, nullptr);
+			vkDestroyQueryPool(renderContext.Device, m_frames[i].StatisticsPool, nullptr);
+			m_frames[i] = FrameQueries();
+		}
+		m_timestampPeriod = 0.0;
+		m_results.clear();
+		m_resultsFrame = InvalidFrame;
+	}
+
+	void GpuProfiler::BeginFrame(const RenderContext& renderContext, uint32_t frameIndex, uint32_t frameCounter)
+	{
+		check(frameIndex < globals::MaxOverlappedFrames);
+		m_frameIndex = frameIndex;
+		FrameQueries& frame = m_frames[frameIndex];
+		const uint32_t recordedFrame = frame.Frame;
+		frame.Frame = frameCounter;
+		if (!IsEnabled() || !frame.Recorded || frame.Scopes.empty())
+		{
+			frame.Scopes.clear();
+			frame.StatisticsScopes.clear();
+			frame.Recorded = false;
+			return;
+		}
+
+		// Value and availability per query, never wait for results.
+		const VkQueryResultFlags flags = VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT;
+		const uint32_t timestampCount = (uint32_t)frame.Scopes.size() * 2;
+		std::vector<uint64_t> timestamps(timestampCount * 2);
+		VkResult result = vkGetQueryPoolResults(renderContext.Device, frame.TimestampPool, 0, timestampCount,
+			timestamps.size() * sizeof(uint64_t), timestamps.data(), 2 * sizeof(uint64_t), flags);
+		bool resolved = result == VK_SUCCESS || result == VK_NOT_READY;
+		for (uint32_t i = 0; i < timestampCount && resolved; ++i)
+			resolved = timestamps[i * 2 + 1] != 0;
+		if (resolved)
+		{
+			for (uint32_t i = 0; i < (uint32_t)frame.Scopes.size(); ++i)
+			{
+				const uint64_t ticks = (timestamps[i * 4 + 2] - timestamps[i * 4]) & m_timestampMask;
+				frame.Scopes[i].Milliseconds = (double)ticks * m_timestampPeriod * 1e-6;
+			}
+		}
+
+		const uint32_t statisticsCount = (uint32_t)frame.StatisticsScopes.size();
+		if (resolved && statisticsCount)
+		{
+			// Vertex invocations, fragment invocations and availability per query.
+			std::vector<uint64_t> statistics(statisticsCount * 3);
+			result = vkGetQueryPoolResults(renderContext.Device, frame.StatisticsPool, 0, statisticsCount,
+				statistics.size() * sizeof(uint64_t), statistics.data(), 3 * sizeof(uint64_t), flags);
+			if (result == VK_SUCCESS || result == VK_NOT_READY)
+			{
+				for (uint32_t i = 0; i < statisticsCount; ++i)
+				{
+					if (!statistics[i * 3 + 2])
+						continue;
+					GpuProfileScope& scope = frame.Scopes[frame.StatisticsScopes[i]];
+					scope.VertexInvocations += statistics[i * 3];
+					scope.FragmentInvocations += statistics[i * 3 + 1];
+				}
+				// Passes sum the renderers inside.
+				GpuProfileScope* pass = nullptr;
+				for (GpuProfileScope& scope : frame.Scopes)
+				{
+					if (!scope.Depth)
+						pass = &scope;
+					else if (pass)
+					{
+						pass->VertexInvocations += scope.VertexInvocations;
+						pass->FragmentInvocations += scope.FragmentInvocations;
+					}
+				}
+			}
+		}
+		if (resolved)
+		{
+			m_results.swap(frame.Scopes);
+			m_resultsFrame = recordedFrame;
+		}
+		frame.Scopes.clear();
+		frame.StatisticsScopes.clear();
+		frame.Recorded = false;
+	}
+
+	void GpuProfiler::ResetQueries(VkCommandBuffer cmd)
+	{
+		if (!IsEnabled())
+			return;
+		FrameQueries& frame = m_frames[m_frameIndex];
+		vkCmdResetQueryPool(cmd, frame.TimestampPool, 0, globals::MaxGpuProfileScopes * 2);
+		if (m_statistics)
+			vkCmdResetQueryPool(cmd, frame.StatisticsPool, 0, globals::MaxGpuStatisticsQueries);
+		frame.Recorded = true;
+	}
+
+	uint32_t GpuProfiler::AddScope(const char* name, uint32_t depth)
+	{
+		FrameQueries& frame = m_frames[m_frameIndex];
+		if (!IsEnabled() || frame.Scopes.size() >= globals::MaxGpuProfileScopes)
+			return InvalidQuery;
+		GpuProfileScope scope;
+		scope.Name = name;
+		scope.Depth = depth;
+		frame.Scopes.push_back(scope);
+		return (uint32_t)frame.Scopes.size() - 1;
+	}
+
+	uint32_t GpuProfiler::AddStatisticsQuery(uint32_t scope)
+	{
+		FrameQueries& frame = m_frames[m_frameIndex];
+		if (!m_statistics || scope == InvalidQuery || frame.StatisticsScopes.size() >= globals::MaxGpuStatisticsQueries)
+			return InvalidQuery;
+		frame.StatisticsScopes.push_back(scope);
+		return (uint32_t)frame.StatisticsScopes.size() - 1;
+	}
+
+	void GpuProfiler::WriteBeginTimestamp(VkCommandBuffer cmd, uint32_t scope) const
+	{
+		if (scope != InvalidQuery)
+			vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_frames[m_frameIndex].TimestampPool, scope * 2);
+	}
+
+	void GpuProfiler::WriteEndTimestamp(VkCommandBuffer cmd, uint32_t scope) const
+	{
+		if (scope != InvalidQuery)
+			vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_frames[m_frameIndex].TimestampPool, scope * 2 + 1);
+	}
+
+	void GpuProfiler::BeginStatistics(VkCommandBuffer cmd, uint32_t query) const
+	{
+		if (query != InvalidQuery)
+			vkCmdBeginQuery(cmd, m_frames[m_frameIndex].StatisticsPool, query, 0);
+	}
+
+	void GpuProfiler::EndStatistics(VkCommandBuffer cmd, uint32_t query) const
+	{
+		if (query != InvalidQuery)
+			vkCmdEndQuery(cmd, m_frames[m_frameIndex].StatisticsPool, query);
+	}
+
+	double GpuProfiler::GetFrameMilliseconds() const
+	{
+		double ms = 0.0;
+		for (const GpuProfileScope& scope : m_results)
+		{
+			if (!scope.Depth)
+				ms += scope.Milliseconds;
+		}
+		return ms;
+	}
+
+	void GpuProfiler::ImGuiDraw() const
+	{
+		if (!IsEnabled())
+			return;
+		ImGui::Text("GPU:\t%.4f ms", GetFrameMilliseconds());
+		for (const GpuProfileScope& scope : m_results)
+		{
+			if (m_statistics)
+				ImGui::Text("%*s%s:\t%.4f ms (vs %llu, fs %llu)", scope.Depth * 2 + 2, "", scope.Name.c_str(), scope.Milliseconds,
+					(unsigned long long)scope.VertexInvocations, (unsigned long long)scope.FragmentInvocations);
+			else
+				ImGui::Text("%*s%s:\t%.4f ms", scope.Depth * 2 + 2, "", scope.Name.c_str(), scope.Milliseconds);
+		}
+	}
+}
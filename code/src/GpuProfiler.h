@@ -0,0 +1,86 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vector>
+#include <string>
+#include "Globals.h"
+
+namespace vkmmc
+{
+	struct RenderContext;
+
+	// GPU cost of a pass or of a renderer inside a pass.
+	struct GpuProfileScope
+	{
+		std::string Name;
+		// 0 for passes, 1 for the renderers of the pass above.
+		uint32_t Depth = 0;
+		double Milliseconds = 0.0;
+		// Zero when the device does not support pipeline statistics queries.
+		uint64_t VertexInvocations = 0;
+		uint64_t FragmentInvocations = 0;
+	};
+
+	/**
+	 * Timestamp and pipeline statistics queries around passes and renderers. Each frame in flight has its own
+	 * query pools, read back without waiting when its fence has signaled, so results are some frames late.
+	 */
+	class GpuProfiler
+	{
+		struct FrameQueries
+		{
+			VkQueryPool TimestampPool{ VK_NULL_HANDLE };
+			VkQueryPool StatisticsPool{ VK_NULL_HANDLE };
+			// Scope i writes timestamps 2i and 2i + 1.
+			std::vector<GpuProfileScope> Scopes;
+			// Scope of each statistics query.
+			std::vector<uint32_t> StatisticsScopes;
+			// Frame counter of the frame recorded with these queries.
+			uint32_t Frame{ 0 };
+			bool Recorded{ false };
+		};
+	public:
+		static constexpr uint32_t InvalidQuery = UINT32_MAX;
+		static constexpr uint32_t InvalidFrame = UINT32_MAX;
+
+		void Init(const RenderContext& renderContext);
+		void Destroy(const RenderContext& renderContext);
+		inline bool IsEnabled() const { return m_timestampPeriod > 0.0; }
+		inline bool HasPipelineStatistics() const { return m_statistics; }
+
+		// Frame fence has signaled. Resolve the queries of the previous use of the slot.
+		// frameCounter: frame about to be recorded, results are tagged with it.
+		void BeginFrame(const RenderContext& renderContext, uint32_t frameIndex, uint32_t frameCounter);
+		// Record in the primary command buffer before any scope, outside render passes.
+		void ResetQueries(VkCommandBuffer cmd);
+		// Main thread, before recording. Return InvalidQuery when disabled or out of queries.
+		uint32_t AddScope(const char* name, uint32_t depth);
+		uint32_t AddStatisticsQuery(uint32_t scope);
+
+		// Thread safe. Invalid scopes and queries are ignored.
+		void WriteBeginTimestamp(VkCommandBuffer cmd, uint32_t scope) const;
+		void WriteEndTimestamp(VkCommandBuffer cmd, uint32_t scope) const;
+		void BeginStatistics(VkCommandBuffer cmd, uint32_t query) const;
+		void EndStatistics(VkCommandBuffer cmd, uint32_t query) const;
+
+		// Latest resolved frame.
+		inline const std::vector<GpuProfileScope>& GetResults() const { return m_results; }
+		// Frame counter of the results, InvalidFrame before the first one resolves.
+		inline uint32_t GetResultsFrame() const { return m_resultsFrame; }
+		double GetFrameMilliseconds() const;
+		void ImGuiDraw() const;
+
+	private:
+		FrameQueries m_frames[globals::MaxOverlappedFrames];
+		uint32_t m_frameIndex{ 0 };
+		// Nanoseconds per tick, 0 when timestamps are not supported.
+		double m_timestampPeriod{ 0.0 };
+		uint64_t m_timestampMask{ 0 };
+		bool m_statistics{ false };
+		std::vector<GpuProfileScope> m_results;
+		uint32_t m_resultsFrame{ InvalidFrame };
+	};
+}
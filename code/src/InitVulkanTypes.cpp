@@ -235,7 +235,7 @@ namespace vkmmc
 			return info;
 		}
 
-		VkImageCreateInfo ImageCreateInfo(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent, uint32_t arrayLayers)
+		VkImageCreateInfo ImageCreateInfo(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent, uint32_t arrayLayers, uint32_t mipLevels)
 		{
 			VkImageCreateInfo info = {};
 			info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -244,7 +244,7 @@ namespace vkmmc
 			info.imageType = VK_IMAGE_TYPE_2D;
 			info.format = format;
 			info.extent = extent;
-			info.mipLevels = 1;
+			info.mipLevels = mipLevels;
 			info.arrayLayers = arrayLayers;
 			info.samples = VK_SAMPLE_COUNT_1_BIT;
 			info.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -3,8 +3,11 @@
 #include <cstdio>
 #include <stdarg.h>
 #include <string>
+#include <mutex>
+#ifdef _WIN32
 #include <Windows.h>
 #include <debugapi.h>
+#endif
 
 #define ANSI_RESET_ALL          "\x1b[0m"
 
@@ -151,6 +154,8 @@ namespace vkmmc
 	};
 
 	LogHtmlFile* GLogFile = nullptr;
+	// Logs are pushed from worker threads too.
+	std::mutex GLogMutex;
 
 	
 
@@ -166,8 +171,11 @@ namespace vkmmc
 		case LogLevel::Ok:
 		case LogLevel::Warn:
 		case LogLevel::Error:
+			std::lock_guard<std::mutex> lock(GLogMutex);
 			printf("%s[%s]%s %s%s", ANSI_COLOR_CYAN, LogLevelToStr(level), LogLevelFormat(level), msg, ANSI_RESET_ALL);
+#ifdef _WIN32
 			OutputDebugString(msg);
+#endif
 			GLogFile->Push(level, msg);
 		}
 	}
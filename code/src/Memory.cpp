@@ -3,12 +3,47 @@
 #define VMA_IMPLEMENTATION
 #include "Memory.h"
 #include "Debug.h"
-#include <corecrt_memory.h>
+#include <cstring>
 #include "InitVulkanTypes.h"
 #include "RenderTypes.h"
+#include "FrameMetrics.h"
 
 namespace memapi
 {
+	vkmmc::EMemCategory GetBufferCategory(VkBufferUsageFlags usage)
+	{
+		if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) return vkmmc::MEMORY_CATEGORY_VERTEX;
+		if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) return vkmmc::MEMORY_CATEGORY_INDEX;
+		if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return vkmmc::MEMORY_CATEGORY_UNIFORM;
+		if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) return vkmmc::MEMORY_CATEGORY_STORAGE;
+		if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT) return vkmmc::MEMORY_CATEGORY_STAGING;
+		return vkmmc::MEMORY_CATEGORY_OTHER;
+	}
+
+	vkmmc::EMemCategory GetImageCategory(VkImageUsageFlags usage)
+	{
+		if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+			return vkmmc::MEMORY_CATEGORY_ATTACHMENT;
+		return vkmmc::MEMORY_CATEGORY_TEXTURE;
+	}
+
+	void TrackAllocation(vkmmc::Allocator* allocator, const vkmmc::Allocation& allocation)
+	{
+		vkmmc::MemoryCategoryStats& stats = allocator->Categories[allocation.Category];
+		stats.Size += allocation.Size;
+		++stats.LiveCount;
+		++stats.AllocationCount;
+	}
+
+	void TrackFree(vkmmc::Allocator* allocator, const vkmmc::Allocation& allocation)
+	{
+		vkmmc::MemoryCategoryStats& stats = allocator->Categories[allocation.Category];
+		check(stats.LiveCount > 0 && stats.Size >= allocation.Size);
+		stats.Size -= allocation.Size;
+		--stats.LiveCount;
+		++stats.FreeCount;
+	}
+
 #ifndef VKMMC_MEM_MANAGEMENT
 	VmaMemoryUsage GetMemUsage(vkmmc::EMemUsage memUsage)
 	{
@@ -24,6 +59,21 @@ namespace memapi
 		check(false && "MemUsage not valid");
 		return VMA_MEMORY_USAGE_UNKNOWN;
 	}
+
+	VmaAllocationCreateFlags GetAllocationFlags(vkmmc::EMemUsage memUsage)
+	{
+		// Host visible memory is mapped for the whole life of the allocation.
+		switch (memUsage)
+		{
+		case vkmmc::MEMORY_USAGE_CPU:
+		case vkmmc::MEMORY_USAGE_CPU_COPY:
+		case vkmmc::MEMORY_USAGE_CPU_TO_GPU:
+		case vkmmc::MEMORY_USAGE_GPU_TO_CPU:
+			return VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		default:
+			return 0;
+		}
+	}
 #else
 	VkMemoryPropertyFlags GetMemPropertyFlags(vkmmc::EMemUsage memUsage)
 	{
@@ -53,28 +103,78 @@ namespace memapi
 		}
 		return flags;
 	}
+
+	// Images from this size get their own device memory.
+	constexpr VkDeviceSize DedicatedImageSize = 64ull * 1024 * 1024;
+
+	uint32_t FindMemoryType(const VkPhysicalDeviceMemoryProperties& properties, uint32_t filter, VkMemoryPropertyFlags flags)
+	{
+		for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+		{
+			if (filter & BIT_N(i)
+				&& (properties.memoryTypes[i].propertyFlags & flags) == flags)
+			{
+				return i;
+			}
+		}
+		check(false && "Unknown memory type.");
+		return 0;
+	}
+
+	void SetAllocation(vkmmc::Allocation& allocation, const vkmmc::DeviceMemoryAllocator::Result& result)
+	{
+		allocation.Alloc = result.Memory;
+		allocation.Offset = result.Offset;
+		allocation.Size = result.Size;
+		allocation.Block = result.Block;
+		allocation.Node = result.Node;
+		allocation.MemoryType = result.MemoryType;
+		allocation.Mapped = result.Mapped;
+	}
+
+	vkmmc::DeviceMemoryAllocator::Result GetResult(const vkmmc::Allocation& allocation)
+	{
+		vkmmc::DeviceMemoryAllocator::Result result;
+		result.Memory = allocation.Alloc;
+		result.Offset = allocation.Offset;
+		result.Size = allocation.Size;
+		result.Block = allocation.Block;
+		result.Node = allocation.Node;
+		result.MemoryType = allocation.MemoryType;
+		result.Mapped = allocation.Mapped;
+		return result;
+	}
+
+	void FreeAllocation(vkmmc::Allocator* allocator, const vkmmc::Allocation& allocation)
+	{
+		allocator->DeviceMemory.Free(GetResult(allocation));
+	}
 #endif // !VKMMC_MEM_MANAGEMENT
 
 }
 
 namespace vkmmc
 {
-	void Memory::Init(Allocator*& allocator, VkInstance vkInstance, VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice)
+	void Memory::Init(Allocator*& allocator, VkInstance vkInstance, VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice, bool memoryBudget)
 	{
 		check(vkInstance != VK_NULL_HANDLE);
 		check(vkPhysicalDevice != VK_NULL_HANDLE);
 		check(vkDevice != VK_NULL_HANDLE);
 		check(!allocator);
 		allocator = new Allocator();
+		allocator->Device = vkDevice;
+		allocator->PhysicalDevice = vkPhysicalDevice;
+		allocator->MemoryBudget = memoryBudget;
 #ifndef VKMMC_MEM_MANAGEMENT
 		VmaAllocatorCreateInfo allocatorInfo = {};
+		if (memoryBudget)
+			allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 		allocatorInfo.physicalDevice = vkPhysicalDevice;
 		allocatorInfo.device = vkDevice;
 		allocatorInfo.instance = vkInstance;
 		vmaCreateAllocator(&allocatorInfo, &allocator->AllocatorInstance);
 #else
-		allocator->Device = vkDevice;
-		allocator->PhysicalDevice = vkPhysicalDevice;
+		allocator->DeviceMemory.Init(vkDevice, vkPhysicalDevice);
 #endif // !VKMMC_MEM_MANAGEMENT
 
 	}
@@ -82,8 +182,13 @@ namespace vkmmc
 	void Memory::Destroy(Allocator*& allocator)
 	{
 #ifndef VKMMC_MEM_MANAGEMENT
-		vmaDestroyAllocator(allocator.AllocatorInstance);
-		allocator.AllocatorInstance = VK_NULL_HANDLE;
+		vmaDestroyAllocator(allocator->AllocatorInstance);
+		allocator->AllocatorInstance = VK_NULL_HANDLE;
+#else
+		DeviceMemoryStats stats = allocator->DeviceMemory.GetStats();
+		Logf(LogLevel::Info, "Device memory: %u blocks, %.2f MB allocated, %.2f MB in use.\n",
+			stats.BlockCount, (double)stats.AllocatedSize / (1024.0 * 1024.0), (double)stats.UsedSize / (1024.0 * 1024.0));
+		allocator->DeviceMemory.Destroy();
 #endif
 		delete allocator;
 		allocator = nullptr;
@@ -150,26 +255,40 @@ namespace vkmmc
 #ifndef VKMMC_MEM_MANAGEMENT
 		VmaAllocationCreateInfo allocInfo
 		{
+			.flags = memapi::GetAllocationFlags(memUsage),
 			.usage = memapi::GetMemUsage(memUsage)
 		};
-		vkcheck(vmaCreateBuffer(allocator.AllocatorInstance, &bufferInfo, &allocInfo,
-			&newBuffer.Buffer, &newBuffer.Alloc, nullptr));
+		VmaAllocationInfo info;
+		vkcheck(vmaCreateBuffer(allocator->AllocatorInstance, &bufferInfo, &allocInfo,
+			&newBuffer.Buffer, &newBuffer.Alloc, &info));
+		newBuffer.Mapped = info.pMappedData;
+		newBuffer.Size = info.size;
 #else
 		vkcheck(vkCreateBuffer(allocator->Device, &bufferInfo, nullptr, &newBuffer.Buffer));
-		newBuffer.Alloc = Allocate(allocator, newBuffer.Buffer, memapi::GetMemPropertyFlags(memUsage));
-		vkcheck(vkBindBufferMemory(allocator->Device, newBuffer.Buffer, newBuffer.Alloc, 0));
+		VkMemoryDedicatedRequirements dedicatedReq{ .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS, .pNext = nullptr };
+		VkMemoryRequirements2 req{ .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2, .pNext = &dedicatedReq };
+		VkBufferMemoryRequirementsInfo2 reqInfo{ .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2, .pNext = nullptr, .buffer = newBuffer.Buffer };
+		vkGetBufferMemoryRequirements2(allocator->Device, &reqInfo, &req);
+		const uint32_t memoryType = memapi::FindMemoryType(allocator->DeviceMemory.GetMemoryProperties(),
+			req.memoryRequirements.memoryTypeBits, memapi::GetMemPropertyFlags(memUsage));
+		memapi::SetAllocation(newBuffer, allocator->DeviceMemory.Allocate(req.memoryRequirements, memoryType,
+			DeviceMemoryAllocator::RESOURCE_LINEAR, dedicatedReq.requiresDedicatedAllocation, newBuffer.Buffer, VK_NULL_HANDLE));
+		vkcheck(vkBindBufferMemory(allocator->Device, newBuffer.Buffer, newBuffer.Alloc, newBuffer.Offset));
 #endif // !VKMMC_MEM_MANAGEMENT
+		newBuffer.Category = memapi::GetBufferCategory(usageFlags);
+		memapi::TrackAllocation(allocator, newBuffer);
 
 		return newBuffer;
 	}
 
 	void Memory::DestroyBuffer(Allocator* allocator, AllocatedBuffer buffer)
 	{
+		memapi::TrackFree(allocator, buffer);
 #ifndef VKMMC_MEM_MANAGEMENT
-		vmaDestroyBuffer(allocator.AllocatorInstance, buffer.Buffer, buffer.Alloc);
+		vmaDestroyBuffer(allocator->AllocatorInstance, buffer.Buffer, buffer.Alloc);
 #else
-		Free(allocator, buffer.Alloc);
 		vkDestroyBuffer(allocator->Device, buffer.Buffer, nullptr);
+		memapi::FreeAllocation(allocator, buffer);
 #endif // !VKMMC_MEM_MANAGEMENT
 
 	}
@@ -179,17 +298,23 @@ namespace vkmmc
 		check(allocation.IsAllocated());
 		check(source && cpySize > 0);
 		check(srcOffset < cpySize);
-		void* data;
+		check(allocation.Mapped && "Allocation is not host visible.");
 		const char* pSrc = reinterpret_cast<const char*>(source);
-#ifndef VKMMC_MEM_MANAGEMENT
-		vkcheck(vmaMapMemory(allocator.AllocatorInstance, allocation.Alloc, &data));
-		char* pData = reinterpret_cast<char*>(data);
+		char* pData = reinterpret_cast<char*>(allocation.Mapped);
+#ifdef VKMMC_MEM_MANAGEMENT
+		check(dstOffset + cpySize <= allocation.Size);
+#endif // VKMMC_MEM_MANAGEMENT
 		memcpy_s(pData + dstOffset, cpySize, pSrc + srcOffset, cpySize);
-		vmaUnmapMemory(allocator.AllocatorInstance, allocation.Alloc);
+		Flush(allocator, allocation, dstOffset, cpySize);
+		GRenderStats.UploadBytes += cpySize;
+	}
+
+	void Memory::Flush(Allocator* allocator, const Allocation& allocation, size_t offset, size_t size)
+	{
+#ifndef VKMMC_MEM_MANAGEMENT
+		vkcheck(vmaFlushAllocation(allocator->AllocatorInstance, allocation.Alloc, offset, size));
 #else
-		vkcheck(vkMapMemory(allocator->Device, allocation.Alloc, dstOffset, cpySize, 0, &data));
-		memcpy_s(data, cpySize, pSrc + srcOffset, cpySize);
-		vkUnmapMemory(allocator->Device, allocation.Alloc);
+		allocator->DeviceMemory.Flush(memapi::GetResult(allocation), offset, size);
 #endif // !VKMMC_MEM_MANAGEMENT
 	}
 
@@ -207,27 +332,43 @@ namespace vkmmc
 #ifndef VKMMC_MEM_MANAGEMENT
 		VmaAllocationCreateInfo allocInfo
 		{
-			.usage = memapi::GetMemUsage(memUsage),
-			.requiredFlags = memProperties
+			.flags = memapi::GetAllocationFlags(memUsage),
+			.usage = memapi::GetMemUsage(memUsage)
 		};
-		vkcheck(vmaCreateImage(allocator.AllocatorInstance, &imageInfo, &allocInfo,
-			&image.Image, &image.Alloc, nullptr));
+		VmaAllocationInfo info;
+		vkcheck(vmaCreateImage(allocator->AllocatorInstance, &imageInfo, &allocInfo,
+			&image.Image, &image.Alloc, &info));
+		image.Mapped = info.pMappedData;
+		image.Size = info.size;
 #else
 		vkcheck(vkCreateImage(allocator->Device, &imageInfo, nullptr, &image.Image));
-		image.Alloc = Allocate(allocator, image.Image, memapi::GetMemPropertyFlags(memUsage));
-		vkcheck(vkBindImageMemory(allocator->Device, image.Image, image.Alloc, 0));
+		VkMemoryDedicatedRequirements dedicatedReq{ .sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS, .pNext = nullptr };
+		VkMemoryRequirements2 req{ .sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2, .pNext = &dedicatedReq };
+		VkImageMemoryRequirementsInfo2 reqInfo{ .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2, .pNext = nullptr, .image = image.Image };
+		vkGetImageMemoryRequirements2(allocator->Device, &reqInfo, &req);
+		const uint32_t memoryType = memapi::FindMemoryType(allocator->DeviceMemory.GetMemoryProperties(),
+			req.memoryRequirements.memoryTypeBits, memapi::GetMemPropertyFlags(memUsage));
+		const bool dedicated = dedicatedReq.requiresDedicatedAllocation || req.memoryRequirements.size >= memapi::DedicatedImageSize;
+		const DeviceMemoryAllocator::EResourceType resourceType = imageInfo.tiling == VK_IMAGE_TILING_LINEAR ?
+			DeviceMemoryAllocator::RESOURCE_LINEAR : DeviceMemoryAllocator::RESOURCE_OPTIMAL;
+		memapi::SetAllocation(image, allocator->DeviceMemory.Allocate(req.memoryRequirements, memoryType,
+			resourceType, dedicated, VK_NULL_HANDLE, image.Image));
+		vkcheck(vkBindImageMemory(allocator->Device, image.Image, image.Alloc, image.Offset));
 #endif // !VKMMC_MEM_MANAGEMENT
+		image.Category = memapi::GetImageCategory(imageInfo.usage);
+		memapi::TrackAllocation(allocator, image);
 
 		return image;
 	}
 
 	void Memory::DestroyImage(Allocator* allocator, AllocatedImage image)
 	{
+		memapi::TrackFree(allocator, image);
 #ifndef VKMMC_MEM_MANAGEMENT
-		vmaDestroyImage(allocator.AllocatorInstance, image.Image, image.Alloc);
+		vmaDestroyImage(allocator->AllocatorInstance, image.Image, image.Alloc);
 #else
-		Free(allocator, image.Alloc);
 		vkDestroyImage(allocator->Device, image.Image, nullptr);
+		memapi::FreeAllocation(allocator, image);
 #endif // !VKMMC_MEM_MANAGEMENT
 
 	}
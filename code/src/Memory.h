@@ -7,6 +7,7 @@
 #include <vk_mem_alloc.h>
 #else
 #include <vulkan/vulkan.h>
+#include "DeviceMemoryAllocator.h"
 #endif
 
 namespace vkmmc
@@ -21,13 +22,41 @@ namespace vkmmc
 		MEMORY_USAGE_GPU_TO_CPU,
 	};
 
+	// What the memory is used for, deduced from resource usage flags. Telemetry only.
+	enum EMemCategory : uint8_t
+	{
+		MEMORY_CATEGORY_VERTEX,
+		MEMORY_CATEGORY_INDEX,
+		MEMORY_CATEGORY_UNIFORM,
+		MEMORY_CATEGORY_STORAGE,
+		MEMORY_CATEGORY_TEXTURE,
+		MEMORY_CATEGORY_ATTACHMENT,
+		MEMORY_CATEGORY_STAGING,
+		MEMORY_CATEGORY_OTHER,
+		MEMORY_CATEGORY_COUNT
+	};
+
+	struct MemoryCategoryStats
+	{
+		// Memory of live resources.
+		VkDeviceSize Size = 0;
+		uint32_t LiveCount = 0;
+		// Since init.
+		uint64_t AllocationCount = 0;
+		uint64_t FreeCount = 0;
+	};
+
 	struct Allocator
 	{
+		VkDevice Device;
+		VkPhysicalDevice PhysicalDevice;
+		// VK_EXT_memory_budget enabled in device.
+		bool MemoryBudget;
+		MemoryCategoryStats Categories[MEMORY_CATEGORY_COUNT];
 #ifndef VKMMC_MEM_MANAGEMENT
 		VmaAllocator AllocatorInstance;
 #else
-		VkDevice Device;
-		VkPhysicalDevice PhysicalDevice;
+		DeviceMemoryAllocator DeviceMemory;
 #endif
 	};
 
@@ -37,7 +66,18 @@ namespace vkmmc
 		VmaAllocation Alloc{ nullptr };
 #else
 		VkDeviceMemory Alloc{ nullptr };
+		// Offset in the device memory owned by the resource.
+		VkDeviceSize Offset{ 0 };
+		// Sub-allocation in a memory block, null for dedicated allocations.
+		MemoryBlock* Block{ nullptr };
+		uint32_t Node{ 0 };
+		uint32_t MemoryType{ 0 };
 #endif // !VKMMC_MEM_MANAGEMENT
+		// Memory owned by the resource.
+		VkDeviceSize Size{ 0 };
+		EMemCategory Category{ MEMORY_CATEGORY_OTHER };
+		// Host visible allocations stay mapped while they live. Null for device only memory.
+		void* Mapped{ nullptr };
 		inline bool IsAllocated() const { return Alloc != nullptr; }
 	};
 
@@ -57,13 +97,14 @@ namespace vkmmc
 
 		/**
 		 */
-		static void Init(Allocator*& allocator, VkInstance vkInstance, VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice);
+		static void Init(Allocator*& allocator, VkInstance vkInstance, VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice, bool memoryBudget);
 		static void Destroy(Allocator*& allocator);
 
 		/**
 		 * Common
 		 */
 		static uint32_t FindMemoryType(VkPhysicalDevice physicalDevice, uint32_t filter, VkMemoryPropertyFlags flags);
+		// Dedicated allocations of a whole VkDeviceMemory.
 		static VkDeviceMemory Allocate(Allocator* allocator, VkBuffer buffer, VkMemoryPropertyFlags memoryProperties);
 		static VkDeviceMemory Allocate(Allocator* allocator, VkImage image, VkMemoryPropertyFlags memoryProperties);
 		static void Free(Allocator* allocator, VkDeviceMemory memory);
@@ -73,8 +114,10 @@ namespace vkmmc
 		 */
 		static AllocatedBuffer CreateBuffer(Allocator* allocator, VkDeviceSize bufferSize, VkBufferUsageFlags usageFlags, EMemUsage memUsage);
 		static void DestroyBuffer(Allocator* allocator, AllocatedBuffer buffer);
-		// Copy cpu data to buffer.
+		// Copy cpu data to buffer through its persistent mapping and flush the range.
 		static void MemCopy(Allocator* allocator, Allocation allocation, const void* source, size_t cpySize, size_t dstOffset = 0, size_t srcOffset = 0);
+		// Make writes done through allocation.Mapped visible to the device. No driver call with coherent memory.
+		static void Flush(Allocator* allocator, const Allocation& allocation, size_t offset, size_t size);
 
 		static uint32_t PadOffsetAlignment(uint32_t minOffsetAlignment, uint32_t objectSize);
 
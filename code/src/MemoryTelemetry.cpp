@@ -0,0 +1,187 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "MemoryTelemetry.h"
+#include "Debug.h"
+#include <cstdio>
+#include <imgui/imgui.h>
+
+namespace memapi
+{
+	inline double ToMB(VkDeviceSize size) { return (double)size / (1024.0 * 1024.0); }
+}
+
+namespace vkmmc
+{
+	MemoryTelemetry MemoryTelemetry::Gather(const Allocator* allocator)
+	{
+		check(allocator);
+		MemoryTelemetry telemetry;
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT, .pNext = nullptr };
+		VkPhysicalDeviceMemoryProperties2 properties2{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2, .pNext = nullptr };
+		if (allocator->MemoryBudget)
+			properties2.pNext = &budgetProperties;
+		vkGetPhysicalDeviceMemoryProperties2(allocator->PhysicalDevice, &properties2);
+		const VkPhysicalDeviceMemoryProperties& properties = properties2.memoryProperties;
+		telemetry.HasBudget = allocator->MemoryBudget;
+
+		telemetry.Heaps.resize(properties.memoryHeapCount);
+		for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+		{
+			telemetry.Heaps[i].Size = properties.memoryHeaps[i].size;
+			telemetry.Heaps[i].Flags = properties.memoryHeaps[i].flags;
+		}
+		telemetry.Types.resize(properties.memoryTypeCount);
+#ifndef VKMMC_MEM_MANAGEMENT
+		VmaStats stats;
+		vmaCalculateStats(allocator->AllocatorInstance, &stats);
+		VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+		vmaGetBudget(allocator->AllocatorInstance, budgets);
+		VkDeviceSize freeSize = 0;
+		VkDeviceSize largestFreeRange = 0;
+		for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+		{
+			const VmaStatInfo& info = stats.memoryType[i];
+			MemoryTypeTelemetry& type = telemetry.Types[i];
+			type.BlockCount = info.blockCount;
+			type.AllocationCount = info.allocationCount;
+			type.AllocatedSize = info.usedBytes + info.unusedBytes;
+			type.UsedSize = info.usedBytes;
+			type.Fragmentation = info.unusedBytes ? 1.f - (float)info.unusedRangeSizeMax / (float)info.unusedBytes : 0.f;
+			freeSize += info.unusedBytes;
+			largestFreeRange = __max(largestFreeRange, info.unusedRangeSizeMax);
+		}
+		telemetry.Fragmentation = freeSize ? 1.f - (float)largestFreeRange / (float)freeSize : 0.f;
+		for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+		{
+			telemetry.Heaps[i].Budget = budgets[i].budget;
+			telemetry.Heaps[i].Usage = budgets[i].usage;
+		}
+#else
+		for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+		{
+			const DeviceMemoryStats stats = allocator->DeviceMemory.GetStats(i);
+			MemoryTypeTelemetry& type = telemetry.Types[i];
+			type.BlockCount = stats.BlockCount;
+			type.AllocationCount = stats.AllocationCount + stats.DedicatedAllocationCount;
+			type.AllocatedSize = stats.AllocatedSize;
+			type.UsedSize = stats.UsedSize;
+			type.Fragmentation = stats.Fragmentation;
+		}
+		telemetry.Fragmentation = allocator->DeviceMemory.GetStats().Fragmentation;
+#endif // !VKMMC_MEM_MANAGEMENT
+
+		for (uint32_t i = 0; i < properties.memoryTypeCount; ++i)
+		{
+			MemoryTypeTelemetry& type = telemetry.Types[i];
+			type.Flags = properties.memoryTypes[i].propertyFlags;
+			type.HeapIndex = properties.memoryTypes[i].heapIndex;
+			telemetry.Heaps[type.HeapIndex].AllocatedSize += type.AllocatedSize;
+			telemetry.Heaps[type.HeapIndex].UsedSize += type.UsedSize;
+			telemetry.AllocatedSize += type.AllocatedSize;
+			telemetry.UsedSize += type.UsedSize;
+		}
+#ifdef VKMMC_MEM_MANAGEMENT
+		for (uint32_t i = 0; i < properties.memoryHeapCount; ++i)
+		{
+			MemoryHeapTelemetry& heap = telemetry.Heaps[i];
+			heap.Budget = telemetry.HasBudget ? budgetProperties.heapBudget[i] : heap.Size;
+			heap.Usage = telemetry.HasBudget ? budgetProperties.heapUsage[i] : heap.AllocatedSize;
+		}
+#endif // VKMMC_MEM_MANAGEMENT
+
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		{
+			telemetry.Categories[i] = allocator->Categories[i];
+			telemetry.AllocationCount += allocator->Categories[i].AllocationCount;
+			telemetry.FreeCount += allocator->Categories[i].FreeCount;
+		}
+		return telemetry;
+	}
+
+	const char* MemoryTelemetry::GetCategoryName(EMemCategory category)
+	{
+		switch (category)
+		{
+		case MEMORY_CATEGORY_VERTEX: return "Vertex";
+		case MEMORY_CATEGORY_INDEX: return "Index";
+		case MEMORY_CATEGORY_UNIFORM: return "Uniform";
+		case MEMORY_CATEGORY_STORAGE: return "Storage";
+		case MEMORY_CATEGORY_TEXTURE: return "Texture";
+		case MEMORY_CATEGORY_ATTACHMENT: return "Attachment";
+		case MEMORY_CATEGORY_STAGING: return "Staging";
+		case MEMORY_CATEGORY_OTHER: return "Other";
+		}
+		check(false && "Invalid memory category.");
+		return "Unknown";
+	}
+
+	bool MemoryTelemetry::WriteJson(const char* filepath) const
+	{
+		FILE* file = nullptr;
+		if (fopen_s(&file, filepath, "w") || !file)
+		{
+			Logf(LogLevel::Error, "Failed to open %s to write memory telemetry.\n", filepath);
+			return false;
+		}
+		fprintf_s(file, "{\n");
+		fprintf_s(file, "\t\"hasBudget\": %s,\n", HasBudget ? "true" : "false");
+		fprintf_s(file, "\t\"allocatedBytes\": %llu,\n", (unsigned long long)AllocatedSize);
+		fprintf_s(file, "\t\"usedBytes\": %llu,\n", (unsigned long long)UsedSize);
+		fprintf_s(file, "\t\"allocationCount\": %llu,\n", (unsigned long long)AllocationCount);
+		fprintf_s(file, "\t\"freeCount\": %llu,\n", (unsigned long long)FreeCount);
+		fprintf_s(file, "\t\"fragmentation\": %.4f,\n", Fragmentation);
+		fprintf_s(file, "\t\"heaps\": [\n");
+		for (size_t i = 0; i < Heaps.size(); ++i)
+		{
+			const MemoryHeapTelemetry& heap = Heaps[i];
+			fprintf_s(file, "\t\t{ \"index\": %zu, \"size\": %llu, \"deviceLocal\": %s, \"allocatedBytes\": %llu, \"usedBytes\": %llu, \"budget\": %llu, \"usage\": %llu }%s\n",
+				i, (unsigned long long)heap.Size, heap.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? "true" : "false",
+				(unsigned long long)heap.AllocatedSize, (unsigned long long)heap.UsedSize,
+				(unsigned long long)heap.Budget, (unsigned long long)heap.Usage, i + 1 < Heaps.size() ? "," : "");
+		}
+		fprintf_s(file, "\t],\n");
+		fprintf_s(file, "\t\"types\": [\n");
+		for (size_t i = 0; i < Types.size(); ++i)
+		{
+			const MemoryTypeTelemetry& type = Types[i];
+			fprintf_s(file, "\t\t{ \"index\": %zu, \"heap\": %u, \"flags\": %u, \"blockCount\": %u, \"allocationCount\": %u, \"allocatedBytes\": %llu, \"usedBytes\": %llu, \"fragmentation\": %.4f }%s\n",
+				i, type.HeapIndex, type.Flags, type.BlockCount, type.AllocationCount,
+				(unsigned long long)type.AllocatedSize, (unsigned long long)type.UsedSize, type.Fragmentation, i + 1 < Types.size() ? "," : "");
+		}
+		fprintf_s(file, "\t],\n");
+		fprintf_s(file, "\t\"categories\": {\n");
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		{
+			const MemoryCategoryStats& category = Categories[i];
+			fprintf_s(file, "\t\t\"%s\": { \"bytes\": %llu, \"liveCount\": %u, \"allocationCount\": %llu, \"freeCount\": %llu }%s\n",
+				GetCategoryName((EMemCategory)i), (unsigned long long)category.Size, category.LiveCount,
+				(unsigned long long)category.AllocationCount, (unsigned long long)category.FreeCount, i + 1 < MEMORY_CATEGORY_COUNT ? "," : "");
+		}
+		fprintf_s(file, "\t}\n");
+		fprintf_s(file, "}\n");
+		fclose(file);
+		Logf(LogLevel::Info, "Memory telemetry written to %s.\n", filepath);
+		return true;
+	}
+
+	void MemoryTelemetry::ImGuiDraw() const
+	{
+		ImGui::Text("Device memory: %.2f / %.2f MB (frag %.2f)", memapi::ToMB(UsedSize), memapi::ToMB(AllocatedSize), Fragmentation);
+		for (size_t i = 0; i < Heaps.size(); ++i)
+		{
+			const MemoryHeapTelemetry& heap = Heaps[i];
+			if (!heap.AllocatedSize && !heap.Usage)
+				continue;
+			ImGui::Text("Heap %zu%s: %.2f MB (usage %.2f / %.2f MB)", i,
+				heap.Flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? " [local]" : "",
+				memapi::ToMB(heap.AllocatedSize), memapi::ToMB(heap.Usage), memapi::ToMB(heap.Budget));
+		}
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		{
+			if (Categories[i].LiveCount)
+				ImGui::Text("  %s: %u (%.2f MB)", GetCategoryName((EMemCategory)i), Categories[i].LiveCount, memapi::ToMB(Categories[i].Size));
+		}
+		ImGui::Text("Allocations: %llu, frees: %llu", (unsigned long long)AllocationCount, (unsigned long long)FreeCount);
+	}
+}
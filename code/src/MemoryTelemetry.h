@@ -0,0 +1,56 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include "Memory.h"
+#include <vector>
+
+namespace vkmmc
+{
+	struct MemoryHeapTelemetry
+	{
+		VkDeviceSize Size = 0;
+		VkMemoryHeapFlags Flags = 0;
+		// Memory allocated from the heap by the engine and the part of it used by resources.
+		VkDeviceSize AllocatedSize = 0;
+		VkDeviceSize UsedSize = 0;
+		// From VK_EXT_memory_budget, usage includes other processes. Heap size and engine allocations without the extension.
+		VkDeviceSize Budget = 0;
+		VkDeviceSize Usage = 0;
+	};
+
+	struct MemoryTypeTelemetry
+	{
+		VkMemoryPropertyFlags Flags = 0;
+		uint32_t HeapIndex = 0;
+		uint32_t BlockCount = 0;
+		uint32_t AllocationCount = 0;
+		VkDeviceSize AllocatedSize = 0;
+		VkDeviceSize UsedSize = 0;
+		float Fragmentation = 0.f;
+	};
+
+	/**
+	 * Snapshot of the device memory used by the engine, per heap, memory type and resource category.
+	 */
+	struct MemoryTelemetry
+	{
+		bool HasBudget = false;
+		std::vector<MemoryHeapTelemetry> Heaps;
+		std::vector<MemoryTypeTelemetry> Types;
+		MemoryCategoryStats Categories[MEMORY_CATEGORY_COUNT];
+		// Totals
+		VkDeviceSize AllocatedSize = 0;
+		VkDeviceSize UsedSize = 0;
+		uint64_t AllocationCount = 0;
+		uint64_t FreeCount = 0;
+		float Fragmentation = 0.f;
+
+		static MemoryTelemetry Gather(const Allocator* allocator);
+		static const char* GetCategoryName(EMemCategory category);
+
+		bool WriteJson(const char* filepath) const;
+		void ImGuiDraw() const;
+	};
+}
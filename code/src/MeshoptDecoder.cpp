@@ -0,0 +1,429 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "MeshoptDecoder.h"
+#include "Debug.h"
+#include <cstring>
+#include <cmath>
+
+namespace meshopt_internal
+{
+	constexpr uint8_t VertexHeader = 0xa0;
+	constexpr uint8_t IndexHeader = 0xe0;
+	constexpr uint8_t SequenceHeader = 0xd0;
+
+	constexpr size_t VertexBlockSizeBytes = 8192;
+	constexpr size_t VertexBlockMaxSize = 256;
+	constexpr size_t ByteGroupSize = 16;
+	constexpr size_t ByteGroupDecodeLimit = 24;
+	constexpr size_t TailMaxSize = 32;
+
+	size_t GetVertexBlockSize(size_t vertexSize)
+	{
+		// Blocks fit in 8Kb and hold a multiple of the group size.
+		size_t result = VertexBlockSizeBytes / vertexSize;
+		result &= ~(ByteGroupSize - 1);
+		return result < VertexBlockMaxSize ? result : VertexBlockMaxSize;
+	}
+
+	inline uint8_t Unzigzag8(uint8_t v)
+	{
+		return (uint8_t)(-(v & 1) ^ (v >> 1));
+	}
+
+	// Decode a group of 16 bytes encoded with 2^bitslog2 bits each.
+	// Values equal to the max encodable value are escaped and stored as full bytes after the group.
+	template <uint32_t Bits>
+	const uint8_t* DecodeBytesGroupBits(const uint8_t* data, uint8_t* buffer)
+	{
+		constexpr uint32_t valuesPerByte = 8 / Bits;
+		constexpr uint8_t sentinel = (1 << Bits) - 1;
+		const uint8_t* dataVar = data + ByteGroupSize / valuesPerByte;
+		for (size_t i = 0; i < ByteGroupSize / valuesPerByte; ++i)
+		{
+			uint8_t byte = data[i];
+			for (uint32_t j = 0; j < valuesPerByte; ++j)
+			{
+				uint8_t enc = byte >> (8 - Bits);
+				byte <<= Bits;
+				*buffer++ = enc == sentinel ? *dataVar : enc;
+				dataVar += enc == sentinel;
+			}
+		}
+		return dataVar;
+	}
+
+	const uint8_t* DecodeBytesGroup(const uint8_t* data, uint8_t* buffer, int bitslog2)
+	{
+		switch (bitslog2)
+		{
+		case 0: memset(buffer, 0, ByteGroupSize); return data;
+		case 1: return DecodeBytesGroupBits<2>(data, buffer);
+		case 2: return DecodeBytesGroupBits<4>(data, buffer);
+		case 3: memcpy(buffer, data, ByteGroupSize); return data + ByteGroupSize;
+		default: check(false && "Unexpected bit length."); return nullptr;
+		}
+	}
+
+	const uint8_t* DecodeBytes(const uint8_t* data, const uint8_t* dataEnd, uint8_t* buffer, size_t bufferSize)
+	{
+		check(bufferSize % ByteGroupSize == 0);
+		// 2 bits per group header, round number of groups to 4 to get number of header bytes.
+		const uint8_t* header = data;
+		size_t headerSize = (bufferSize / ByteGroupSize + 3) / 4;
+		if (size_t(dataEnd - data) < headerSize)
+			return nullptr;
+		data += headerSize;
+		for (size_t i = 0; i < bufferSize; i += ByteGroupSize)
+		{
+			if (size_t(dataEnd - data) < ByteGroupDecodeLimit)
+				return nullptr;
+			size_t headerOffset = i / ByteGroupSize;
+			int bitslog2 = (header[headerOffset / 4] >> ((headerOffset % 4) * 2)) & 3;
+			data = DecodeBytesGroup(data, buffer + i, bitslog2);
+		}
+		return data;
+	}
+
+	const uint8_t* DecodeVertexBlock(const uint8_t* data, const uint8_t* dataEnd, uint8_t* vertexData, size_t vertexCount, size_t vertexSize, uint8_t lastVertex[256])
+	{
+		check(vertexCount > 0 && vertexCount <= VertexBlockMaxSize);
+		uint8_t buffer[VertexBlockMaxSize];
+		uint8_t transposed[VertexBlockSizeBytes];
+		size_t vertexCountAligned = (vertexCount + ByteGroupSize - 1) & ~(ByteGroupSize - 1);
+
+		// Data is stored byte by byte of each vertex as zigzag deltas from the previous vertex.
+		for (size_t k = 0; k < vertexSize; ++k)
+		{
+			data = DecodeBytes(data, dataEnd, buffer, vertexCountAligned);
+			if (!data)
+				return nullptr;
+			size_t vertexOffset = k;
+			uint8_t p = lastVertex[k];
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				uint8_t v = Unzigzag8(buffer[i]) + p;
+				transposed[vertexOffset] = v;
+				p = v;
+				vertexOffset += vertexSize;
+			}
+		}
+		memcpy(vertexData, transposed, vertexCount * vertexSize);
+		memcpy(lastVertex, &transposed[vertexSize * (vertexCount - 1)], vertexSize);
+		return data;
+	}
+
+	uint32_t DecodeVByte(const uint8_t*& data)
+	{
+		uint8_t lead = *data++;
+		if (lead < 128)
+			return lead;
+		// Values up to 2^32 take 5 bytes at most.
+		uint32_t result = lead & 127;
+		uint32_t shift = 7;
+		for (int i = 0; i < 4; ++i)
+		{
+			uint8_t group = *data++;
+			result |= uint32_t(group & 127) << shift;
+			shift += 7;
+			if (group < 128)
+				break;
+		}
+		return result;
+	}
+
+	inline uint32_t DecodeIndex(const uint8_t*& data, uint32_t last)
+	{
+		uint32_t v = DecodeVByte(data);
+		uint32_t d = (v >> 1) ^ -int32_t(v & 1);
+		return last + d;
+	}
+
+	inline void WriteIndex(void* destination, size_t offset, size_t indexSize, uint32_t value)
+	{
+		if (indexSize == 2)
+			static_cast<uint16_t*>(destination)[offset] = uint16_t(value);
+		else
+			static_cast<uint32_t*>(destination)[offset] = value;
+	}
+
+	inline void WriteTriangle(void* destination, size_t offset, size_t indexSize, uint32_t a, uint32_t b, uint32_t c)
+	{
+		WriteIndex(destination, offset + 0, indexSize, a);
+		WriteIndex(destination, offset + 1, indexSize, b);
+		WriteIndex(destination, offset + 2, indexSize, c);
+	}
+
+	// Fifo pushes must match the encoder *exactly*, otherwise the stream desyncs.
+	inline void PushEdgeFifo(uint32_t fifo[16][2], uint32_t a, uint32_t b, size_t& offset)
+	{
+		fifo[offset][0] = a;
+		fifo[offset][1] = b;
+		offset = (offset + 1) & 15;
+	}
+
+	inline void PushVertexFifo(uint32_t fifo[16], uint32_t v, size_t& offset, int cond = 1)
+	{
+		fifo[offset] = v;
+		offset = (offset + cond) & 15;
+	}
+
+	inline int32_t RoundToInt(float v)
+	{
+		return int32_t(v + (v >= 0.f ? 0.5f : -0.5f));
+	}
+
+	template <typename T>
+	void DecodeFilterOct(T* data, size_t count)
+	{
+		const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Convert x and y to floats and reconstruct z. z encodes 1.0 at the same bit count.
+			float x = float(data[i * 4 + 0]);
+			float y = float(data[i * 4 + 1]);
+			float z = float(data[i * 4 + 2]) - fabsf(x) - fabsf(y);
+			// Fixup octahedral coordinates for z < 0
+			float t = z < 0.f ? z : 0.f;
+			x += x >= 0.f ? t : -t;
+			y += y >= 0.f ? t : -t;
+			// Normalize and back to signed integer range
+			float s = max / sqrtf(x * x + y * y + z * z);
+			data[i * 4 + 0] = T(RoundToInt(x * s));
+			data[i * 4 + 1] = T(RoundToInt(y * s));
+			data[i * 4 + 2] = T(RoundToInt(z * s));
+		}
+	}
+}
+
+namespace vkmmc
+{
+	bool meshopt::DecodeVertexBuffer(void* destination, size_t count, size_t stride, const uint8_t* buffer, size_t bufferSize)
+	{
+		using namespace meshopt_internal;
+		check(stride > 0 && stride <= 256 && stride % 4 == 0);
+		const uint8_t* data = buffer;
+		const uint8_t* dataEnd = buffer + bufferSize;
+		if (bufferSize < 1 + stride)
+			return false;
+		uint8_t header = *data++;
+		if ((header & 0xf0) != VertexHeader || (header & 0x0f) > 0)
+			return false;
+
+		// Baseline vertex is stored at the end of the tail block.
+		uint8_t lastVertex[256];
+		memcpy(lastVertex, dataEnd - stride, stride);
+
+		uint8_t* vertexData = static_cast<uint8_t*>(destination);
+		const size_t blockSize = GetVertexBlockSize(stride);
+		for (size_t offset = 0; offset < count; )
+		{
+			size_t size = offset + blockSize < count ? blockSize : count - offset;
+			data = DecodeVertexBlock(data, dataEnd, vertexData + offset * stride, size, stride, lastVertex);
+			if (!data)
+				return false;
+			offset += size;
+		}
+		size_t tailSize = stride < TailMaxSize ? TailMaxSize : stride;
+		return size_t(dataEnd - data) == tailSize;
+	}
+
+	bool meshopt::DecodeIndexBuffer(void* destination, size_t count, size_t indexSize, const uint8_t* buffer, size_t bufferSize)
+	{
+		using namespace meshopt_internal;
+		check(count % 3 == 0);
+		check(indexSize == 2 || indexSize == 4);
+		// Header, one code byte per triangle and 16 bytes of codeaux table.
+		if (bufferSize < 1 + count / 3 + 16)
+			return false;
+		if ((buffer[0] & 0xf0) != IndexHeader)
+			return false;
+		const int version = buffer[0] & 0x0f;
+		if (version > 1)
+			return false;
+
+		uint32_t edgeFifo[16][2];
+		memset(edgeFifo, -1, sizeof(edgeFifo));
+		uint32_t vertexFifo[16];
+		memset(vertexFifo, -1, sizeof(vertexFifo));
+		size_t edgeFifoOffset = 0;
+		size_t vertexFifoOffset = 0;
+		uint32_t next = 0;
+		uint32_t last = 0;
+		const int fecmax = version >= 1 ? 13 : 15;
+
+		const uint8_t* code = buffer + 1;
+		const uint8_t* data = code + count / 3;
+		const uint8_t* dataSafeEnd = buffer + bufferSize - 16;
+		const uint8_t* codeauxTable = dataSafeEnd;
+
+		for (size_t i = 0; i < count; i += 3)
+		{
+			if (data > dataSafeEnd)
+				return false;
+			uint8_t codetri = *code++;
+			if (codetri < 0xf0)
+			{
+				// Triangle shares an edge from the fifo.
+				int fe = codetri >> 4;
+				uint32_t a = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][0];
+				uint32_t b = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][1];
+				int fec = codetri & 15;
+				if (fec < fecmax)
+				{
+					uint32_t cf = vertexFifo[(vertexFifoOffset - 1 - fec) & 15];
+					uint32_t c = fec == 0 ? next : cf;
+					int fec0 = fec == 0;
+					next += fec0;
+					WriteTriangle(destination, i, indexSize, a, b, c);
+					PushVertexFifo(vertexFifo, c, vertexFifoOffset, fec0);
+					PushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+					PushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+				}
+				else
+				{
+					// fec - (fec ^ 3) decodes 13, 14 into -1, 1. Free indices are delta encoded against last.
+					uint32_t c = fec != 15 ? last + (fec - (fec ^ 3)) : DecodeIndex(data, last);
+					last = c;
+					WriteTriangle(destination, i, indexSize, a, b, c);
+					PushVertexFifo(vertexFifo, c, vertexFifoOffset);
+					PushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+					PushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+				}
+			}
+			else if (codetri < 0xfe)
+			{
+				// New triangle, codeaux from the table.
+				uint8_t codeaux = codeauxTable[codetri & 15];
+				int feb = codeaux >> 4;
+				int fec = codeaux & 15;
+				uint32_t a = next++;
+				uint32_t bf = vertexFifo[(vertexFifoOffset - feb) & 15];
+				uint32_t b = feb == 0 ? next : bf;
+				int feb0 = feb == 0;
+				next += feb0;
+				uint32_t cf = vertexFifo[(vertexFifoOffset - fec) & 15];
+				uint32_t c = fec == 0 ? next : cf;
+				int fec0 = fec == 0;
+				next += fec0;
+				WriteTriangle(destination, i, indexSize, a, b, c);
+				PushVertexFifo(vertexFifo, a, vertexFifoOffset);
+				PushVertexFifo(vertexFifo, b, vertexFifoOffset, feb0);
+				PushVertexFifo(vertexFifo, c, vertexFifoOffset, fec0);
+				PushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+				PushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+				PushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+			}
+			else
+			{
+				// New triangle, full codeaux byte in the data stream.
+				uint8_t codeaux = *data++;
+				int fea = codetri == 0xfe ? 0 : 15;
+				int feb = codeaux >> 4;
+				int fec = codeaux & 15;
+				// Reset: codeaux is 0 but encoded as not-a-table
+				if (codeaux == 0)
+					next = 0;
+				uint32_t a = fea == 0 ? next++ : 0;
+				uint32_t b = feb == 0 ? next++ : vertexFifo[(vertexFifoOffset - feb) & 15];
+				uint32_t c = fec == 0 ? next++ : vertexFifo[(vertexFifoOffset - fec) & 15];
+				if (fea == 15)
+					last = a = DecodeIndex(data, last);
+				if (feb == 15)
+					last = b = DecodeIndex(data, last);
+				if (fec == 15)
+					last = c = DecodeIndex(data, last);
+				WriteTriangle(destination, i, indexSize, a, b, c);
+				PushVertexFifo(vertexFifo, a, vertexFifoOffset);
+				PushVertexFifo(vertexFifo, b, vertexFifoOffset, (feb == 0) | (feb == 15));
+				PushVertexFifo(vertexFifo, c, vertexFifoOffset, (fec == 0) | (fec == 15));
+				PushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+				PushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+				PushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+			}
+		}
+		// All data read, stopped at the boundary between data and codeaux table.
+		return data == dataSafeEnd;
+	}
+
+	bool meshopt::DecodeIndexSequence(void* destination, size_t count, size_t indexSize, const uint8_t* buffer, size_t bufferSize)
+	{
+		using namespace meshopt_internal;
+		check(indexSize == 2 || indexSize == 4);
+		// Header, at least one byte per index and 4 bytes of tail.
+		if (bufferSize < 1 + count + 4)
+			return false;
+		if ((buffer[0] & 0xf0) != SequenceHeader || (buffer[0] & 0x0f) > 0)
+			return false;
+
+		const uint8_t* data = buffer + 1;
+		const uint8_t* dataSafeEnd = buffer + bufferSize - 4;
+		// Two baselines, low bit of each value selects the one used for the delta.
+		uint32_t last[2] = { 0, 0 };
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (data >= dataSafeEnd)
+				return false;
+			uint32_t v = DecodeVByte(data);
+			uint32_t current = v & 1;
+			v >>= 1;
+			uint32_t d = (v >> 1) ^ -int32_t(v & 1);
+			uint32_t index = last[current] + d;
+			last[current] = index;
+			WriteIndex(destination, i, indexSize, index);
+		}
+		return data == dataSafeEnd;
+	}
+
+	void meshopt::DecodeFilterOct(void* data, size_t count, size_t stride)
+	{
+		check(stride == 4 || stride == 8);
+		if (stride == 4)
+			meshopt_internal::DecodeFilterOct(static_cast<int8_t*>(data), count);
+		else
+			meshopt_internal::DecodeFilterOct(static_cast<int16_t*>(data), count);
+	}
+
+	void meshopt::DecodeFilterQuat(void* data, size_t count, size_t stride)
+	{
+		check(stride == 8);
+		int16_t* q = static_cast<int16_t*>(data);
+		const float scale = 1.f / sqrtf(2.f);
+		for (size_t i = 0; i < count; ++i)
+		{
+			// Recover scale from the high bits of the 4th component, low 2 bits hold the max component index.
+			int32_t sf = q[i * 4 + 3] | 3;
+			float ss = scale / float(sf);
+			float x = float(q[i * 4 + 0]) * ss;
+			float y = float(q[i * 4 + 1]) * ss;
+			float z = float(q[i * 4 + 2]) * ss;
+			// Reconstruct w clamping to 0 to avoid NaN due to precision errors
+			float ww = 1.f - x * x - y * y - z * z;
+			float w = sqrtf(ww >= 0.f ? ww : 0.f);
+			int32_t qc = q[i * 4 + 3] & 3;
+			q[i * 4 + ((qc + 1) & 3)] = int16_t(meshopt_internal::RoundToInt(x * 32767.f));
+			q[i * 4 + ((qc + 2) & 3)] = int16_t(meshopt_internal::RoundToInt(y * 32767.f));
+			q[i * 4 + ((qc + 3) & 3)] = int16_t(meshopt_internal::RoundToInt(z * 32767.f));
+			q[i * 4 + ((qc + 0) & 3)] = int16_t(meshopt_internal::RoundToInt(w * 32767.f));
+		}
+	}
+
+	void meshopt::DecodeFilterExp(void* data, size_t count, size_t stride)
+	{
+		check(stride % 4 == 0);
+		uint32_t* values = static_cast<uint32_t*>(data);
+		const size_t valueCount = count * stride / 4;
+		for (size_t i = 0; i < valueCount; ++i)
+		{
+			// 24 bit signed mantissa, 8 bit signed exponent: ldexp(m, e)
+			uint32_t v = values[i];
+			int32_t m = int32_t(v << 8) >> 8;
+			int32_t e = int32_t(v) >> 24;
+			float f;
+			uint32_t ui = uint32_t(e + 127) << 23;
+			memcpy(&f, &ui, sizeof(float));
+			f *= float(m);
+			memcpy(&values[i], &f, sizeof(float));
+		}
+	}
+}
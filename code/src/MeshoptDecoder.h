@@ -0,0 +1,27 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace vkmmc
+{
+	// Decoders for EXT_meshopt_compression buffer views.
+	// Bitstream format as described in the extension specification (vertex codec v0, index codec v0/v1, index sequence v0).
+	namespace meshopt
+	{
+		// Attributes mode. stride must be multiple of 4 and <= 256.
+		bool DecodeVertexBuffer(void* destination, size_t count, size_t stride, const uint8_t* buffer, size_t bufferSize);
+		// Triangles mode. indexSize must be 2 or 4.
+		bool DecodeIndexBuffer(void* destination, size_t count, size_t indexSize, const uint8_t* buffer, size_t bufferSize);
+		// Indices mode. indexSize must be 2 or 4.
+		bool DecodeIndexSequence(void* destination, size_t count, size_t indexSize, const uint8_t* buffer, size_t bufferSize);
+
+		// Filters, applied in place over the decoded attributes.
+		void DecodeFilterOct(void* data, size_t count, size_t stride);
+		void DecodeFilterQuat(void* data, size_t count, size_t stride);
+		void DecodeFilterExp(void* data, size_t count, size_t stride);
+	}
+}
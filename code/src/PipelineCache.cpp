@@ -0,0 +1,152 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "PipelineCache.h"
+#include "RenderContext.h"
+#include "Debug.h"
+#include "GenericUtils.h"
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+
+namespace pipelinecache_internal
+{
+	constexpr uint32_t Magic = 'V' | 'K' << 8 | 'P' << 16 | 'C' << 24;
+	constexpr uint32_t Version = 1;
+}
+
+namespace vkmmc
+{
+	void PipelineCache::Init(const RenderContext& renderContext, const char* filepath)
+	{
+		check(m_cache == VK_NULL_HANDLE);
+		m_filepath = filepath ? filepath : "";
+		std::string data;
+		const bool loaded = !m_filepath.empty() && Load(renderContext, data);
+		VkPipelineCacheCreateInfo info
+		{
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+			.pNext = nullptr,
+			.flags = 0,
+			.initialDataSize = loaded ? data.size() : 0,
+			.pInitialData = loaded ? data.data() : nullptr
+		};
+		vkcheck(vkCreatePipelineCache(renderContext.Device, &info, nullptr, &m_cache));
+		if (loaded)
+			Logf(LogLevel::Ok, "Pipeline cache loaded from %s (%zu bytes).\n", m_filepath.c_str(), data.size());
+	}
+
+	void PipelineCache::Destroy(const RenderContext& renderContext)
+	{
+		vkDestroyPipelineCache(renderContext.Device, m_cache, nullptr);
+		m_cache = VK_NULL_HANDLE;
+	}
+
+	bool PipelineCache::Save(const RenderContext& renderContext) const
+	{
+		check(m_cache != VK_NULL_HANDLE);
+		if (m_filepath.empty())
+			return false;
+		size_t size = 0;
+		vkcheck(vkGetPipelineCacheData(renderContext.Device, m_cache, &size, nullptr));
+		std::string data(size, '\0');
+		vkcheck(vkGetPipelineCacheData(renderContext.Device, m_cache, &size, data.data()));
+		data.resize(size);
+
+		FileHeader header = GetDeviceHeader(renderContext);
+		header.DataSize = size;
+		header.DataHash = hash::Fnv1a(data.data(), data.size());
+		// Write a temporary file first, a crash while saving must not leave a truncated cache.
+		const std::string tempPath = m_filepath + ".tmp";
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(m_filepath).parent_path(), error);
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				Logf(LogLevel::Error, "Failed to open %s to write pipeline cache.\n", tempPath.c_str());
+				return false;
+			}
+			file.write((const char*)&header, sizeof(FileHeader));
+			file.write(data.data(), data.size());
+			if (!file.good())
+			{
+				Logf(LogLevel::Error, "Failed to write pipeline cache in %s.\n", tempPath.c_str());
+				return false;
+			}
+		}
+		std::remove(m_filepath.c_str());
+		if (std::rename(tempPath.c_str(), m_filepath.c_str()))
+		{
+			Logf(LogLevel::Error, "Failed to rename %s to %s.\n", tempPath.c_str(), m_filepath.c_str());
+			return false;
+		}
+		Logf(LogLevel::Info, "Pipeline cache saved to %s (%zu bytes).\n", m_filepath.c_str(), size);
+		return true;
+	}
+
+	PipelineCache::FileHeader PipelineCache::GetDeviceHeader(const RenderContext& renderContext)
+	{
+		VkPhysicalDeviceIDProperties idProperties{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES, .pNext = nullptr };
+		VkPhysicalDeviceProperties2 properties2{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &idProperties };
+		vkGetPhysicalDeviceProperties2(renderContext.GPUDevice, &properties2);
+		const VkPhysicalDeviceProperties& properties = properties2.properties;
+
+		FileHeader header{};
+		header.Magic = pipelinecache_internal::Magic;
+		header.Version = pipelinecache_internal::Version;
+		header.VendorId = properties.vendorID;
+		header.DeviceId = properties.deviceID;
+		header.DriverVersion = properties.driverVersion;
+		memcpy_s(header.DeviceUUID, VK_UUID_SIZE, idProperties.deviceUUID, VK_UUID_SIZE);
+		memcpy_s(header.PipelineCacheUUID, VK_UUID_SIZE, properties.pipelineCacheUUID, VK_UUID_SIZE);
+		return header;
+	}
+
+	bool PipelineCache::Load(const RenderContext& renderContext, std::string& data) const
+	{
+		std::ifstream file(m_filepath, std::ios::ate | std::ios::binary);
+		if (!file.is_open())
+		{
+			Logf(LogLevel::Info, "No pipeline cache found in %s.\n", m_filepath.c_str());
+			return false;
+		}
+		const size_t fileSize = (size_t)file.tellg();
+		FileHeader header;
+		if (fileSize < sizeof(FileHeader))
+		{
+			Logf(LogLevel::Warn, "Pipeline cache %s is truncated, discarded.\n", m_filepath.c_str());
+			return false;
+		}
+		file.seekg(0);
+		file.read((char*)&header, sizeof(FileHeader));
+
+		const FileHeader device = GetDeviceHeader(renderContext);
+		if (header.Magic != device.Magic || header.Version != device.Version)
+		{
+			Logf(LogLevel::Warn, "Pipeline cache %s has an unknown format, discarded.\n", m_filepath.c_str());
+			return false;
+		}
+		if (header.VendorId != device.VendorId || header.DeviceId != device.DeviceId
+			|| header.DriverVersion != device.DriverVersion
+			|| memcmp(header.DeviceUUID, device.DeviceUUID, VK_UUID_SIZE)
+			|| memcmp(header.PipelineCacheUUID, device.PipelineCacheUUID, VK_UUID_SIZE))
+		{
+			Logf(LogLevel::Warn, "Pipeline cache %s was generated by another device or driver version, discarded.\n", m_filepath.c_str());
+			return false;
+		}
+		if (header.DataSize != fileSize - sizeof(FileHeader))
+		{
+			Logf(LogLevel::Warn, "Pipeline cache %s is truncated, discarded.\n", m_filepath.c_str());
+			return false;
+		}
+		data.resize((size_t)header.DataSize);
+		file.read(data.data(), data.size());
+		if (!file.good() || hash::Fnv1a(data.data(), data.size()) != header.DataHash)
+		{
+			Logf(LogLevel::Warn, "Pipeline cache %s is corrupted, discarded.\n", m_filepath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
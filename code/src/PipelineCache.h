@@ -0,0 +1,49 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <string>
+
+namespace vkmmc
+{
+	struct RenderContext;
+
+	/**
+	 * VkPipelineCache shared by every pipeline of the engine, loaded from disk at startup and saved at shutdown.
+	 * The file header identifies the device and driver that produced the data. Data from another device or
+	 * driver version is discarded and the cache starts empty.
+	 */
+	class PipelineCache
+	{
+		struct FileHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint32_t VendorId;
+			uint32_t DeviceId;
+			uint32_t DriverVersion;
+			uint8_t DeviceUUID[VK_UUID_SIZE];
+			uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t DataSize;
+			uint64_t DataHash;
+		};
+
+	public:
+		// filepath: null to keep the cache only in memory.
+		void Init(const RenderContext& renderContext, const char* filepath);
+		void Destroy(const RenderContext& renderContext);
+		bool Save(const RenderContext& renderContext) const;
+
+		VkPipelineCache GetHandle() const { return m_cache; }
+
+	private:
+		static FileHeader GetDeviceHeader(const RenderContext& renderContext);
+		// Returns false if there is no file or it was produced by another device or driver.
+		bool Load(const RenderContext& renderContext, std::string& data) const;
+
+		VkPipelineCache m_cache{ VK_NULL_HANDLE };
+		std::string m_filepath;
+	};
+}
@@ -0,0 +1,168 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "PipelineHotReload.h"
+#include "Shader.h"
+#include "Debug.h"
+#include "Globals.h"
+#include <chrono>
+
+namespace vkmmc
+{
+	void PipelineHotReload::Init(const RenderContext& renderContext, uint32_t pollIntervalMs)
+	{
+		check(!m_thread.joinable() && pollIntervalMs > 0);
+		m_renderContext = renderContext;
+		m_pollIntervalMs = pollIntervalMs;
+		m_exit = false;
+		m_thread = std::thread(&PipelineHotReload::WatchLoop, this);
+	}
+
+	void PipelineHotReload::Destroy(const RenderContext& renderContext)
+	{
+		if (m_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_exit = true;
+			}
+			m_exitCondition.notify_all();
+			m_thread.join();
+		}
+		// Frames in flight have finished, nothing uses the retired pipelines.
+		for (ReadyPipeline& ready : m_ready)
+			ready.Pipeline.Destroy(renderContext);
+		for (RetiredPipeline& retired : m_retired)
+			retired.Pipeline.Destroy(renderContext);
+		m_ready.clear();
+		m_retired.clear();
+		m_entries.clear();
+		m_files.clear();
+	}
+
+	void PipelineHotReload::Register(const RenderPipelineDescription& description, RenderPipeline* target)
+	{
+		check(target);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_entries.push_back({ description, target });
+		for (const ShaderDescription& shader : description.Shaders)
+		{
+			if (m_files.contains(shader.Filepath))
+				continue;
+			std::error_code error;
+			WatchedFile file;
+			file.WriteTime = std::filesystem::last_write_time(shader.Filepath, error);
+			m_files[shader.Filepath] = file;
+		}
+	}
+
+	void PipelineHotReload::BeginFrame(const RenderContext& renderContext, uint32_t frameCounter)
+	{
+		for (size_t i = 0; i < m_retired.size();)
+		{
+			if (frameCounter - m_retired[i].FrameCounter >= globals::MaxOverlappedFrames)
+			{
+				m_retired[i].Pipeline.Destroy(renderContext);
+				m_retired[i] = m_retired.back();
+				m_retired.pop_back();
+			}
+			else
+				++i;
+		}
+
+		// Never wait for the watcher, swap in the next frame if it holds the lock.
+		std::vector<ReadyPipeline> ready;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+			if (!lock.owns_lock() || m_ready.empty())
+				return;
+			ready.swap(m_ready);
+		}
+		for (ReadyPipeline& it : ready)
+		{
+			Entry& entry = m_entries[it.EntryIndex];
+			m_retired.push_back({ *entry.Target, frameCounter });
+			*entry.Target = it.Pipeline;
+		}
+		Logf(LogLevel::Ok, "%u render pipelines swapped after shader reload.\n", (uint32_t)ready.size());
+	}
+
+	void PipelineHotReload::WatchLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (!m_exit)
+		{
+			m_exitCondition.wait_for(lock, std::chrono::milliseconds(m_pollIntervalMs), [this]() { return m_exit; });
+			if (m_exit)
+				break;
+			std::vector<std::string> changedFiles;
+			for (auto& it : m_files)
+			{
+				std::error_code error;
+				std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(it.first, error);
+				if (error)
+					continue;
+				if (writeTime != it.second.WriteTime)
+				{
+					it.second.WriteTime = writeTime;
+					it.second.Pending = true;
+				}
+				else if (it.second.Pending)
+				{
+					it.second.Pending = false;
+					changedFiles.push_back(it.first);
+				}
+			}
+			if (changedFiles.empty())
+				continue;
+			lock.unlock();
+			RebuildPipelines(changedFiles);
+			lock.lock();
+		}
+	}
+
+	void PipelineHotReload::RebuildPipelines(const std::vector<std::string>& changedFiles)
+	{
+		std::vector<const std::string*> reloadedFiles;
+		for (const std::string& filepath : changedFiles)
+		{
+			if (!m_renderContext.ShaderLibrary || m_renderContext.ShaderLibrary->Reload(m_renderContext, filepath.c_str()))
+				reloadedFiles.push_back(&filepath);
+		}
+		if (reloadedFiles.empty())
+			return;
+
+		std::vector<Entry> entries;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			entries = m_entries;
+		}
+		for (uint32_t i = 0; i < (uint32_t)entries.size(); ++i)
+		{
+			const std::string* changedFile = nullptr;
+			for (const ShaderDescription& shader : entries[i].Description.Shaders)
+			{
+				for (const std::string* filepath : reloadedFiles)
+				{
+					if (shader.Filepath == *filepath)
+						changedFile = filepath;
+				}
+			}
+			if (!changedFile)
+				continue;
+
+			auto start = std::chrono::high_resolution_clock::now();
+			RenderPipeline pipeline = RenderPipeline::Create(m_renderContext, entries[i].Description);
+			if (!pipeline.IsValid())
+			{
+				Logf(LogLevel::Error, "Failed to rebuild pipeline after %s changed, keeping the previous one.\n", changedFile->c_str());
+				pipeline.Destroy(m_renderContext);
+				continue;
+			}
+			auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+			Logf(LogLevel::Ok, "Pipeline rebuilt after %s changed (%.3f ms).\n", changedFile->c_str(), (double)elapsed.count() * 1e-3);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_ready.push_back({ i, pipeline });
+		}
+	}
+}
@@ -0,0 +1,70 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include "RenderPipeline.h"
+#include "RenderContext.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <unordered_map>
+
+namespace vkmmc
+{
+	/**
+	 * Watches the shader files of the registered pipelines and rebuilds the pipelines whose shaders changed in a
+	 * background thread, so the frame loop never waits for compilation. Rebuilt pipelines are swapped in at the
+	 * beginning of a frame and the previous ones destroyed once the frames in flight that used them have finished.
+	 */
+	class PipelineHotReload
+	{
+		struct Entry
+		{
+			RenderPipelineDescription Description;
+			RenderPipeline* Target;
+		};
+		struct ReadyPipeline
+		{
+			uint32_t EntryIndex;
+			RenderPipeline Pipeline;
+		};
+		struct RetiredPipeline
+		{
+			RenderPipeline Pipeline;
+			uint32_t FrameCounter;
+		};
+		struct WatchedFile
+		{
+			std::filesystem::file_time_type WriteTime;
+			// Change seen in the last poll, reloaded when the write time is stable for a whole poll interval.
+			bool Pending{ false };
+		};
+	public:
+		void Init(const RenderContext& renderContext, uint32_t pollIntervalMs);
+		void Destroy(const RenderContext& renderContext);
+
+		// target is rebuilt from description when one of its shaders changes.
+		void Register(const RenderPipelineDescription& description, RenderPipeline* target);
+		// Frame slot fence has signaled. Swap rebuilt pipelines and destroy the retired ones no frame uses.
+		void BeginFrame(const RenderContext& renderContext, uint32_t frameCounter);
+
+	private:
+		void WatchLoop();
+		// Files changed in the same poll. Every pipeline is rebuilt once, whatever number of its shaders changed.
+		void RebuildPipelines(const std::vector<std::string>& changedFiles);
+
+		RenderContext m_renderContext;
+		uint32_t m_pollIntervalMs{ 0 };
+		// Written by the main thread at init and read by the watcher.
+		std::vector<Entry> m_entries;
+		std::unordered_map<std::string, WatchedFile> m_files;
+		std::vector<ReadyPipeline> m_ready;
+		std::vector<RetiredPipeline> m_retired;
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_exitCondition;
+		bool m_exit{ false };
+	};
+}
@@ -0,0 +1,84 @@
+// Autogenerated code for vkmmc project
+// Header file
+#pragma once
+
+// Windows CRT extensions used across the engine. Elsewhere they map to the standard library, bounds are still
+// honoured but the invalid parameter handler is not invoked. winnt.h provides DEFINE_ENUM_FLAG_OPERATORS.
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#define __min(a, b) (((a) < (b)) ? (a) : (b))
+#define __max(a, b) (((a) > (b)) ? (a) : (b))
+#define __debugbreak() raise(SIGTRAP)
+#define fprintf_s fprintf
+
+template <size_t N>
+inline int vsprintf_s(char (&buffer)[N], const char* fmt, va_list args)
+{
+	return vsnprintf(buffer, N, fmt, args);
+}
+
+inline int sprintf_s(char* buffer, size_t size, const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int count = vsnprintf(buffer, size, fmt, args);
+	va_end(args);
+	return count;
+}
+
+template <size_t N>
+inline int sprintf_s(char (&buffer)[N], const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	const int count = vsnprintf(buffer, N, fmt, args);
+	va_end(args);
+	return count;
+}
+
+template <size_t N>
+inline int strcpy_s(char (&dst)[N], const char* src)
+{
+	return snprintf(dst, N, "%s", src) < (int)N ? 0 : ERANGE;
+}
+
+inline int strncpy_s(char* dst, size_t size, const char* src, size_t count)
+{
+	const size_t length = strnlen(src, count);
+	if (length >= size)
+		return ERANGE;
+	memcpy(dst, src, length);
+	dst[length] = 0;
+	return 0;
+}
+
+inline int memcpy_s(void* dst, size_t dstSize, const void* src, size_t count)
+{
+	if (count > dstSize)
+		return ERANGE;
+	memcpy(dst, src, count);
+	return 0;
+}
+
+inline int fopen_s(FILE** file, const char* filepath, const char* mode)
+{
+	*file = fopen(filepath, mode);
+	return *file ? 0 : errno;
+}
+
+#define DEFINE_ENUM_FLAG_OPERATORS(enumType) \
+	inline constexpr enumType operator|(enumType a, enumType b) { return enumType(std::underlying_type_t<enumType>(a) | std::underlying_type_t<enumType>(b)); } \
+	inline constexpr enumType operator&(enumType a, enumType b) { return enumType(std::underlying_type_t<enumType>(a) & std::underlying_type_t<enumType>(b)); } \
+	inline constexpr enumType operator^(enumType a, enumType b) { return enumType(std::underlying_type_t<enumType>(a) ^ std::underlying_type_t<enumType>(b)); } \
+	inline constexpr enumType operator~(enumType a) { return enumType(~std::underlying_type_t<enumType>(a)); } \
+	inline enumType& operator|=(enumType& a, enumType b) { return a = a | b; } \
+	inline enumType& operator&=(enumType& a, enumType b) { return a = a & b; } \
+	inline enumType& operator^=(enumType& a, enumType b) { return a = a ^ b; }
+#endif
@@ -11,7 +11,7 @@ struct SDL_Window;
 
 namespace vkmmc
 {
-
+	class FrameDescriptorAllocator;
 
 	struct TransferContext
 	{
@@ -28,12 +28,23 @@ namespace vkmmc
 		VkSurfaceKHR Surface;
 		VkDebugUtilsMessengerEXT DebugMessenger;
 		VkPhysicalDeviceProperties GPUProperties;
+		VkPhysicalDeviceFeatures GPUFeatures;
 		VkDevice Device;
-		Allocator* Allocator;
+		vkmmc::Allocator* Allocator;
+		// Shared samplers, used by SamplerBuilder.
+		class SamplerCache* SamplerCache{ nullptr };
+		// Shared by every pipeline creation, persisted between runs.
+		VkPipelineCache PipelineCache{ VK_NULL_HANDLE };
+		// Shader modules and reflection shared by every pipeline.
+		class ShaderLibrary* ShaderLibrary{ nullptr };
 		VkQueue GraphicsQueue;
 		uint32_t GraphicsQueueFamily;
+		// VK_EXT_descriptor_indexing enabled (runtime arrays and partially bound descriptors).
+		bool DescriptorIndexing{ false };
+		// VK_EXT_memory_budget enabled, heap budgets available in memory telemetry.
+		bool MemoryBudget{ false };
 
-		TransferContext TransferContext;
+		vkmmc::TransferContext TransferContext;
 	};
 
 	struct RenderFrameContext
@@ -49,7 +60,12 @@ namespace vkmmc
 
 		// Descriptors
 		VkDescriptorSet CameraDescriptorSet{};
+		VkDescriptorSet BindlessSet{ VK_NULL_HANDLE };
 		UniformBuffer GlobalBuffer{};
+		// Per frame data without reserved slot, valid until the frame fence signals.
+		vkmmc::TransientBuffer* TransientBuffer{ nullptr };
+		// Descriptor sets valid until the frame fence signals, per recording thread.
+		vkmmc::FrameDescriptorAllocator* FrameDescriptorAllocator{ nullptr };
 
 		// Push constants
 		const void* PushConstantData{ nullptr };
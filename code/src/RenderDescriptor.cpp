@@ -2,9 +2,11 @@
 #include "Debug.h"
 #include "InitVulkanTypes.h"
 #include "RenderContext.h"
+#include "SamplerCache.h"
 #include <stdlib.h>
 #include <algorithm>
 #include "Shader.h"
+#include "WorkerPool.h"
 
 namespace vkmmc
 {
@@ -20,10 +22,11 @@ namespace vkmmc
 		return sizes;
 	}
 
-	void DescriptorAllocator::Init(const RenderContext& rc, const DescriptorPoolSizes& sizes)
+	void DescriptorAllocator::Init(const RenderContext& rc, const DescriptorPoolSizes& sizes, const DescriptorLayoutCache* layoutCache)
 	{
 		m_renderContext = &rc;
 		m_poolSizes = sizes;
+		m_layoutCache = layoutCache;
 	}
 
 	void DescriptorAllocator::Destroy()
@@ -34,6 +37,7 @@ namespace vkmmc
 					vkDestroyDescriptorPool(rc.Device, pool, nullptr);
 				pools.clear();
 			};
+		std::lock_guard<std::mutex> lock(m_mutex);
 		destroyPool(*m_renderContext, m_usedPools);
 		destroyPool(*m_renderContext, m_freePools);
 		m_pool = VK_NULL_HANDLE;
@@ -41,6 +45,8 @@ namespace vkmmc
 
 	bool DescriptorAllocator::Allocate(VkDescriptorSet* set, VkDescriptorSetLayout layout)
 	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		TrackUsage(layout);
 		if (m_pool == VK_NULL_HANDLE)
 		{
 			m_pool = UsePool();
@@ -77,6 +83,7 @@ namespace vkmmc
 
 	void DescriptorAllocator::ResetPools()
 	{
+		std::lock_guard<std::mutex> lock(m_mutex);
 		for (uint32_t i = 0; i < m_usedPools.size(); ++i)
 		{
 			vkResetDescriptorPool(m_renderContext->Device, m_usedPools[i], 0);
@@ -91,7 +98,7 @@ namespace vkmmc
 		// free pool? or create new one?
 		if (m_freePools.empty())
 		{
-			return CreatePool(m_renderContext->Device, m_poolSizes, MaxPoolCount);
+			return CreatePool(m_renderContext->Device, GetAdaptedPoolSizes(), MaxPoolCount);
 		}
 		else
 		{
@@ -101,6 +108,76 @@ namespace vkmmc
 		}
 	}
 
+	void DescriptorAllocator::TrackUsage(VkDescriptorSetLayout layout)
+	{
+		if (!m_layoutCache)
+			return;
+		const DescriptorLayoutInfo* info = m_layoutCache->GetLayoutInfo(layout);
+		if (!info)
+			return;
+		++m_trackedSetCount;
+		for (const VkDescriptorSetLayoutBinding& binding : info->Bindings)
+			m_descriptorCounts[binding.descriptorType] += binding.descriptorCount;
+	}
+
+	DescriptorPoolSizes DescriptorAllocator::GetAdaptedPoolSizes() const
+	{
+		if (m_trackedSetCount < MinTrackedSets)
+			return m_poolSizes;
+		// Observed descriptors per set with some margin. Types not seen yet keep a minimum.
+		DescriptorPoolSizes sizes;
+		for (const DescriptorPoolTypeInfo& it : m_poolSizes.Sizes)
+		{
+			if (!m_descriptorCounts.contains(it.Type))
+				sizes.Sizes.push_back({ it.Type, MinTypeMultiplier });
+		}
+		for (const std::pair<VkDescriptorType, uint64_t>& it : m_descriptorCounts)
+		{
+			float multiplier = 1.25f * (float)it.second / (float)m_trackedSetCount;
+			sizes.Sizes.push_back({ it.first, __max(multiplier, MinTypeMultiplier) });
+		}
+		return sizes;
+	}
+
+	void FrameDescriptorAllocator::Init(const RenderContext& rc, const DescriptorPoolSizes& sizes, const DescriptorLayoutCache* layoutCache, uint32_t threadCount)
+	{
+		check(threadCount > 0 && !m_threadCount);
+		m_threadCount = threadCount;
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+		{
+			m_allocators[i] = new DescriptorAllocator[threadCount];
+			for (uint32_t j = 0; j < threadCount; ++j)
+				m_allocators[i][j].Init(rc, sizes, layoutCache);
+		}
+	}
+
+	void FrameDescriptorAllocator::Destroy()
+	{
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+		{
+			for (uint32_t j = 0; j < m_threadCount; ++j)
+				m_allocators[i][j].Destroy();
+			delete[] m_allocators[i];
+			m_allocators[i] = nullptr;
+		}
+		m_threadCount = 0;
+	}
+
+	void FrameDescriptorAllocator::BeginFrame(uint32_t frameIndex)
+	{
+		check(frameIndex < globals::MaxOverlappedFrames);
+		m_frameIndex = frameIndex;
+		for (uint32_t j = 0; j < m_threadCount; ++j)
+			m_allocators[frameIndex][j].ResetPools();
+	}
+
+	DescriptorAllocator& FrameDescriptorAllocator::Get()
+	{
+		const uint32_t threadIndex = WorkerPool::GetThreadIndex();
+		check(threadIndex < m_threadCount);
+		return m_allocators[m_frameIndex][threadIndex];
+	}
+
 	VkDescriptorPool CreatePool(VkDevice device, const DescriptorPoolSizes& sizes, uint32_t count, VkDescriptorPoolCreateFlags flags)
 	{
 		std::vector<VkDescriptorPoolSize> vulkanSizes(sizes.Sizes.size());
@@ -129,10 +206,11 @@ namespace vkmmc
 				if (Bindings[i].binding != other.Bindings[i].binding
 					|| Bindings[i].descriptorCount != other.Bindings[i].descriptorCount
 					|| Bindings[i].descriptorType != other.Bindings[i].descriptorType
-					|| Bindings[i].stageFlags != other.Bindings[i].stageFlags)
+					|| Bindings[i].stageFlags != other.Bindings[i].stageFlags
+					|| (Bindings[i].pImmutableSamplers == nullptr) != (other.Bindings[i].pImmutableSamplers == nullptr))
 					return false;
 			}
-			return true;
+			return ImmutableSamplers == other.ImmutableSamplers;
 		}
 		return false;
 	}
@@ -150,6 +228,8 @@ namespace vkmmc
 				| it.stageFlags << 24;
 			res ^= hash<size_t>()(bhash);
 		}
+		for (VkSampler sampler : ImmutableSamplers)
+			res ^= hash<VkSampler>()(sampler);
 		return res;
 	}
 
@@ -160,11 +240,18 @@ namespace vkmmc
 
 	void DescriptorLayoutCache::Destroy()
 	{
+		std::lock_guard<std::mutex> lock(m_mutex);
 		for (const std::pair<DescriptorLayoutInfo, VkDescriptorSetLayout>& it : m_cached)
 		{
 			vkDestroyDescriptorSetLayout(m_renderContext->Device, it.second, nullptr);
+			if (m_renderContext->SamplerCache)
+			{
+				for (VkSampler sampler : it.first.ImmutableSamplers)
+					m_renderContext->SamplerCache->Release(*m_renderContext, sampler);
+			}
 		}
 		m_cached.clear();
+		m_infos.clear();
 	}
 
 	VkDescriptorSetLayout DescriptorLayoutCache::CreateLayout(const VkDescriptorSetLayoutCreateInfo& info)
@@ -190,6 +277,12 @@ namespace vkmmc
 				[](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b)
 				{ return a.binding < b.binding; });
 		}
+		for (const VkDescriptorSetLayoutBinding& binding : layoutInfo.Bindings)
+		{
+			if (binding.pImmutableSamplers)
+				layoutInfo.ImmutableSamplers.insert(layoutInfo.ImmutableSamplers.end(), binding.pImmutableSamplers, binding.pImmutableSamplers + binding.descriptorCount);
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
 		auto it = m_cached.find(layoutInfo);
 		VkDescriptorSetLayout layout;
 		if (it != m_cached.end())
@@ -200,11 +293,25 @@ namespace vkmmc
 		{
 			vkcheck(vkCreateDescriptorSetLayout(m_renderContext->Device,
 				&info, nullptr, &layout));
-			m_cached[layoutInfo] = layout;
+			// Layout keeps its immutable samplers alive.
+			if (m_renderContext->SamplerCache)
+			{
+				for (VkSampler sampler : layoutInfo.ImmutableSamplers)
+					m_renderContext->SamplerCache->AddRef(sampler);
+			}
+			auto inserted = m_cached.emplace(std::move(layoutInfo), layout);
+			m_infos[layout] = &inserted.first->first;
 		}
 		return layout;
 	}
 
+	const DescriptorLayoutInfo* DescriptorLayoutCache::GetLayoutInfo(VkDescriptorSetLayout layout) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_infos.find(layout);
+		return it != m_infos.end() ? it->second : nullptr;
+	}
+
 	DescriptorSetLayoutBuilder DescriptorSetLayoutBuilder::Create(DescriptorLayoutCache& layoutCache)
 	{
 		DescriptorSetLayoutBuilder builder;
@@ -212,14 +319,15 @@ namespace vkmmc
 		return builder;
 	}
 
-	DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::AddBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t descriptorCount)
+	DescriptorSetLayoutBuilder& DescriptorSetLayoutBuilder::AddBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t descriptorCount, const VkSampler* immutableSamplers)
 	{
 		Bindings.push_back(
 			{
 				.binding = binding,
 				.descriptorType = type,
 				.descriptorCount = descriptorCount,
-				.stageFlags = stageFlags
+				.stageFlags = stageFlags,
+				.pImmutableSamplers = immutableSamplers
 			});
 		return *this;
 	}
@@ -276,7 +384,7 @@ namespace vkmmc
 		return *this;
 	}
 
-	DescriptorBuilder& DescriptorBuilder::BindImage(uint32_t binding, const VkDescriptorImageInfo* imageInfo, uint32_t imageInfoCount, VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t arrayIndex)
+	DescriptorBuilder& DescriptorBuilder::BindImage(uint32_t binding, const VkDescriptorImageInfo* imageInfo, uint32_t imageInfoCount, VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t arrayIndex, const VkSampler* immutableSamplers)
 	{
 		VkDescriptorSetLayoutBinding bindingInfo
 		{
@@ -284,7 +392,7 @@ namespace vkmmc
 			.descriptorType = type,
 			.descriptorCount = imageInfoCount,
 			.stageFlags = stageFlags,
-			.pImmutableSamplers = nullptr
+			.pImmutableSamplers = immutableSamplers
 		};
 		m_bindings.push_back(bindingInfo);
 
@@ -3,12 +3,16 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <unordered_map>
+#include <mutex>
+#include "Globals.h"
 
 namespace vkmmc
 {
 	struct RenderContext;
 	struct ShaderDescriptorSet;
 	struct ShaderReflectionProperties;
+	class DescriptorLayoutCache;
+	struct DescriptorLayoutInfo;
 
 	struct DescriptorPoolTypeInfo
 	{
@@ -23,23 +27,60 @@ namespace vkmmc
 		static const DescriptorPoolSizes& GetDefault();
 	};
 
+	/**
+	 * Descriptor sets from a growing list of pools. Thread safe.
+	 * With a layout cache, the descriptors of each type per set are tracked and new pools are sized
+	 * with the observed mix instead of the initial multipliers.
+	 */
 	class DescriptorAllocator
 	{
 	public:
-		void Init(const RenderContext& rc, const DescriptorPoolSizes& sizes);
+		void Init(const RenderContext& rc, const DescriptorPoolSizes& sizes, const DescriptorLayoutCache* layoutCache = nullptr);
 		void Destroy();
 
 		bool Allocate(VkDescriptorSet* set, VkDescriptorSetLayout layout);
 		void ResetPools();
 	private:
 		VkDescriptorPool UsePool();
+		void TrackUsage(VkDescriptorSetLayout layout);
+		DescriptorPoolSizes GetAdaptedPoolSizes() const;
 
 		static constexpr uint32_t MaxPoolCount = 200;
+		// Sets to see before adapting pool sizes, and minimum multiplier of every type.
+		static constexpr uint32_t MinTrackedSets = 16;
+		static constexpr float MinTypeMultiplier = 0.25f;
 		const RenderContext* m_renderContext;
+		const DescriptorLayoutCache* m_layoutCache{ nullptr };
 		VkDescriptorPool m_pool{ VK_NULL_HANDLE };
 		DescriptorPoolSizes m_poolSizes;
 		std::vector<VkDescriptorPool> m_usedPools;
 		std::vector<VkDescriptorPool> m_freePools;
+		// Usage stats
+		std::unordered_map<VkDescriptorType, uint64_t> m_descriptorCounts;
+		uint64_t m_trackedSetCount{ 0 };
+		std::mutex m_mutex;
+	};
+
+	/**
+	 * Descriptor sets that live one frame. One allocator per frame in flight and per thread, so threads
+	 * recording commands do not contend. Pools of a frame slot are reset when its fence has signaled.
+	 */
+	class FrameDescriptorAllocator
+	{
+	public:
+		// threadCount: calling thread plus worker threads (see WorkerPool::GetThreadIndex).
+		void Init(const RenderContext& rc, const DescriptorPoolSizes& sizes, const DescriptorLayoutCache* layoutCache, uint32_t threadCount);
+		void Destroy();
+
+		// Frame slot fence has signaled, sets allocated last time the slot was recorded are released.
+		void BeginFrame(uint32_t frameIndex);
+		// Allocator of the calling thread for the current frame.
+		DescriptorAllocator& Get();
+
+	private:
+		DescriptorAllocator* m_allocators[globals::MaxOverlappedFrames]{};
+		uint32_t m_threadCount{ 0 };
+		uint32_t m_frameIndex{ 0 };
 	};
 
 	VkDescriptorPool CreatePool(
@@ -52,6 +93,8 @@ namespace vkmmc
 	struct DescriptorLayoutInfo
 	{
 		std::vector<VkDescriptorSetLayoutBinding> Bindings;
+		// Copy of the immutable samplers of every binding, binding pointers are not valid after layout creation.
+		std::vector<VkSampler> ImmutableSamplers;
 		bool operator==(const DescriptorLayoutInfo& other) const;
 		size_t Hash() const;
 
@@ -71,11 +114,16 @@ namespace vkmmc
 		void Init(const RenderContext& rc);
 		void Destroy();
 
+		// Thread safe.
 		VkDescriptorSetLayout CreateLayout(const VkDescriptorSetLayoutCreateInfo& info);
+		// Bindings of a layout created by the cache, null if unknown.
+		const DescriptorLayoutInfo* GetLayoutInfo(VkDescriptorSetLayout layout) const;
 
 	private:
 		const RenderContext* m_renderContext{ nullptr };
 		std::unordered_map<DescriptorLayoutInfo, VkDescriptorSetLayout, DescriptorLayoutInfo::Hasher> m_cached;
+		std::unordered_map<VkDescriptorSetLayout, const DescriptorLayoutInfo*> m_infos;
+		mutable std::mutex m_mutex;
 	};
 
 	class DescriptorSetLayoutBuilder
@@ -84,7 +132,8 @@ namespace vkmmc
 	public:
 		static DescriptorSetLayoutBuilder Create(DescriptorLayoutCache& layoutCache);
 
-		DescriptorSetLayoutBuilder& AddBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t descriptorCount);
+		// immutableSamplers: descriptorCount samplers baked in the layout, or null.
+		DescriptorSetLayoutBuilder& AddBinding(uint32_t binding, VkDescriptorType type, VkShaderStageFlags stageFlags, uint32_t descriptorCount, const VkSampler* immutableSamplers = nullptr);
 		bool Build(const RenderContext& rc, VkDescriptorSetLayout* layout);
 	private:
 		DescriptorLayoutCache* m_cache = nullptr;
@@ -106,7 +155,8 @@ namespace vkmmc
 			const VkDescriptorImageInfo* imageInfo,
 			uint32_t imageInfoCount,
 			VkDescriptorType type,
-			VkShaderStageFlags stageFlags, uint32_t arrayIndex = 0);
+			VkShaderStageFlags stageFlags, uint32_t arrayIndex = 0,
+			const VkSampler* immutableSamplers = nullptr);
 
 		bool Build(const RenderContext& rc, VkDescriptorSet& set, VkDescriptorSetLayout& layout);
 		bool Build(const RenderContext& rc, VkDescriptorSet& set);
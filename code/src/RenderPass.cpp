@@ -7,7 +7,7 @@
 namespace vkmmc
 {
 
-	void RenderPass::BeginPass(VkCommandBuffer cmd, VkFramebuffer framebuffer) const
+	void RenderPass::BeginPass(VkCommandBuffer cmd, VkFramebuffer framebuffer, VkSubpassContents contents) const
 	{
 		VkRenderPassBeginInfo renderPassInfo = { VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO, nullptr };
 		renderPassInfo.renderPass = RenderPass;
@@ -16,7 +16,7 @@ namespace vkmmc
 		renderPassInfo.framebuffer = framebuffer;
 		renderPassInfo.clearValueCount = (uint32_t)ClearValues.size();
 		renderPassInfo.pClearValues = ClearValues.data();
-		vkCmdBeginRenderPass(cmd, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(cmd, &renderPassInfo, contents);
 	}
 
 	void RenderPass::EndPass(VkCommandBuffer cmd) const
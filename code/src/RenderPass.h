@@ -27,7 +27,8 @@ namespace vkmmc
 		// one framebuffer per swapchain image
 		std::vector<VkClearValue> ClearValues; // clear values per framebuffer attachment
 
-		void BeginPass(VkCommandBuffer cmd, VkFramebuffer framebuffer) const;
+		// contents: VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS when the pass is recorded with vkCmdExecuteCommands.
+		void BeginPass(VkCommandBuffer cmd, VkFramebuffer framebuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) const;
 		void EndPass(VkCommandBuffer cmd) const;
 	};
 
@@ -5,6 +5,9 @@
 #include "Logger.h"
 #include "Debug.h"
 #include "Shader.h"
+#include "WorkerPool.h"
+#include "PipelineHotReload.h"
+#include <chrono>
 
 namespace vkmmc
 {
@@ -87,7 +90,7 @@ namespace vkmmc
 		// Create pipeline and check it's all set up correctly
 		VkPipeline newPipeline;
 		if (vkCreateGraphicsPipelines(RContext.Device,
-			VK_NULL_HANDLE,
+			RContext.PipelineCache,
 			1, &pipelineInfo,
 			nullptr,
 			&newPipeline) == VK_SUCCESS)
@@ -105,6 +108,31 @@ namespace vkmmc
 		return pipelineObject;
 	}
 
+	void SpecializationConstants::Set(uint32_t constantId, uint32_t value)
+	{
+		for (const VkSpecializationMapEntry& entry : Entries)
+		{
+			if (entry.constantID == constantId)
+			{
+				Data[entry.offset / sizeof(uint32_t)] = value;
+				return;
+			}
+		}
+		Entries.push_back({ .constantID = constantId, .offset = (uint32_t)(Data.size() * sizeof(uint32_t)), .size = sizeof(uint32_t) });
+		Data.push_back(value);
+	}
+
+	VkSpecializationInfo SpecializationConstants::GetInfo() const
+	{
+		return VkSpecializationInfo
+		{
+			.mapEntryCount = (uint32_t)Entries.size(),
+			.pMapEntries = Entries.data(),
+			.dataSize = Data.size() * sizeof(uint32_t),
+			.pData = Data.data()
+		};
+	}
+
 	RenderPipeline RenderPipeline::Create(RenderContext renderContext, 
 		const VkRenderPass& renderPass,
 		uint32_t subpassIndex,
@@ -114,35 +142,14 @@ namespace vkmmc
 		VkPrimitiveTopology topology)
 	{
 		check(shaderStages && shaderStageCount > 0);
-		RenderPipelineBuilder builder(renderContext);
-		// Input configuration
-		builder.InputDescription = inputDescription;
-		builder.SubpassIndex = subpassIndex;
-		builder.Topology = topology;
-		// Shader stages
-		ShaderCompiler compiler(renderContext);
-		for (uint32_t i = 0; i < shaderStageCount; ++i)
-		{
-			compiler.ProcessShaderFile(shaderStages[i].Filepath.c_str(), shaderStages[i].Stage);
-			VkShaderModule compiled = compiler.GetCompiledModule(shaderStages[i].Stage);
-			builder.ShaderStages.push_back(vkinit::PipelineShaderStageCreateInfo(shaderStages[i].Stage, compiled));
-		}
-		// TODO: remove singleton dependency
-		compiler.GenerateResources(IRenderEngine::GetRenderEngineAs<VulkanRenderEngine>()->GetDescriptorSetLayoutCache());
-		// Pass layout info
-		builder.LayoutInfo = vkinit::PipelineLayoutCreateInfo();
-		builder.LayoutInfo.pushConstantRangeCount = compiler.GetPushConstantCount();
-		builder.LayoutInfo.pPushConstantRanges = compiler.GetPushConstantArray();
-		builder.LayoutInfo.setLayoutCount = compiler.GetDescriptorSetLayoutCount();
-		builder.LayoutInfo.pSetLayouts = compiler.GetDescriptorSetLayoutArray();
-		
-		// Build the new pipeline
-		RenderPipeline renderPipeline = builder.Build(renderPass);
-
-		// Free shader compiler cached data
-		compiler.ClearCachedData();
-
-		return renderPipeline;
+		RenderPipelineDescription description;
+		description.RenderPass = renderPass;
+		description.SubpassIndex = subpassIndex;
+		description.Shaders.assign(shaderStages, shaderStages + shaderStageCount);
+		description.ReflectLayout = true;
+		description.InputDescription = inputDescription;
+		description.Topology = topology;
+		return Create(renderContext, description);
 	}
 
 	RenderPipeline RenderPipeline::Create(
@@ -159,28 +166,61 @@ namespace vkmmc
 		VkPrimitiveTopology topology)
 	{
 		check(shaderStages && shaderStageCount > 0);
+		RenderPipelineDescription description;
+		description.RenderPass = renderPass;
+		description.SubpassIndex = subpassIndex;
+		description.Shaders.assign(shaderStages, shaderStages + shaderStageCount);
+		description.ReflectLayout = false;
+		if (layoutCount)
+			description.Layouts.assign(layouts, layouts + layoutCount);
+		if (pushConstantCount)
+			description.PushConstants.assign(pushConstants, pushConstants + pushConstantCount);
+		description.InputDescription = inputDescription;
+		description.Topology = topology;
+		return Create(renderContext, description);
+	}
+
+	RenderPipeline RenderPipeline::Create(const RenderContext& renderContext, const RenderPipelineDescription& description)
+	{
+		check(!description.Shaders.empty());
 		RenderPipelineBuilder builder(renderContext);
 		// Input configuration
-		builder.InputDescription = inputDescription;
-		builder.SubpassIndex = subpassIndex;
-		builder.Topology = topology;
+		builder.InputDescription = description.InputDescription;
+		builder.SubpassIndex = description.SubpassIndex;
+		builder.Topology = description.Topology;
 		// Shader stages
 		ShaderCompiler compiler(renderContext);
-		for (uint32_t i = 0; i < shaderStageCount; ++i)
+		const VkSpecializationInfo specializationInfo = description.Specialization.GetInfo();
+		for (const ShaderDescription& shader : description.Shaders)
 		{
-			compiler.ProcessShaderFile(shaderStages[i].Filepath.c_str(), shaderStages[i].Stage);
-			VkShaderModule compiled = compiler.GetCompiledModule(shaderStages[i].Stage);
-			builder.ShaderStages.push_back(vkinit::PipelineShaderStageCreateInfo(shaderStages[i].Stage, compiled));
+			compiler.ProcessShaderFile(shader.Filepath.c_str(), shader.Stage);
+			VkShaderModule compiled = compiler.GetCompiledModule(shader.Stage);
+			VkPipelineShaderStageCreateInfo stageInfo = vkinit::PipelineShaderStageCreateInfo(shader.Stage, compiled);
+			if (!description.Specialization.IsEmpty())
+				stageInfo.pSpecializationInfo = &specializationInfo;
+			builder.ShaderStages.push_back(stageInfo);
 		}
 		// Pass layout info
 		builder.LayoutInfo = vkinit::PipelineLayoutCreateInfo();
-		builder.LayoutInfo.pushConstantRangeCount = pushConstantCount;
-		builder.LayoutInfo.pPushConstantRanges = pushConstants;
-		builder.LayoutInfo.setLayoutCount = layoutCount;
-		builder.LayoutInfo.pSetLayouts = layouts;
+		if (description.ReflectLayout)
+		{
+			// TODO: remove singleton dependency
+			compiler.GenerateResources(IRenderEngine::GetRenderEngineAs<VulkanRenderEngine>()->GetDescriptorSetLayoutCache());
+			builder.LayoutInfo.pushConstantRangeCount = compiler.GetPushConstantCount();
+			builder.LayoutInfo.pPushConstantRanges = compiler.GetPushConstantArray();
+			builder.LayoutInfo.setLayoutCount = compiler.GetDescriptorSetLayoutCount();
+			builder.LayoutInfo.pSetLayouts = compiler.GetDescriptorSetLayoutArray();
+		}
+		else
+		{
+			builder.LayoutInfo.pushConstantRangeCount = (uint32_t)description.PushConstants.size();
+			builder.LayoutInfo.pPushConstantRanges = description.PushConstants.data();
+			builder.LayoutInfo.setLayoutCount = (uint32_t)description.Layouts.size();
+			builder.LayoutInfo.pSetLayouts = description.Layouts.data();
+		}
 
 		// Build the new pipeline
-		RenderPipeline renderPipeline = builder.Build(renderPass);
+		RenderPipeline renderPipeline = builder.Build(description.RenderPass);
 
 		// Free shader compiler cached data
 		compiler.ClearCachedData();
@@ -205,4 +245,160 @@ namespace vkmmc
 		m_pipeline = VK_NULL_HANDLE;
 		m_pipelineLayout = VK_NULL_HANDLE;
 	}
-}
\ No newline at end of file
+
+	void PipelineBuildQueue::Add(const RenderPipelineDescription& description, RenderPipeline* target)
+	{
+		check(target && !target->IsValid());
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requests.push_back({ description, target });
+	}
+
+	void PipelineBuildQueue::Flush(const RenderContext& renderContext, WorkerPool& workerPool, PipelineHotReload* hotReload)
+	{
+		std::vector<Request> requests;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			requests.swap(m_requests);
+		}
+		if (requests.empty())
+			return;
+		auto start = std::chrono::high_resolution_clock::now();
+		// Shader library, layout cache and pipeline cache are thread safe.
+		workerPool.ParallelFor((uint32_t)requests.size(), [&](uint32_t i)
+			{
+				*requests[i].Target = RenderPipeline::Create(renderContext, requests[i].Description);
+			});
+		auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start);
+		Logf(LogLevel::Ok, "%u render pipelines built in %.3f ms.\n", (uint32_t)requests.size(), (double)elapsed.count() * 1e-3);
+		if (hotReload)
+		{
+			for (const Request& request : requests)
+				hotReload->Register(request.Description, request.Target);
+		}
+	}
+
+	void PipelineVariantCache::Init(const RenderContext& renderContext, const RenderPipelineDescription& description, SpecializeFunction&& specialize)
+	{
+		check(specialize && !m_thread.joinable());
+		m_renderContext = renderContext;
+		m_description = description;
+		m_specialize = std::move(specialize);
+		m_exit = false;
+		m_thread = std::thread(&PipelineVariantCache::BuildLoop, this);
+	}
+
+	void PipelineVariantCache::Destroy(const RenderContext& renderContext)
+	{
+		if (m_thread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_exit = true;
+			}
+			m_requestCondition.notify_all();
+			m_thread.join();
+		}
+		for (auto& it : m_variants)
+			it.second.Pipeline.Destroy(renderContext);
+		for (RetiredPipeline& retired : m_retired)
+			retired.Pipeline.Destroy(renderContext);
+		m_variants.clear();
+		m_retired.clear();
+		m_requests.clear();
+		m_basePipeline = VK_NULL_HANDLE;
+	}
+
+	RenderPipeline PipelineVariantCache::Get(uint32_t key, const RenderPipeline& base)
+	{
+		const uint32_t frameCounter = m_frameCounter++;
+		for (size_t i = 0; i < m_retired.size();)
+		{
+			if (frameCounter - m_retired[i].FrameCounter >= globals::MaxOverlappedFrames)
+			{
+				m_retired[i].Pipeline.Destroy(m_renderContext);
+				m_retired[i] = m_retired.back();
+				m_retired.pop_back();
+			}
+			else
+				++i;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (base.GetPipelineHandle() != m_basePipeline)
+			{
+				// Base rebuilt with new shaders, variants of the old ones must not be used anymore.
+				for (auto& it : m_variants)
+				{
+					if (it.second.Pipeline.IsValid())
+						m_retired.push_back({ it.second.Pipeline, frameCounter });
+					it.second.Pipeline = RenderPipeline();
+					it.second.Failed = false;
+				}
+				m_basePipeline = base.GetPipelineHandle();
+				++m_generation;
+			}
+			Variant& variant = m_variants[key];
+			if (variant.Pipeline.IsValid())
+				return variant.Pipeline;
+			if (variant.Building || variant.Failed)
+				return base;
+			variant.Building = true;
+			m_requests.push_back({ key, m_generation });
+		}
+		m_requestCondition.notify_one();
+		return base;
+	}
+
+	void PipelineVariantCache::BuildLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true)
+		{
+			m_requestCondition.wait(lock, [this]() { return m_exit || !m_requests.empty(); });
+			if (m_exit)
+				break;
+			// Oldest request first, it is the one the frame has waited for the longest.
+			const BuildRequest request = m_requests.front();
+			m_requests.erase(m_requests.begin());
+			if (request.Generation != m_generation)
+			{
+				// Requested for replaced shaders, Get asks again with the current ones.
+				m_variants[request.Key].Building = false;
+				continue;
+			}
+			lock.unlock();
+			Build(request.Key, request.Generation);
+			lock.lock();
+		}
+	}
+
+	void PipelineVariantCache::Build(uint32_t key, uint32_t generation)
+	{
+		RenderPipelineDescription description = m_description;
+		m_specialize(key, description.Specialization);
+		RenderPipeline pipeline = RenderPipeline::Create(m_renderContext, description);
+		bool stored = false;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Variant& variant = m_variants[key];
+			variant.Building = false;
+			if (generation == m_generation)
+			{
+				if (pipeline.IsValid())
+				{
+					variant.Pipeline = pipeline;
+					stored = true;
+				}
+				else
+				{
+					Logf(LogLevel::Error, "Failed to build pipeline variant 0x%x, using base pipeline.\n", key);
+					variant.Failed = true;
+				}
+			}
+		}
+		// Failed or built for replaced shaders, no frame has used it.
+		if (!stored)
+			pipeline.Destroy(m_renderContext);
+	}
+}
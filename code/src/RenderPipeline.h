@@ -3,13 +3,21 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <string>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <unordered_map>
 #include "VulkanBuffer.h"
+#include "RenderContext.h"
 
 namespace vkmmc
 {
 	// Forward declarations
 	struct RenderContext;
 	class RenderPipeline;
+	class WorkerPool;
+	class PipelineHotReload;
 	
 	struct ShaderDescription
 	{
@@ -17,6 +25,33 @@ namespace vkmmc
 		VkShaderStageFlagBits Stage;
 	};
 
+	// 32 bit specialization constants (int, uint, bool), shared by every stage of a pipeline.
+	struct SpecializationConstants
+	{
+		std::vector<VkSpecializationMapEntry> Entries;
+		std::vector<uint32_t> Data;
+
+		void Set(uint32_t constantId, uint32_t value);
+		// Points to Entries and Data, valid while the constants are not modified.
+		VkSpecializationInfo GetInfo() const;
+		inline bool IsEmpty() const { return Entries.empty(); }
+	};
+
+	// Arguments of RenderPipeline::Create, kept to build the pipeline later.
+	struct RenderPipelineDescription
+	{
+		VkRenderPass RenderPass{ VK_NULL_HANDLE };
+		uint32_t SubpassIndex{ 0 };
+		std::vector<ShaderDescription> Shaders;
+		// Generate descriptor set layouts and push constants from shader reflection, ignore the arrays below.
+		bool ReflectLayout{ true };
+		std::vector<VkDescriptorSetLayout> Layouts;
+		std::vector<VkPushConstantRange> PushConstants;
+		VertexInputLayout InputDescription;
+		VkPrimitiveTopology Topology{ VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST };
+		SpecializationConstants Specialization;
+	};
+
 	class RenderPipelineBuilder
 	{
 	public:
@@ -81,6 +116,8 @@ namespace vkmmc
 			const VertexInputLayout& inputDescription,
 			VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
 
+		static RenderPipeline Create(const RenderContext& renderContext, const RenderPipelineDescription& description);
+
 		bool SetupPipeline(VkPipeline pipeline, VkPipelineLayout pipelineLayout);
 		void Destroy(const RenderContext& renderContext);
 		inline bool IsValid() const { return m_pipeline != VK_NULL_HANDLE && m_pipelineLayout != VK_NULL_HANDLE; }
@@ -94,4 +131,81 @@ namespace vkmmc
 		VkPipeline m_pipeline = VK_NULL_HANDLE;
 		VkPipelineLayout m_pipelineLayout = VK_NULL_HANDLE;
 	};
-}
\ No newline at end of file
+
+	/**
+	 * Pipelines registered by renderers at init and built concurrently in the worker pool.
+	 * Target pipelines are written when Flush returns, renderers must not use them before.
+	 */
+	class PipelineBuildQueue
+	{
+		struct Request
+		{
+			RenderPipelineDescription Description;
+			RenderPipeline* Target;
+		};
+	public:
+		void Add(const RenderPipelineDescription& description, RenderPipeline* target);
+		// Build every pending pipeline and wait for them.
+		// hotReload: optional, built pipelines are registered to be rebuilt when their shaders change.
+		void Flush(const RenderContext& renderContext, WorkerPool& workerPool, PipelineHotReload* hotReload = nullptr);
+
+	private:
+		std::vector<Request> m_requests;
+		std::mutex m_mutex;
+	};
+
+	/**
+	 * Pipelines built from the same description with different specialization constants, keyed by feature bits.
+	 * Missing variants are built one at a time in a background thread of the cache, never in the worker pool,
+	 * so the threads recording a frame never end up building a pipeline. Base pipeline is used until they are
+	 * ready, selecting a new variant never stalls the frame.
+	 */
+	class PipelineVariantCache
+	{
+		struct Variant
+		{
+			RenderPipeline Pipeline;
+			bool Building{ false };
+			bool Failed{ false };
+		};
+		struct RetiredPipeline
+		{
+			RenderPipeline Pipeline;
+			uint32_t FrameCounter;
+		};
+		struct BuildRequest
+		{
+			uint32_t Key;
+			uint32_t Generation;
+		};
+	public:
+		// Fills the specialization constants of the variant key.
+		typedef std::function<void(uint32_t key, SpecializationConstants& constants)> SpecializeFunction;
+
+		void Init(const RenderContext& renderContext, const RenderPipelineDescription& description, SpecializeFunction&& specialize);
+		// Waits for the variant being built, queued ones are dropped.
+		void Destroy(const RenderContext& renderContext);
+		// Call once per frame from the main thread. Returns the variant of key, or base while it is not built.
+		// Variants are discarded when base changes (shader hot reload) and rebuilt on demand.
+		RenderPipeline Get(uint32_t key, const RenderPipeline& base);
+
+	private:
+		void BuildLoop();
+		void Build(uint32_t key, uint32_t generation);
+
+		RenderContext m_renderContext;
+		RenderPipelineDescription m_description;
+		SpecializeFunction m_specialize;
+		std::unordered_map<uint32_t, Variant> m_variants;
+		// Variants of a previous base, destroyed when the frames in flight are done.
+		std::vector<RetiredPipeline> m_retired;
+		VkPipeline m_basePipeline{ VK_NULL_HANDLE };
+		uint32_t m_generation{ 0 };
+		uint32_t m_frameCounter{ 0 };
+		std::vector<BuildRequest> m_requests;
+		std::thread m_thread;
+		std::mutex m_mutex;
+		std::condition_variable m_requestCondition;
+		bool m_exit{ false };
+	};
+}
@@ -61,6 +61,15 @@ namespace vkmmc
 			case FORMAT_R8G8B8A8: return VK_FORMAT_R8G8B8A8_SRGB;
 			case FORMAT_B8G8R8A8: return VK_FORMAT_B8G8R8A8_SRGB;
 			case FORMAT_D32: return VK_FORMAT_D32_SFLOAT;
+			case FORMAT_R8G8B8A8_UNORM: return VK_FORMAT_R8G8B8A8_UNORM;
+			case FORMAT_BC1_SRGB: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			case FORMAT_BC1_UNORM: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			case FORMAT_BC3_SRGB: return VK_FORMAT_BC3_SRGB_BLOCK;
+			case FORMAT_BC3_UNORM: return VK_FORMAT_BC3_UNORM_BLOCK;
+			case FORMAT_BC4_UNORM: return VK_FORMAT_BC4_UNORM_BLOCK;
+			case FORMAT_BC5_UNORM: return VK_FORMAT_BC5_UNORM_BLOCK;
+			case FORMAT_BC7_SRGB: return VK_FORMAT_BC7_SRGB_BLOCK;
+			case FORMAT_BC7_UNORM: return VK_FORMAT_BC7_UNORM_BLOCK;
 			}
 			Logf(LogLevel::Error, "Invalid format type: %d\n", format);
 			check(false && "Invalid format type.");
@@ -77,11 +86,67 @@ namespace vkmmc
 			case VK_FORMAT_B8G8R8_SRGB: return FORMAT_B8G8R8;
 			case VK_FORMAT_B8G8R8A8_SRGB: return FORMAT_B8G8R8A8;
 			case VK_FORMAT_D32_SFLOAT: return FORMAT_D32;
+			case VK_FORMAT_R8G8B8A8_UNORM: return FORMAT_R8G8B8A8_UNORM;
+			case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return FORMAT_BC1_SRGB;
+			case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+			case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return FORMAT_BC1_UNORM;
+			case VK_FORMAT_BC3_SRGB_BLOCK: return FORMAT_BC3_SRGB;
+			case VK_FORMAT_BC3_UNORM_BLOCK: return FORMAT_BC3_UNORM;
+			case VK_FORMAT_BC4_UNORM_BLOCK: return FORMAT_BC4_UNORM;
+			case VK_FORMAT_BC5_UNORM_BLOCK: return FORMAT_BC5_UNORM;
+			case VK_FORMAT_BC7_SRGB_BLOCK: return FORMAT_BC7_SRGB;
+			case VK_FORMAT_BC7_UNORM_BLOCK: return FORMAT_BC7_UNORM;
 			}
 			Logf(LogLevel::Error, "Invalid format type: %d\n", format);
 			check(false && "Invalid format type.");
 			return FORMAT_INVALID;
 		}
+
+		bool IsBlockCompressed(EFormat format)
+		{
+			switch (format)
+			{
+			case FORMAT_BC1_SRGB:
+			case FORMAT_BC1_UNORM:
+			case FORMAT_BC3_SRGB:
+			case FORMAT_BC3_UNORM:
+			case FORMAT_BC4_UNORM:
+			case FORMAT_BC5_UNORM:
+			case FORMAT_BC7_SRGB:
+			case FORMAT_BC7_UNORM:
+				return true;
+			}
+			return false;
+		}
+
+		uint32_t FormatLevelSize(EFormat format, uint32_t width, uint32_t height)
+		{
+			width = __max(width, 1u);
+			height = __max(height, 1u);
+			switch (format)
+			{
+			case FORMAT_R8G8B8:
+			case FORMAT_B8G8R8: return width * height * 3;
+			case FORMAT_R8G8B8A8:
+			case FORMAT_B8G8R8A8:
+			case FORMAT_R8G8B8A8_UNORM:
+			case FORMAT_D32: return width * height * 4;
+			// 4x4 blocks of 8 bytes
+			case FORMAT_BC1_SRGB:
+			case FORMAT_BC1_UNORM:
+			case FORMAT_BC4_UNORM: return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+			// 4x4 blocks of 16 bytes
+			case FORMAT_BC3_SRGB:
+			case FORMAT_BC3_UNORM:
+			case FORMAT_BC5_UNORM:
+			case FORMAT_BC7_SRGB:
+			case FORMAT_BC7_UNORM: return ((width + 3) / 4) * ((height + 3) / 4) * 16;
+			}
+			Logf(LogLevel::Error, "Invalid format type: %d\n", format);
+			check(false && "Invalid format type.");
+			return 0;
+		}
 	}
 
 	void utils::CmdSubmitTransfer(const RenderContext& renderContext, std::function<void(VkCommandBuffer)>&& fillCmdCallback)
@@ -6,11 +6,11 @@
 #include <string>
 #include <functional>
 
+#include "Platform.h"
+
 #ifdef _WIN32
 #include <windows.h>
 #include <winnt.h>
-#else
-#error SO not supported.
 #endif
 #define DEFINE_ENUM_BIT_OPERATORS(enumType) DEFINE_ENUM_FLAG_OPERATORS(enumType)
 #define BIT_N(n) (1 << n)
@@ -36,6 +36,16 @@ namespace vkmmc
 		FORMAT_R8G8B8A8,
 		FORMAT_B8G8R8A8,
 		FORMAT_D32,
+		FORMAT_R8G8B8A8_UNORM,
+		// Block compressed formats
+		FORMAT_BC1_SRGB,
+		FORMAT_BC1_UNORM,
+		FORMAT_BC3_SRGB,
+		FORMAT_BC3_UNORM,
+		FORMAT_BC4_UNORM,
+		FORMAT_BC5_UNORM,
+		FORMAT_BC7_SRGB,
+		FORMAT_BC7_UNORM,
 		FORMAT_INVALID = 0x7fffffff
 	};
 	namespace types
@@ -45,6 +55,10 @@ namespace vkmmc
 
 		VkFormat FormatType(EFormat format);
 		EFormat FormatType(VkFormat format);
+
+		bool IsBlockCompressed(EFormat format);
+		// Size in bytes of an image level with given dimensions.
+		uint32_t FormatLevelSize(EFormat format, uint32_t width, uint32_t height);
 	}
 
 	namespace utils
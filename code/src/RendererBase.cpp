@@ -1 +1,19 @@
 // src file for vkmmc project 
+#include "RendererBase.h"
+#include "Debug.h"
+
+namespace vkmmc
+{
+	void RecordJob::GetRange(uint32_t count, uint32_t& first, uint32_t& last) const
+	{
+		check(Index < Count);
+		first = (uint32_t)((uint64_t)count * Index / Count);
+		last = (uint32_t)((uint64_t)count * (Index + 1) / Count);
+	}
+
+	uint32_t RecordJob::GetJobCount(uint32_t count)
+	{
+		uint32_t jobCount = count / globals::MinItemsPerRecordJob;
+		return __max(__min(jobCount, globals::MaxRecordJobsPerRenderer), 1u);
+	}
+}
@@ -14,21 +14,45 @@ namespace vkmmc
 	class DescriptorLayoutCache;
 	class DescriptorAllocator;
 	struct GlobalShaderData;
+	struct DrawStats;
 
 	struct RendererCreateInfo
 	{
 		RenderContext RContext;
 		DescriptorLayoutCache* LayoutCache{nullptr};
-		DescriptorAllocator* DescriptorAllocator{nullptr};
+		vkmmc::DescriptorAllocator* DescriptorAllocator{nullptr};
 
 		VkRenderPass RenderPassArray[RENDER_PASS_COUNT];
 		std::vector<VkImageView> ShadowMapAttachments[globals::MaxOverlappedFrames];
 		UniformBuffer* FrameUniformBufferArray[globals::MaxOverlappedFrames];
+		vkmmc::TransientBuffer* TransientBuffer{ nullptr };
+		// Pipelines are queued at init and built in parallel before the first frame.
+		PipelineBuildQueue* PipelineQueue{ nullptr };
+
+		// Bindless materials layout, null when the device does not support descriptor indexing.
+		VkDescriptorSetLayout BindlessLayout{ VK_NULL_HANDLE };
 
 		VkPushConstantRange* ConstantRange = nullptr;
 		uint32_t ConstantRangeCount = 0;
 	};
 
+	// Part of the work of a renderer in a pass, recorded in its own secondary command buffer.
+	struct RecordJob
+	{
+		VkCommandBuffer Cmd;
+		uint32_t AttachmentIndex;
+		// Job in [0, Count)
+		uint32_t Index;
+		uint32_t Count;
+		// Counters of this job, owned by the recording thread.
+		DrawStats* Stats{ nullptr };
+
+		// Range of count items processed by this job.
+		void GetRange(uint32_t count, uint32_t& first, uint32_t& last) const;
+		// Jobs to split a list of count items, at least globals::MinItemsPerRecordJob per job.
+		static uint32_t GetJobCount(uint32_t count);
+	};
+
 	class IRendererBase
 	{
 	public:
@@ -39,7 +63,13 @@ namespace vkmmc
 		virtual void Destroy(const RenderContext& renderContext) = 0;
 
 		virtual void PrepareFrame(const RenderContext& renderContext, RenderFrameContext& renderFrameContext) = 0;
-		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex) = 0;
+		// Called once per job, maybe from worker threads and concurrently with other renderers.
+		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job) = 0;
+		virtual uint32_t GetRecordJobCount(const RenderFrameContext& renderFrameContext) const { return 1; }
+		// False for renderers that must record in the main thread (ImGui state is not thread safe).
+		virtual bool IsParallelRecordingSupported() const { return true; }
+		// GPU profiler scope name.
+		virtual const char* GetName() const { return "Renderer"; }
 		//virtual void EndFrame(const RenderContext& renderContext) = 0;
 
 		// Debug
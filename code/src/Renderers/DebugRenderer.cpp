@@ -9,7 +9,11 @@
 #include "RendererBase.h"
 #include "glm/gtx/quaternion.hpp"
 #include "glm/gtx/transform.hpp"
+#ifdef _WIN32
 #include <corecrt_math_defines.h>
+#else
+#include <cmath>
+#endif
 #include "imgui_internal.h"
 
 
@@ -116,14 +120,12 @@ namespace vkmmc
         uint32_t descriptionCount = sizeof(descriptions) / sizeof(ShaderDescription);
 
         VertexInputLayout inputLayout = VertexInputLayout::BuildVertexInputLayout({ EAttributeType::Float4, EAttributeType::Float4 });
-        m_renderPipeline = RenderPipeline::Create(info.RContext, info.RenderPassArray[RENDER_PASS_COLOR], 0,
-            descriptions, descriptionCount, inputLayout, VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
-
-        // VertexBuffer
-        BufferCreateInfo vbInfo;
-        vbInfo.Size = sizeof(debugrender::LineVertex) * debugrender::LineBatch::MaxLines;
-        vbInfo.Data = nullptr;
-        m_lineVertexBuffer.Init(info.RContext, vbInfo);
+        RenderPipelineDescription lineDescription;
+        lineDescription.RenderPass = info.RenderPassArray[RENDER_PASS_COLOR];
+        lineDescription.Shaders.assign(descriptions, descriptions + descriptionCount);
+        lineDescription.InputDescription = inputLayout;
+        lineDescription.Topology = VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+        info.PipelineQueue->Add(lineDescription, &m_renderPipeline);
 
         QuadVertex vertices[] =
         {
@@ -149,70 +151,75 @@ namespace vkmmc
             {.Filepath = globals::QuadFragmentShader, .Stage = VK_SHADER_STAGE_FRAGMENT_BIT},
         };
         inputLayout = VertexInputLayout::BuildVertexInputLayout({ EAttributeType::Float3, EAttributeType::Float2 });
-        m_quadPipeline = RenderPipeline::Create(info.RContext, info.RenderPassArray[RENDER_PASS_COLOR], 0, shaders, 2, inputLayout);
-
-        VkSamplerCreateInfo samplerInfo = vkinit::SamplerCreateInfo(VK_FILTER_LINEAR);
-        vkCreateSampler(info.RContext.Device, &samplerInfo, nullptr, &m_depthSampler);
-
-        // Submit buffer uniform info
-        m_frameData.resize(globals::MaxOverlappedFrames);
-        for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
-        {
-            // Uniform buffer
-            UniformBuffer* buffer = info.FrameUniformBufferArray[i];
-            buffer->AllocUniform(info.RContext, "QuadUBO", sizeof(float) * 2);
-            VkDescriptorBufferInfo bufferInfo = buffer->GenerateDescriptorBufferInfo("QuadUBO");
-
-            DescriptorBuilder::Create(*info.LayoutCache, *info.DescriptorAllocator)
-                .BindBuffer(0, &bufferInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
-                .Build(info.RContext, m_frameData[i].SetUBO);
-        }
+        RenderPipelineDescription quadDescription;
+        quadDescription.RenderPass = info.RenderPassArray[RENDER_PASS_COLOR];
+        quadDescription.Shaders.assign(shaders, shaders + 2);
+        quadDescription.InputDescription = inputLayout;
+        info.PipelineQueue->Add(quadDescription, &m_quadPipeline);
+
+        SamplerBuilder samplerBuilder;
+        m_depthSampler = samplerBuilder.Build(info.RContext);
+        // Clip params set is built per frame when the quad is drawn.
+        m_layoutCache = info.LayoutCache;
     }
 
     void DebugRenderer::Destroy(const RenderContext& renderContext)
     {
         m_quadVertexBuffer.Destroy(renderContext);
         m_quadIndexBuffer.Destroy(renderContext);
-        vkDestroySampler(renderContext.Device, m_depthSampler, nullptr);
+        m_depthSampler.Destroy(renderContext);
         m_quadPipeline.Destroy(renderContext);
-        m_lineVertexBuffer.Destroy(renderContext);
         m_renderPipeline.Destroy(renderContext);
     }
 
     void DebugRenderer::PrepareFrame(const RenderContext& renderContext, RenderFrameContext& renderFrameContext)
     {
-		float ubo[2] = { debugrender::NearClip, debugrender::FarClip };
-		renderFrameContext.GlobalBuffer.SetUniform(renderContext, "QuadUBO", ubo, sizeof(float) * 2);
     }
 
-    void DebugRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex)
+    void DebugRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job)
     {
         PROFILE_SCOPE(DebugPass);
+        // Lines are written in the transient buffer, no transfer needed.
+        TransientBuffer::Allocation lines;
         if (debugrender::GLineBatch.Index > 0)
+            lines = renderFrameContext.TransientBuffer->Push(debugrender::GLineBatch.LineArray,
+                sizeof(debugrender::LineVertex) * debugrender::GLineBatch.Index, sizeof(debugrender::LineVertex));
+        if (lines.Data)
         {
-            // Flush lines to vertex buffer
-            GPUBuffer::SubmitBufferToGpu(m_lineVertexBuffer, &debugrender::GLineBatch.LineArray, sizeof(debugrender::LineVertex) * debugrender::GLineBatch.Index);
 
-            vkCmdBindPipeline(renderFrameContext.GraphicsCommand, VK_PIPELINE_BIND_POINT_GRAPHICS, m_renderPipeline.GetPipelineHandle());
+            vkCmdBindPipeline(job.Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_renderPipeline.GetPipelineHandle());
             VkDescriptorSet sets[] = { renderFrameContext.CameraDescriptorSet };
             uint32_t setCount = sizeof(sets) / sizeof(VkDescriptorSet);
-            vkCmdBindDescriptorSets(renderFrameContext.GraphicsCommand, VK_PIPELINE_BIND_POINT_GRAPHICS,
+            vkCmdBindDescriptorSets(job.Cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
                 m_renderPipeline.GetPipelineLayoutHandle(), 0, setCount, sets, 0, nullptr);
-            ++GRenderStats.SetBindingCount;
-            m_lineVertexBuffer.Bind(renderFrameContext.GraphicsCommand);
-            vkCmdDraw(renderFrameContext.GraphicsCommand, debugrender::GLineBatch.Index, 1, 0, 0);
-            debugrender::GLineBatch.Index = 0;
-            ++GRenderStats.DrawCalls;
+            ++job.Stats->SetBindingCount;
+            VkDeviceSize offset = lines.Offset;
+            vkCmdBindVertexBuffers(job.Cmd, 0, 1, &lines.Buffer, &offset);
+            ++job.Stats->BufferBindCount;
+            vkCmdDraw(job.Cmd, debugrender::GLineBatch.Index, 1, 0, 0);
+            ++job.Stats->DrawCalls;
         }
+        debugrender::GLineBatch.Index = 0;
 
         if (m_debugDepthMap && debugrender::DebugTexture != VK_NULL_HANDLE)
         {
-            VkCommandBuffer cmd = renderFrameContext.GraphicsCommand;
+            // Clip params live in the transient buffer, their set in the frame allocator of this thread.
+            const float ubo[2] = { debugrender::NearClip, debugrender::FarClip };
+            TransientBuffer::Allocation clip = renderFrameContext.TransientBuffer->Push(ubo, sizeof(ubo));
+            if (!clip.Data)
+                return;
+            VkDescriptorBufferInfo bufferInfo{ .buffer = clip.Buffer, .offset = clip.Offset, .range = sizeof(ubo) };
+            VkDescriptorSet clipSet;
+            DescriptorBuilder::Create(*m_layoutCache, renderFrameContext.FrameDescriptorAllocator->Get())
+                .BindBuffer(0, &bufferInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+                .Build(renderContext, clipSet);
+            VkCommandBuffer cmd = job.Cmd;
             vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_quadPipeline.GetPipelineHandle());
-            VkDescriptorSet sets[2] = { m_frameData[renderFrameContext.FrameIndex].SetUBO, debugrender::DebugTexture };
+            VkDescriptorSet sets[2] = { clipSet, debugrender::DebugTexture };
             vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_quadPipeline.GetPipelineLayoutHandle(), 0, 2, sets, 0, nullptr);
             m_quadVertexBuffer.Bind(cmd);
             m_quadIndexBuffer.Bind(cmd);
+            job.Stats->BufferBindCount += 2;
             vkCmdDrawIndexed(cmd, 6, 1, 0, 0, 0);
         }
     }
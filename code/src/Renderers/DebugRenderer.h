@@ -3,6 +3,7 @@
 
 #pragma once
 #include "RendererBase.h"
+#include "Texture.h"
 #include <glm/glm.hpp>
 
 namespace vkmmc
@@ -20,11 +21,6 @@ namespace vkmmc
 
 	class DebugRenderer : public IRendererBase
 	{
-		struct FrameData
-		{
-			VkDescriptorSet SetUBO;
-		};
-
 		struct QuadVertex
 		{
 			glm::vec3 Position;
@@ -34,18 +30,18 @@ namespace vkmmc
 		virtual void Init(const RendererCreateInfo& info) override;
 		virtual void Destroy(const RenderContext& renderContext) override;
 		virtual void PrepareFrame(const RenderContext& renderContext, RenderFrameContext& renderFrameContext) override;
-		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex) override;
+		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job) override;
+		virtual const char* GetName() const override { return "DebugRenderer"; }
 		virtual void ImGuiDraw() override;
 	protected:
 		// Render State
 		RenderPipeline m_renderPipeline;
-		VertexBuffer m_lineVertexBuffer;
 
-		std::vector<FrameData> m_frameData;
+		DescriptorLayoutCache* m_layoutCache{ nullptr };
 		VertexBuffer m_quadVertexBuffer;
 		IndexBuffer m_quadIndexBuffer;
 		RenderPipeline m_quadPipeline;
-		VkSampler m_depthSampler;
+		Sampler m_depthSampler;
 		bool m_debugDepthMap = true;
 	};
 
@@ -11,7 +11,7 @@
 
 #include "DebugRenderer.h"
 #include "GenericUtils.h"
-#include "glm/ext/matrix_clip_space.inl"
+#include "glm/ext/matrix_clip_space.hpp"
 #include "ModelRenderer.h"
 
 
@@ -20,6 +20,41 @@ namespace vkmmc
 {
 	bool GUseCameraForShadowMapping = false;
 
+	namespace lighting_internal
+	{
+		// Specialization constant ids of basic.vert and basic.frag.
+		enum ELightingConstant : uint32_t
+		{
+			LIGHTING_CONSTANT_MAX_POINT_LIGHTS = 0,
+			LIGHTING_CONSTANT_MAX_SPOT_LIGHTS = 1,
+			LIGHTING_CONSTANT_SHADOW_MAP_COUNT = 2,
+			LIGHTING_CONSTANT_PCF_RADIUS = 3,
+		};
+
+		// Round up to a power of two to keep the variant count low, shaders skip the lights over the active count.
+		uint32_t GetLightCountBucket(uint32_t count)
+		{
+			uint32_t bucket = count ? 1 : 0;
+			while (bucket < count)
+				bucket <<= 1;
+			return __min(bucket, EnvironmentData::MaxLights);
+		}
+
+		// Feature bits: point lights [0,4), spot lights [4,8), shadow maps [8,12), pcf radius [12,16).
+		uint32_t MakeVariantKey(uint32_t pointLights, uint32_t spotLights, uint32_t shadowMaps, uint32_t pcfRadius)
+		{
+			return pointLights | spotLights << 4 | shadowMaps << 8 | pcfRadius << 12;
+		}
+
+		void Specialize(uint32_t key, SpecializationConstants& constants)
+		{
+			constants.Set(LIGHTING_CONSTANT_MAX_POINT_LIGHTS, key & 0xf);
+			constants.Set(LIGHTING_CONSTANT_MAX_SPOT_LIGHTS, (key >> 4) & 0xf);
+			constants.Set(LIGHTING_CONSTANT_SHADOW_MAP_COUNT, (key >> 8) & 0xf);
+			constants.Set(LIGHTING_CONSTANT_PCF_RADIUS, (key >> 12) & 0xf);
+		}
+	}
+
 
 
 	ShadowMapPipeline::ShadowMapPipeline()
@@ -37,7 +72,7 @@ namespace vkmmc
 		check(!m_pipeline.IsValid());
 	}
 
-	void ShadowMapPipeline::Init(const RenderContext& renderContext, VkRenderPass renderPass, DescriptorAllocator* descriptorAllocator, DescriptorLayoutCache* layoutCache)
+	void ShadowMapPipeline::Init(const RenderContext& renderContext, VkRenderPass renderPass, DescriptorLayoutCache* layoutCache, PipelineBuildQueue* pipelineQueue)
 	{
 		// Depth pipeline
 		VkDescriptorSetLayout depthShaderInput[2];
@@ -49,17 +84,14 @@ namespace vkmmc
 			.Build(renderContext, &depthShaderInput[1]);
 
 		// CreatePipeline
-		ShaderDescription depthShader{ .Filepath = globals::DepthVertexShader, .Stage = VK_SHADER_STAGE_VERTEX_BIT };
-		const VertexInputLayout inputLayout = VertexInputLayout::GetStaticMeshVertexLayout();
-		m_pipeline = RenderPipeline::Create(
-			renderContext,
-			renderPass,
-			0,
-			&depthShader, 1,
-			depthShaderInput, sizeof(depthShaderInput) / sizeof(VkDescriptorSetLayout), nullptr, 
-			0,
-			inputLayout
-		);
+		RenderPipelineDescription description;
+		description.RenderPass = renderPass;
+		description.Shaders.push_back({ .Filepath = globals::DepthVertexShader, .Stage = VK_SHADER_STAGE_VERTEX_BIT });
+		description.ReflectLayout = false;
+		description.Layouts.assign(depthShaderInput, depthShaderInput + sizeof(depthShaderInput) / sizeof(VkDescriptorSetLayout));
+		description.InputDescription = VertexInputLayout::GetStaticMeshVertexLayout();
+		pipelineQueue->Add(description, &m_pipeline);
+		m_layoutCache = layoutCache;
 	}
 
 	void ShadowMapPipeline::Destroy(const RenderContext& renderContext)
@@ -69,16 +101,8 @@ namespace vkmmc
 
 	void ShadowMapPipeline::AddFrameData(const RenderContext& renderContext, UniformBuffer* buffer, DescriptorAllocator* descAllocator, DescriptorLayoutCache* layoutCache)
 	{
-		// Alloc info for depthVP matrix
-		buffer->AllocUniform(renderContext, UNIFORM_ID_SHADOW_MAP_VP, GetBufferSize());
-
+		// Depth view projections change every frame, their set is transient (see BuildDepthVPSet).
 		FrameData fd;
-		// Alloc desc set pointing to buffer
-		VkDescriptorBufferInfo depthBufferInfo = buffer->GenerateDescriptorBufferInfo(UNIFORM_ID_SHADOW_MAP_VP);
-		DescriptorBuilder::Create(*layoutCache, *descAllocator)
-			.BindBuffer(0, &depthBufferInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
-			.Build(renderContext, fd.DepthMVPSet);
-
 		// create descriptor set for model matrix array
 		VkDescriptorBufferInfo modelsBufferInfo = buffer->GenerateDescriptorBufferInfo(UNIFORM_ID_SCENE_MODEL_TRANSFORM_ARRAY);
 		DescriptorBuilder::Create(*layoutCache, *descAllocator)
@@ -129,21 +153,35 @@ namespace vkmmc
 		SetDepthVP(lightIndex, depthVP);
 	}
 
-	void ShadowMapPipeline::FlushToUniformBuffer(const RenderContext& renderContext, UniformBuffer* buffer)
+	void ShadowMapPipeline::PushDepthVP(TransientBuffer& buffer)
+	{
+		m_depthVPData = buffer.Push(m_depthMVPCache, GetBufferSize());
+	}
+
+	VkDescriptorSet ShadowMapPipeline::BuildDepthVPSet(const RenderContext& renderContext, DescriptorAllocator& frameAllocator) const
 	{
-		buffer->SetUniform(renderContext, UNIFORM_ID_SHADOW_MAP_VP, m_depthMVPCache, GetBufferSize());
+		if (!m_depthVPData.Data)
+			return VK_NULL_HANDLE;
+		// One matrix visible, the light is selected with the dynamic offset.
+		VkDescriptorBufferInfo bufferInfo{ .buffer = m_depthVPData.Buffer, .offset = m_depthVPData.Offset, .range = sizeof(glm::mat4) };
+		VkDescriptorSet set;
+		DescriptorBuilder::Create(*m_layoutCache, frameAllocator)
+			.BindBuffer(0, &bufferInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
+			.Build(renderContext, set);
+		return set;
 	}
 
-	void ShadowMapPipeline::RenderShadowMap(VkCommandBuffer cmd, const Scene* scene, uint32_t frameIndex, uint32_t lightIndex)
+	void ShadowMapPipeline::RenderShadowMap(VkCommandBuffer cmd, const Scene* scene, uint32_t frameIndex, VkDescriptorSet depthVPSet, uint32_t lightIndex, uint32_t firstObject, uint32_t lastObject, DrawStats& stats)
 	{
 		check(lightIndex < globals::MaxShadowMapAttachments);
 		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.GetPipelineHandle());
 
 		uint32_t depthVPOffset = sizeof(glm::mat4) * lightIndex;
 		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipeline.GetPipelineLayoutHandle(),
-			0, 1, &m_frameData[frameIndex].DepthMVPSet, 1, &depthVPOffset);
+			0, 1, &depthVPSet, 1, &depthVPOffset);
+		++stats.SetBindingCount;
 
-		scene->Draw(cmd, m_pipeline.GetPipelineLayoutHandle(), 1, m_frameData[frameIndex].ModelSet);
+		scene->Draw(cmd, m_pipeline.GetPipelineLayoutHandle(), 1, m_frameData[frameIndex].ModelSet, firstObject, lastObject, stats);
 	}
 
 	const glm::mat4& ShadowMapPipeline::GetDepthVP(uint32_t index) const
@@ -191,7 +229,7 @@ namespace vkmmc
 		imageInfo.sampler = m_debugSampler.GetSampler();
 		imageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
-		m_shadowMapPipeline.Init(info.RContext, info.RenderPassArray[RENDER_PASS_SHADOW_MAP], info.DescriptorAllocator, info.LayoutCache);
+		m_shadowMapPipeline.Init(info.RContext, info.RenderPassArray[RENDER_PASS_SHADOW_MAP], info.LayoutCache, info.PipelineQueue);
 		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; i++)
 		{
 			UniformBuffer* uniformBuffer = info.FrameUniformBufferArray[i];
@@ -248,7 +286,7 @@ namespace vkmmc
 				}
 			}
 		}
-		m_shadowMapPipeline.FlushToUniformBuffer(renderContext, &renderFrameContext.GlobalBuffer);
+		m_shadowMapPipeline.PushDepthVP(*renderFrameContext.TransientBuffer);
 
 		// Update light VP matrix for lighting pass
 		static constexpr glm::mat4 depthBias =
@@ -266,13 +304,23 @@ namespace vkmmc
 		renderFrameContext.GlobalBuffer.SetUniform(renderContext, UNIFORM_ID_LIGHT_VP, lightMatrix, sizeof(glm::mat4) * globals::MaxShadowMapAttachments);
 	}
 
-	void ShadowMapRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex)
+	void ShadowMapRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job)
 	{
-		check(attachmentIndex < globals::MaxShadowMapAttachments);
+		check(job.AttachmentIndex < globals::MaxShadowMapAttachments);
 		const EnvironmentData& envData = renderFrameContext.Scene->GetEnvironmentData();
 		uint32_t maxLights = __min((uint32_t)envData.ActiveSpotLightsCount, globals::MaxShadowMapAttachments);
+		uint32_t firstObject, lastObject;
+		job.GetRange(renderFrameContext.Scene->GetRenderObjectCount(), firstObject, lastObject);
+		const VkDescriptorSet depthVPSet = m_shadowMapPipeline.BuildDepthVPSet(renderContext, renderFrameContext.FrameDescriptorAllocator->Get());
+		if (depthVPSet == VK_NULL_HANDLE)
+			return;
 		for (uint32_t i = 0; i < maxLights; ++i)
-			m_shadowMapPipeline.RenderShadowMap(renderFrameContext.GraphicsCommand, renderFrameContext.Scene, renderFrameContext.FrameIndex, attachmentIndex);
+			m_shadowMapPipeline.RenderShadowMap(job.Cmd, renderFrameContext.Scene, renderFrameContext.FrameIndex, depthVPSet, job.AttachmentIndex, firstObject, lastObject, *job.Stats);
+	}
+
+	uint32_t ShadowMapRenderer::GetRecordJobCount(const RenderFrameContext& renderFrameContext) const
+	{
+		return RecordJob::GetJobCount(renderFrameContext.Scene->GetRenderObjectCount());
 	}
 
 	void ShadowMapRenderer::ImGuiDraw()
@@ -292,7 +340,7 @@ namespace vkmmc
 		ImGui::End();
 	}
 
-	LightingRenderer::LightingRenderer() : IRendererBase()
+	LightingRenderer::LightingRenderer() : IRendererBase(), m_pcfRadius(1)
 	{
 	}
 
@@ -301,12 +349,21 @@ namespace vkmmc
 		/**********************************/
 		/** Pipeline layout and pipeline **/
 		/**********************************/
+		const bool bindless = info.BindlessLayout != VK_NULL_HANDLE;
 		ShaderDescription shaderStageDescs[] =
 		{
 			{.Filepath = globals::BasicVertexShader, .Stage = VK_SHADER_STAGE_VERTEX_BIT},
-			{.Filepath = globals::BasicFragmentShader, .Stage = VK_SHADER_STAGE_FRAGMENT_BIT}
+			{.Filepath = bindless ? globals::BindlessFragmentShader : globals::BasicFragmentShader, .Stage = VK_SHADER_STAGE_FRAGMENT_BIT}
 		};
 
+		// Sampler for shadow map binding, immutable in the per frame layout.
+		SamplerBuilder builder;
+		//builder.AddressMode.AddressMode.U = SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		m_depthMapSampler = builder.Build(info.RContext);
+		VkSampler shadowMapSamplers[globals::MaxShadowMapAttachments];
+		for (uint32_t i = 0; i < globals::MaxShadowMapAttachments; ++i)
+			shadowMapSamplers[i] = m_depthMapSampler.GetSampler();
+
 		// This pipeline use dynamic descriptors, we have to initialize descriptor set layout manually.
 		VkDescriptorSetLayout layouts[3];
 		uint32_t layoutCount = sizeof(layouts) / sizeof(VkDescriptorSetLayout);
@@ -315,28 +372,29 @@ namespace vkmmc
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1)
 			.AddBinding(1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1)
 			.AddBinding(2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1)
-			.AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, globals::MaxShadowMapAttachments)
+			.AddBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, globals::MaxShadowMapAttachments, shadowMapSamplers)
 			.Build(info.RContext, &layouts[0]);
 		// Per draw descriptor (model, material...)
 		DescriptorSetLayoutBuilder::Create(*info.LayoutCache)
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 1)
 			.Build(info.RContext, &layouts[1]);
-		layouts[2] = MaterialRenderData::GetDescriptorSetLayout(info.RContext, *info.LayoutCache);
-
-		m_renderPipeline = RenderPipeline::Create(
-			info.RContext,
-			info.RenderPassArray[RENDER_PASS_LIGHTING],
-			0, // subpass
-			shaderStageDescs,
-			sizeof(shaderStageDescs) / sizeof(ShaderDescription),
-			layouts, layoutCount, nullptr, 0,
-			VertexInputLayout::GetStaticMeshVertexLayout()
-		);
-
-		// Sampler for shadow map binding
-		SamplerBuilder builder;
-		//builder.AddressMode.AddressMode.U = SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		m_depthMapSampler = builder.Build(info.RContext);
+		// Bindless: every texture and material in one set, material index in push constants.
+		layouts[2] = bindless ? info.BindlessLayout : MaterialRenderData::GetDescriptorSetLayout(info.RContext, *info.LayoutCache);
+		VkPushConstantRange materialIndexRange{ .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT, .offset = 0, .size = sizeof(uint32_t) };
+
+		RenderPipelineDescription description;
+		description.RenderPass = info.RenderPassArray[RENDER_PASS_LIGHTING];
+		description.Shaders.assign(shaderStageDescs, shaderStageDescs + sizeof(shaderStageDescs) / sizeof(ShaderDescription));
+		description.ReflectLayout = false;
+		description.Layouts.assign(layouts, layouts + layoutCount);
+		if (bindless)
+			description.PushConstants.push_back(materialIndexRange);
+		description.InputDescription = VertexInputLayout::GetStaticMeshVertexLayout();
+		if (globals::EnableShaderVariants)
+			m_variantCache.Init(info.RContext, description, &lighting_internal::Specialize);
+		// Base pipeline with every light and shadow map, used until the variant in use is built.
+		lighting_internal::Specialize(lighting_internal::MakeVariantKey(EnvironmentData::MaxLights, EnvironmentData::MaxLights, globals::MaxShadowMapAttachments, m_pcfRadius), description.Specialization);
+		info.PipelineQueue->Add(description, &m_renderPipeline);
 
 		m_frameData.resize(globals::MaxOverlappedFrames);
 		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
@@ -365,7 +423,7 @@ namespace vkmmc
 				.BindBuffer(0, &cameraDescInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
 				.BindBuffer(1, &lightMatrixDescInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
 				.BindBuffer(2, &enviroDescInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
-				.BindImage(3, shadowMapDescInfo, globals::MaxShadowMapAttachments, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
+				.BindImage(3, shadowMapDescInfo, globals::MaxShadowMapAttachments, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0, shadowMapSamplers)
 				.Build(info.RContext, m_frameData[i].PerFrameSet);
 			DescriptorBuilder::Create(*info.LayoutCache, *info.DescriptorAllocator)
 				.BindBuffer(0, &modelsDescInfo, 1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT)
@@ -376,34 +434,68 @@ namespace vkmmc
 	void LightingRenderer::Destroy(const RenderContext& renderContext)
 	{
 		m_depthMapSampler.Destroy(renderContext);
+		m_variantCache.Destroy(renderContext);
 		m_renderPipeline.Destroy(renderContext);
 	}
 
 	void LightingRenderer::PrepareFrame(const RenderContext& renderContext, RenderFrameContext& renderFrameContext)
 	{
-		
+		if (!globals::EnableShaderVariants)
+		{
+			m_framePipeline = m_renderPipeline;
+			return;
+		}
+		// Shadow map indices were assigned by the shadow map renderer in this frame.
+		const EnvironmentData& envData = renderFrameContext.Scene->GetEnvironmentData();
+		const uint32_t spotLightCount = (uint32_t)envData.ActiveSpotLightsCount;
+		int32_t lastShadowMap = (int32_t)envData.DirectionalLight.ShadowMapIndex;
+		for (uint32_t i = 0; i < spotLightCount; ++i)
+			lastShadowMap = __max(lastShadowMap, (int32_t)envData.SpotLights[i].ShadowMapIndex);
+		const uint32_t shadowMapCount = __min((uint32_t)(lastShadowMap + 1), globals::MaxShadowMapAttachments);
+
+		const uint32_t key = lighting_internal::MakeVariantKey(
+			lighting_internal::GetLightCountBucket((uint32_t)envData.ActiveLightsCount),
+			lighting_internal::GetLightCountBucket(spotLightCount),
+			shadowMapCount,
+			(uint32_t)m_pcfRadius);
+		m_framePipeline = m_variantCache.Get(key, m_renderPipeline);
 	}
 
-	void LightingRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex)
+	void LightingRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job)
 	{
 		PROFILE_SCOPE(LightingRenderer_ColorPass);
 
-		// Bind pipeline
-		VkCommandBuffer cmd = renderFrameContext.GraphicsCommand;
-		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_renderPipeline.GetPipelineHandle());
+		// Secondary command buffers do not inherit state, every job binds pipeline and global sets.
+		VkCommandBuffer cmd = job.Cmd;
+		vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_framePipeline.GetPipelineHandle());
 
 		// Bind global descriptor sets
 		VkDescriptorSet sets[] = { m_frameData[renderFrameContext.FrameIndex].PerFrameSet };
 		uint32_t setCount = sizeof(sets) / sizeof(VkDescriptorSet);
-		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_renderPipeline.GetPipelineLayoutHandle(), 0, setCount, sets, 0, nullptr);
-		++GRenderStats.SetBindingCount;
+		vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_framePipeline.GetPipelineLayoutHandle(), 0, setCount, sets, 0, nullptr);
+		++job.Stats->SetBindingCount;
+		if (renderFrameContext.BindlessSet != VK_NULL_HANDLE)
+		{
+			vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_framePipeline.GetPipelineLayoutHandle(), 2, 1, &renderFrameContext.BindlessSet, 0, nullptr);
+			++job.Stats->SetBindingCount;
+		}
 
 		// DrawScene
-		renderFrameContext.Scene->Draw(cmd, m_renderPipeline.GetPipelineLayoutHandle(), 2, 1, m_frameData[renderFrameContext.FrameIndex].ModelSet);
+		uint32_t firstObject, lastObject;
+		job.GetRange(renderFrameContext.Scene->GetRenderObjectCount(), firstObject, lastObject);
+		renderFrameContext.Scene->Draw(cmd, m_framePipeline.GetPipelineLayoutHandle(), 2, 1, m_frameData[renderFrameContext.FrameIndex].ModelSet, renderFrameContext.FrameIndex, firstObject, lastObject, *job.Stats);
+	}
+
+	uint32_t LightingRenderer::GetRecordJobCount(const RenderFrameContext& renderFrameContext) const
+	{
+		return RecordJob::GetJobCount(renderFrameContext.Scene->GetRenderObjectCount());
 	}
 
 	void LightingRenderer::ImGuiDraw()
 	{
+		ImGui::Begin("Lighting");
+		ImGui::SliderInt("PCF radius", &m_pcfRadius, 0, 3);
+		ImGui::End();
 	}
 
 }
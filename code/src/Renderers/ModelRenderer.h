@@ -17,7 +17,6 @@ namespace vkmmc
 		struct FrameData
 		{
 			VkDescriptorSet ModelSet;
-			VkDescriptorSet DepthMVPSet;
 		};
 	public:
 		enum EShadowMapProjectionType
@@ -29,7 +28,7 @@ namespace vkmmc
 		ShadowMapPipeline();
 		~ShadowMapPipeline();
 
-		void Init(const RenderContext& renderContext, VkRenderPass renderPass, DescriptorAllocator* descriptorAllocator, DescriptorLayoutCache* layoutCache);
+		void Init(const RenderContext& renderContext, VkRenderPass renderPass, DescriptorLayoutCache* layoutCache, PipelineBuildQueue* pipelineQueue);
 		void Destroy(const RenderContext& renderContext);
 
 		void AddFrameData(const RenderContext& renderContext, UniformBuffer* buffer, DescriptorAllocator* descAllocator, DescriptorLayoutCache* layoutCache);
@@ -39,8 +38,12 @@ namespace vkmmc
 		void SetProjection(float fov, float aspectRatio);
 		void SetProjection(float minX, float maxX, float minY, float maxY);
 		void SetupLight(uint32_t lightIndex, const glm::vec3& lightPos, const glm::vec3& lightRot, EShadowMapProjectionType projType);
-		void FlushToUniformBuffer(const RenderContext& renderContext, UniformBuffer* buffer);
-		void RenderShadowMap(VkCommandBuffer cmd, const Scene* scene, uint32_t frameIndex, uint32_t lightIndex);
+		// Depth view projections of this frame to the transient buffer.
+		void PushDepthVP(TransientBuffer& buffer);
+		// Set of the pushed depth view projections, from the frame allocator of the recording thread.
+		// Null if the transient buffer was full.
+		VkDescriptorSet BuildDepthVPSet(const RenderContext& renderContext, DescriptorAllocator& frameAllocator) const;
+		void RenderShadowMap(VkCommandBuffer cmd, const Scene* scene, uint32_t frameIndex, VkDescriptorSet depthVPSet, uint32_t lightIndex, uint32_t firstObject, uint32_t lastObject, DrawStats& stats);
 		const glm::mat4& GetDepthVP(uint32_t index) const;
 		void SetDepthVP(uint32_t index, const glm::mat4& mat);
 		uint32_t GetBufferSize() const;
@@ -57,6 +60,8 @@ namespace vkmmc
 		float m_clip[2];
 		// Per frame info
 		std::vector<FrameData> m_frameData;
+		TransientBuffer::Allocation m_depthVPData;
+		DescriptorLayoutCache* m_layoutCache{ nullptr };
 	};
 
 	class ShadowMapRenderer : public IRendererBase
@@ -70,7 +75,9 @@ namespace vkmmc
 		virtual void Init(const RendererCreateInfo& info) override;
 		virtual void Destroy(const RenderContext& renderContext) override;
 		virtual void PrepareFrame(const RenderContext& renderContext, RenderFrameContext& renderFrameContext) override;
-		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex) override;
+		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job) override;
+		virtual uint32_t GetRecordJobCount(const RenderFrameContext& renderFrameContext) const override;
+		virtual const char* GetName() const override { return "ShadowMapRenderer"; }
 		virtual void ImGuiDraw() override;
 	private:
 		ShadowMapPipeline m_shadowMapPipeline;
@@ -91,14 +98,23 @@ namespace vkmmc
 		virtual void Init(const RendererCreateInfo& info) override;
 		virtual void Destroy(const RenderContext& renderContext) override;
 		virtual void PrepareFrame(const RenderContext& renderContext, RenderFrameContext& renderFrameContext) override;
-		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex) override;
+		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job) override;
+		virtual uint32_t GetRecordJobCount(const RenderFrameContext& renderFrameContext) const override;
+		virtual const char* GetName() const override { return "LightingRenderer"; }
 		virtual void ImGuiDraw() override;
 
 	protected:
 
 	protected:
 		// Render State
+		// Base pipeline, handles every light and shadow map count.
 		RenderPipeline m_renderPipeline;
+		// Pipelines specialized for the light and shadow map counts in use.
+		PipelineVariantCache m_variantCache;
+		// Selected in PrepareFrame, used by every record job of the frame.
+		RenderPipeline m_framePipeline;
+		// Shadow map PCF kernel radius, 1 for 3x3 taps.
+		int32_t m_pcfRadius;
 
 		std::vector<RendererFrameData> m_frameData;
 		
@@ -47,6 +47,7 @@ namespace vkmmc
 			.PhysicalDevice = info.RContext.GPUDevice,
 			.Device = info.RContext.Device,
 			.Queue = info.RContext.GraphicsQueue,
+			.PipelineCache = info.RContext.PipelineCache,
 			.DescriptorPool = m_uiPool,
 			.Subpass = 0,
 			.MinImageCount = 3,
@@ -77,11 +78,11 @@ namespace vkmmc
 		ImGui::NewFrame();
 	}
 
-    void UIRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex)
+    void UIRenderer::RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job)
     {
 		PROFILE_SCOPE(ImGuiPass);
 		ImGui::Render();
-		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), renderFrameContext.GraphicsCommand);
+		ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), job.Cmd);
     }
 
 }
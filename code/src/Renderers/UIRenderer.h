@@ -12,7 +12,9 @@ namespace vkmmc
 		virtual void Init(const RendererCreateInfo& info) override;
 		virtual void Destroy(const RenderContext& renderContext) override;
 		virtual void PrepareFrame(const RenderContext& renderContext, RenderFrameContext& renderFrameContext) override;
-		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, uint32_t attachmentIndex) override;
+		virtual void RecordCmd(const RenderContext& renderContext, const RenderFrameContext& renderFrameContext, const RecordJob& job) override;
+		virtual bool IsParallelRecordingSupported() const override { return false; }
+		virtual const char* GetName() const override { return "UIRenderer"; }
 		virtual void ImGuiDraw() override {}
 	private:
 		VkDescriptorPool m_uiPool;
@@ -0,0 +1,100 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "SamplerCache.h"
+#include "RenderContext.h"
+#include "Debug.h"
+#include <functional>
+
+namespace vkmmc
+{
+	SamplerCache::Key::Key(const VkSamplerCreateInfo& info)
+		: MagFilter(info.magFilter),
+		MinFilter(info.minFilter),
+		MipmapMode(info.mipmapMode),
+		AddressMode{ info.addressModeU, info.addressModeV, info.addressModeW },
+		LodBias(info.mipLodBias),
+		AnisotropyEnable(info.anisotropyEnable),
+		MaxAnisotropy(info.anisotropyEnable ? info.maxAnisotropy : 1.f),
+		CompareEnable(info.compareEnable),
+		CompareOp(info.compareEnable ? info.compareOp : VK_COMPARE_OP_NEVER),
+		MinLod(info.minLod),
+		MaxLod(info.maxLod),
+		BorderColor(info.borderColor),
+		UnnormalizedCoordinates(info.unnormalizedCoordinates)
+	{
+		// Extensions (ycbcr conversion, reduction mode...) are not part of the key.
+		check(info.pNext == nullptr && info.flags == 0);
+	}
+
+	size_t SamplerCache::Key::Hash() const
+	{
+		size_t res = 0;
+		auto combine = [&res](size_t h) { res ^= h + 0x9e3779b9 + (res << 6) + (res >> 2); };
+		combine((size_t)MagFilter | (size_t)MinFilter << 8 | (size_t)MipmapMode << 16);
+		combine((size_t)AddressMode[0] | (size_t)AddressMode[1] << 8 | (size_t)AddressMode[2] << 16);
+		combine(std::hash<float>()(LodBias));
+		combine((size_t)AnisotropyEnable | (size_t)CompareEnable << 1 | (size_t)UnnormalizedCoordinates << 2);
+		combine(std::hash<float>()(MaxAnisotropy));
+		combine((size_t)CompareOp | (size_t)BorderColor << 8);
+		combine(std::hash<float>()(MinLod));
+		combine(std::hash<float>()(MaxLod));
+		return res;
+	}
+
+	void SamplerCache::Destroy(const RenderContext& renderContext)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_entries.empty())
+			Logf(LogLevel::Warn, "Sampler cache destroyed with %u samplers still referenced.\n", (uint32_t)m_entries.size());
+		for (auto& it : m_entries)
+			vkDestroySampler(renderContext.Device, it.second.Sampler, nullptr);
+		m_entries.clear();
+		m_keys.clear();
+		Logf(LogLevel::Info, "Sampler cache: %u hits, %u samplers alive at most.\n", m_hits, m_maxSamplerCount);
+	}
+
+	VkSampler SamplerCache::Acquire(const RenderContext& renderContext, const VkSamplerCreateInfo& info)
+	{
+		Key key(info);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_entries.find(key);
+		if (it != m_entries.end())
+		{
+			++it->second.RefCount;
+			++m_hits;
+			return it->second.Sampler;
+		}
+
+		if (m_entries.size() >= renderContext.GPUProperties.limits.maxSamplerAllocationCount)
+			Logf(LogLevel::Error, "Sampler count exceeds device limit (%u).\n", renderContext.GPUProperties.limits.maxSamplerAllocationCount);
+		Entry entry{ .Sampler = VK_NULL_HANDLE, .RefCount = 1 };
+		vkcheck(vkCreateSampler(renderContext.Device, &info, nullptr, &entry.Sampler));
+		m_entries.emplace(key, entry);
+		m_keys.emplace(entry.Sampler, key);
+		m_maxSamplerCount = __max(m_maxSamplerCount, (uint32_t)m_entries.size());
+		return entry.Sampler;
+	}
+
+	void SamplerCache::AddRef(VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_keys.find(sampler);
+		check(it != m_keys.end());
+		++m_entries.at(it->second).RefCount;
+	}
+
+	void SamplerCache::Release(const RenderContext& renderContext, VkSampler sampler)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto keyIt = m_keys.find(sampler);
+		check(keyIt != m_keys.end());
+		auto it = m_entries.find(keyIt->second);
+		check(it != m_entries.end() && it->second.RefCount > 0);
+		if (--it->second.RefCount)
+			return;
+		vkDestroySampler(renderContext.Device, sampler, nullptr);
+		m_entries.erase(it);
+		m_keys.erase(keyIt);
+	}
+}
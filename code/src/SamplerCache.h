@@ -0,0 +1,75 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+#include <mutex>
+
+namespace vkmmc
+{
+	struct RenderContext;
+
+	/**
+	 * Samplers shared by state. Devices limit the number of live samplers (maxSamplerAllocationCount)
+	 * but renderers and materials use just a few different configurations.
+	 * Samplers are reference counted and destroyed when the last reference is released. Thread safe.
+	 */
+	class SamplerCache
+	{
+		struct Key
+		{
+			VkFilter MagFilter;
+			VkFilter MinFilter;
+			VkSamplerMipmapMode MipmapMode;
+			VkSamplerAddressMode AddressMode[3];
+			float LodBias;
+			VkBool32 AnisotropyEnable;
+			float MaxAnisotropy;
+			VkBool32 CompareEnable;
+			VkCompareOp CompareOp;
+			float MinLod;
+			float MaxLod;
+			VkBorderColor BorderColor;
+			VkBool32 UnnormalizedCoordinates;
+
+			Key(const VkSamplerCreateInfo& info);
+			bool operator==(const Key& other) const = default;
+			size_t Hash() const;
+
+			struct Hasher
+			{
+				std::size_t operator()(const Key& key) const
+				{
+					return key.Hash();
+				}
+			};
+		};
+
+		struct Entry
+		{
+			VkSampler Sampler;
+			uint32_t RefCount;
+		};
+
+	public:
+		void Destroy(const RenderContext& renderContext);
+
+		// Returns a sampler with the state of info and adds a reference.
+		VkSampler Acquire(const RenderContext& renderContext, const VkSamplerCreateInfo& info);
+		// Extra reference to a sampler already acquired (descriptor set layouts with immutable samplers).
+		void AddRef(VkSampler sampler);
+		void Release(const RenderContext& renderContext, VkSampler sampler);
+
+		uint32_t GetSamplerCount() const { return (uint32_t)m_entries.size(); }
+
+	private:
+		std::unordered_map<Key, Entry, Key::Hasher> m_entries;
+		std::unordered_map<VkSampler, Key> m_keys;
+		// Stats
+		uint32_t m_hits = 0;
+		uint32_t m_maxSamplerCount = 0;
+		std::mutex m_mutex;
+	};
+}
@@ -19,7 +19,10 @@
 #include <glm/fwd.hpp>
 #include "Mesh.h"
 #include "GenericUtils.h"
+#include "MeshoptDecoder.h"
+#include "AccessorDecoder.h"
 #include "VulkanRenderEngine.h"
+#include "TextureStreamer.h"
 #include <algorithm>
 #include <imgui.h>
 #include "Renderers/DebugRenderer.h"
@@ -106,34 +109,81 @@ namespace gltf_api
 		q = glm::quat(data[3], data[0], data[1], data[2]);
 	}
 
-	void ReadValues(std::vector<float>& values, const cgltf_accessor& accessor)
+	// Raw pointer to the first element of the accessor, or nullptr when data must go through the slow path
+	// (sparse accessors, accessors without buffer view or buffers not loaded).
+	const uint8_t* GetAccessorData(const cgltf_accessor& accessor)
 	{
-		uint32_t elementCount = GetElementCountFromType(accessor.type);
-		values.resize(accessor.count * elementCount);
-		for (uint32_t i = 0; i < accessor.count; ++i)
-			cgltf_accessor_read_float(&accessor, i, &values[i * elementCount], elementCount);
+		if (accessor.is_sparse || !accessor.buffer_view)
+			return nullptr;
+		const uint8_t* data = cgltf_buffer_view_data(accessor.buffer_view);
+		return data ? data + accessor.offset : nullptr;
 	}
 
-	void ReadAttribute(vkmmc::Vertex& vertex, const float* source, uint32_t index, cgltf_attribute_type type)
+	// Decode the first Count components of each accessor element into dst (stride in bytes).
+	template <uint32_t Count>
+	void DecodeAccessor(float* dst, size_t dstStride, const cgltf_accessor& accessor)
 	{
+		check(GetElementCountFromType(accessor.type) >= Count);
+		const uint8_t* src = GetAccessorData(accessor);
+		const size_t count = accessor.count;
+		const size_t stride = accessor.stride;
+		const bool normalized = accessor.normalized;
+		if (src)
+		{
+			switch (accessor.component_type)
+			{
+			case cgltf_component_type_r_32f: vkmmc::accessor::DecodeStrided<float, Count, false>(dst, dstStride, src, stride, count); return;
+			case cgltf_component_type_r_16u: vkmmc::accessor::DecodeStrided<uint16_t, Count>(dst, dstStride, src, stride, count, normalized); return;
+			case cgltf_component_type_r_16: vkmmc::accessor::DecodeStrided<int16_t, Count>(dst, dstStride, src, stride, count, normalized); return;
+			case cgltf_component_type_r_8u: vkmmc::accessor::DecodeStrided<uint8_t, Count>(dst, dstStride, src, stride, count, normalized); return;
+			case cgltf_component_type_r_8: vkmmc::accessor::DecodeStrided<int8_t, Count>(dst, dstStride, src, stride, count, normalized); return;
+			case cgltf_component_type_r_32u: vkmmc::accessor::DecodeStrided<uint32_t, Count, false>(dst, dstStride, src, stride, count); return;
+			default: break;
+			}
+		}
+
+		// Slow path. Sparse accessors or unexpected layouts.
+		uint8_t* dstBytes = reinterpret_cast<uint8_t*>(dst);
+		const uint32_t elementCount = GetElementCountFromType(accessor.type);
+		float values[16];
+		for (size_t i = 0; i < count; ++i)
+		{
+			cgltf_accessor_read_float(&accessor, i, values, elementCount);
+			memcpy(dstBytes + i * dstStride, values, sizeof(float) * Count);
+		}
+	}
+
+	void NormalizeNormals(vkmmc::Vertex* vertices, uint32_t vertexCount)
+	{
+		for (uint32_t i = 0; i < vertexCount; ++i)
+		{
+			glm::vec3& n = vertices[i].Normal;
+			const float l2 = Length2(n);
+			n = l2 < 1e-5f ? glm::vec3{ 0.f, 1.f, 0.f } : n * (1.f / sqrtf(l2));
+		}
+	}
+
+	// Attributes are an continuous array of positions, normals, uvs...
+	// We have to map from struct of arrays to our format, array of structs (std::vector<vkmmc::Vertex>)
+	void ReadAttributeArray(vkmmc::Vertex* vertices, const cgltf_attribute& attribute, const cgltf_node* nodes, uint32_t nodeCount)
+	{
+		const cgltf_accessor* accessor = attribute.data;
+		constexpr size_t stride = sizeof(vkmmc::Vertex);
 		const char* attributeName = nullptr;
-		switch (type)
+		switch (attribute.type)
 		{
 		case cgltf_attribute_type_position:
-			vertex.Position = glm::vec3(source[index], source[index + 1], source[index + 2]);
+			DecodeAccessor<3>(&vertices->Position[0], stride, *accessor);
 			break;
 		case cgltf_attribute_type_texcoord:
-			vertex.TexCoords = glm::vec2(source[index], source[index + 1]);
+			DecodeAccessor<2>(&vertices->TexCoords[0], stride, *accessor);
 			break;
 		case cgltf_attribute_type_normal:
-			vertex.Normal = glm::vec3(source[index], source[index + 1], source[index + 2]);
-			if (Length2(vertex.Normal) < 1e-5f)
-				vertex.Normal = glm::vec3{ 0.f, 1.f, 0.f };
-			else
-				vertex.Normal = glm::normalize(vertex.Normal);
+			DecodeAccessor<3>(&vertices->Normal[0], stride, *accessor);
+			NormalizeNormals(vertices, (uint32_t)accessor->count);
 			break;
 		case cgltf_attribute_type_color:
-			vertex.Color = glm::vec3(source[index], source[index + 1], source[index + 2]);
+			DecodeAccessor<3>(&vertices->Color[0], stride, *accessor);
 			break;
 		case cgltf_attribute_type_tangent: attributeName = "tangent"; break;
 		case cgltf_attribute_type_joints: attributeName = "joints"; break;
@@ -149,29 +199,81 @@ namespace gltf_api
 		//	vkmmc::Logf(vkmmc::LogLevel::Error, "gltf loader: Attribute type not suported yet [%s].\n", attributeName);
 	}
 
-	// Attributes are an continuous array of positions, normals, uvs...
-	// We have to map from struct of arrays to our format, array of structs (std::vector<vkmmc::Vertex>)
-	void ReadAttributeArray(vkmmc::Vertex* vertices, const cgltf_attribute& attribute, const cgltf_node* nodes, uint32_t nodeCount)
+	void FreeData(cgltf_data* data)
 	{
-		const cgltf_accessor* accessor = attribute.data;
-		uint32_t accessorCount = (uint32_t)accessor->count;
-		// Get how many values has current attribute
-		uint32_t elementCount = GetElementCountFromType(accessor->type);
-		// Read data from accessor
-		std::vector<float> values;
-		ReadValues(values, *accessor);
-		// Map to internal format
-		for (uint32_t i = 0; i < accessorCount; ++i)
+		cgltf_free(data);
+	}
+
+	// Decompress EXT_meshopt_compression buffer views. Decoded data is stored in buffer_view->data,
+	// which cgltf uses over the fallback buffer and releases in cgltf_free.
+	bool DecodeMeshoptCompression(cgltf_data* data)
+	{
+		for (size_t i = 0; i < data->buffer_views_count; ++i)
 		{
-			vkmmc::Vertex& vertex = vertices[i];
-			uint32_t indexValue = i * elementCount;
-			ReadAttribute(vertex, values.data(), indexValue, attribute.type);
+			cgltf_buffer_view& view = data->buffer_views[i];
+			if (!view.has_meshopt_compression)
+				continue;
+			const cgltf_meshopt_compression& mc = view.meshopt_compression;
+			// cgltf_validate checked the layout already, the decoders trust these ranges so check them again here.
+			if (!mc.buffer || !mc.buffer->data
+				|| mc.offset > mc.buffer->size || mc.size > mc.buffer->size - mc.offset
+				|| !mc.stride || mc.count > SIZE_MAX / mc.stride || mc.count * mc.stride != view.size)
+			{
+				vkmmc::Logf(vkmmc::LogLevel::Error, "gltf loader: Invalid meshopt compressed buffer view [%zd].\n", i);
+				return false;
+			}
+			const uint8_t* source = static_cast<const uint8_t*>(mc.buffer->data) + mc.offset;
+			void* result = malloc(view.size);
+			if (!result)
+				return false;
+			view.data = result;
+
+			bool success = false;
+			switch (mc.mode)
+			{
+			case cgltf_meshopt_compression_mode_attributes:
+				success = vkmmc::meshopt::DecodeVertexBuffer(result, mc.count, mc.stride, source, mc.size);
+				break;
+			case cgltf_meshopt_compression_mode_triangles:
+				success = vkmmc::meshopt::DecodeIndexBuffer(result, mc.count, mc.stride, source, mc.size);
+				break;
+			case cgltf_meshopt_compression_mode_indices:
+				success = vkmmc::meshopt::DecodeIndexSequence(result, mc.count, mc.stride, source, mc.size);
+				break;
+			default:
+				break;
+			}
+			if (!success)
+			{
+				vkmmc::Logf(vkmmc::LogLevel::Error, "gltf loader: Failed to decode meshopt compressed buffer view [%zd].\n", i);
+				return false;
+			}
+
+			switch (mc.filter)
+			{
+			case cgltf_meshopt_compression_filter_octahedral: vkmmc::meshopt::DecodeFilterOct(result, mc.count, mc.stride); break;
+			case cgltf_meshopt_compression_filter_quaternion: vkmmc::meshopt::DecodeFilterQuat(result, mc.count, mc.stride); break;
+			case cgltf_meshopt_compression_filter_exponential: vkmmc::meshopt::DecodeFilterExp(result, mc.count, mc.stride); break;
+			default: break;
+			}
 		}
+		return true;
 	}
 
-	void FreeData(cgltf_data* data)
+	bool IsExtensionSupported(const char* extension)
 	{
-		cgltf_free(data);
+		// Quantized attributes are expanded to float by the accessor decoders.
+		static const char* supportedExtensions[] =
+		{
+			"KHR_mesh_quantization",
+			"EXT_meshopt_compression",
+		};
+		for (const char* ext : supportedExtensions)
+		{
+			if (!strcmp(ext, extension))
+				return true;
+		}
+		return false;
 	}
 
 	cgltf_data* ParseFile(const char* filepath)
@@ -185,12 +287,19 @@ namespace gltf_api
 			HandleError(result, filepath);
 			return nullptr;
 		}
+		for (size_t i = 0; i < data->extensions_required_count; ++i)
+		{
+			if (!IsExtensionSupported(data->extensions_required[i]))
+				vkmmc::Logf(vkmmc::LogLevel::Warn, "gltf loader: Required extension not supported [%s].\n", data->extensions_required[i]);
+		}
 		result = cgltf_load_buffers(&options, data, filepath);
 		if (result != cgltf_result_success)
 		{
 			HandleError(result, filepath);
+			FreeData(data);
 			return nullptr;
 		}
+		// Validate before decoding, meshopt ranges come from the file.
 		result = cgltf_validate(data);
 		if (result != cgltf_result_success)
 		{
@@ -198,6 +307,11 @@ namespace gltf_api
 			FreeData(data);
 			return nullptr;
 		}
+		if (!DecodeMeshoptCompression(data))
+		{
+			FreeData(data);
+			return nullptr;
+		}
 		return data;
 	}
 
@@ -221,15 +335,29 @@ namespace gltf_api
 		uint32_t indexCount = (uint32_t)primitive->indices->count;
 		uint32_t indexOffset = (uint32_t)indices.size();
 		indices.resize(indexCount + indexOffset);
-		for (uint32_t i = 0; i < indexCount; ++i)
-			indices[i + indexOffset] = (uint32_t)cgltf_accessor_read_index(primitive->indices, i) + offset;
+		uint32_t* dst = indices.data() + indexOffset;
+		const cgltf_accessor& accessor = *primitive->indices;
+		const uint8_t* src = GetAccessorData(accessor);
+		if (!src)
+		{
+			for (uint32_t i = 0; i < indexCount; ++i)
+				dst[i] = (uint32_t)cgltf_accessor_read_index(&accessor, i) + offset;
+			return;
+		}
+		switch (accessor.component_type)
+		{
+		case cgltf_component_type_r_8u: vkmmc::accessor::DecodeIndices<uint8_t>(dst, src, accessor.stride, indexCount, offset); break;
+		case cgltf_component_type_r_16u: vkmmc::accessor::DecodeIndices<uint16_t>(dst, src, accessor.stride, indexCount, offset); break;
+		case cgltf_component_type_r_32u: vkmmc::accessor::DecodeIndices<uint32_t>(dst, src, accessor.stride, indexCount, offset); break;
+		default: check(false && "Invalid index component type."); break;
+		}
 	}
 
-	vkmmc::RenderHandle LoadTexture(vkmmc::Scene* scene, const char* rootAssetPath, const cgltf_texture_view& texView)
+	vkmmc::RenderHandle LoadTexture(vkmmc::Scene* scene, const char* rootAssetPath, const cgltf_texture_view& texView, vkmmc::ETextureUsage usage)
 	{
 		char texturePath[512];
 		sprintf_s(texturePath, "%s%s", rootAssetPath, texView.texture->image->uri);
-		vkmmc::RenderHandle handle = scene->LoadTexture(texturePath);
+		vkmmc::RenderHandle handle = scene->LoadTexture(texturePath, usage);
 		return handle;
 	}
 
@@ -239,7 +367,8 @@ namespace gltf_api
 		{
 			vkmmc::RenderHandle diffHandle = LoadTexture(scene,
 				rootAssetPath,
-				mtl.pbr_metallic_roughness.base_color_texture);
+				mtl.pbr_metallic_roughness.base_color_texture,
+				vkmmc::TEXTURE_USAGE_COLOR);
 			material.SetDiffuseTexture(diffHandle);
 		}
 #ifdef VKMMC_ENABLE_LOADER_LOG
@@ -251,7 +380,8 @@ namespace gltf_api
 		{
 			vkmmc::RenderHandle handle = LoadTexture(scene,
 				rootAssetPath,
-				mtl.pbr_specular_glossiness.diffuse_texture);
+				mtl.pbr_specular_glossiness.diffuse_texture,
+				vkmmc::TEXTURE_USAGE_COLOR);
 			material.SetSpecularTexture(handle);
 			
 			vkmmc::Log(vkmmc::LogLevel::Warn, "Specular.\n");
@@ -265,7 +395,8 @@ namespace gltf_api
 		{
 			vkmmc::RenderHandle handle = LoadTexture(scene,
 				rootAssetPath,
-				mtl.normal_texture);
+				mtl.normal_texture,
+				vkmmc::TEXTURE_USAGE_NORMAL);
 			material.SetNormalTexture(handle);
 		}
 #ifdef VKMMC_ENABLE_LOADER_LOG
@@ -283,12 +414,23 @@ namespace vkmmc
 		IndexBuffer.Bind(cmd);
 	}
 
+	SamplerBuilder MaterialRenderData::GetSamplerBuilder()
+	{
+		SamplerBuilder builder;
+		builder.MaxAnisotropy = 16.f;
+		return builder;
+	}
+
 	VkDescriptorSetLayout MaterialRenderData::GetDescriptorSetLayout(const RenderContext& renderContext, DescriptorLayoutCache& layoutCache)
 	{
+		// Layout cache keeps its own reference to the sampler.
+		vkmmc::Sampler sampler = GetSamplerBuilder().Build(renderContext);
+		VkSampler immutableSamplers[3] = { sampler.GetSampler(), sampler.GetSampler(), sampler.GetSampler() };
 		VkDescriptorSetLayout layout;
 		DescriptorSetLayoutBuilder::Create(layoutCache)
-			.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 3)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 3, immutableSamplers)
 			.Build(renderContext, &layout);
+		sampler.Destroy(renderContext);
 		return layout;
 	}
 
@@ -298,29 +440,22 @@ namespace vkmmc
 		{
 			Layout = GetDescriptorSetLayout(renderContext, layoutCache);
 		}
-		if (Set == VK_NULL_HANDLE)
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
 		{
-			descAllocator.Allocate(&Set, Layout);
+			if (Sets[i] == VK_NULL_HANDLE)
+				descAllocator.Allocate(&Sets[i], Layout);
 		}
 		if (Sampler == VK_NULL_HANDLE)
-		{
-			VkSamplerCreateInfo samplerCreateInfo
-			{
-				.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-				.pNext = nullptr,
-				.magFilter = VK_FILTER_LINEAR,
-				.minFilter = VK_FILTER_LINEAR,
-				.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-				.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-				.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT
-			};
-			vkcheck(vkCreateSampler(renderContext.Device, &samplerCreateInfo, nullptr, &Sampler));
-		}
+			Sampler = GetSamplerBuilder().Build(renderContext).GetSampler();
 	}
 
 	void MaterialRenderData::Destroy(const RenderContext& renderContext)
 	{
-		vkDestroySampler(renderContext.Device, Sampler, nullptr);
+		if (Sampler != VK_NULL_HANDLE)
+		{
+			vkmmc::Sampler(Sampler).Destroy(renderContext);
+			Sampler = VK_NULL_HANDLE;
+		}
 	}
 
 
@@ -500,12 +635,26 @@ namespace vkmmc
 		}
 		for (auto& it : m_renderData.Materials)
 		{
+			if (it.second.BindlessIndex != UINT32_MAX)
+				m_engine->GetBindlessTable().RemoveMaterial(it.second.BindlessIndex);
+			else
+				m_engine->GetTextureStreamer().RemoveBindings(it.second.Sets[0]);
 			it.second.Destroy(m_engine->GetContext());
 		}
 		for (auto& it : m_renderData.Textures)
 		{
-			it.second.Destroy(m_engine->GetContext());
+			if (m_engine->GetTextureCache().Contains(it.first))
+			{
+				if (m_engine->GetTextureCache().Release(renderContext, it.first))
+				{
+					m_engine->GetTextureStreamer().Unregister(it.first);
+					m_engine->GetBindlessTable().RemoveTexture(it.first);
+				}
+			}
+			else
+				it.second.Destroy(renderContext);
 		}
+		m_renderData.Textures.clear();
 	}
 
 	RenderObject Scene::CreateRenderObject(RenderObject parent)
@@ -672,6 +821,25 @@ namespace vkmmc
 		mrd.IndexBuffer.Init(m_engine->GetContext(), { .Size = indexBufferSize });
 		GPUBuffer::SubmitBufferToGpu(mrd.IndexBuffer, mesh.GetIndices(), indexBufferSize);
 
+		// Texture space density for streaming
+		{
+			double worldArea = 0.0;
+			double uvArea = 0.0;
+			const Vertex* vertices = mesh.GetVertices();
+			const uint32_t* indices = mesh.GetIndices();
+			for (uint32_t i = 0; i + 2 < mesh.GetIndexCount(); i += 3)
+			{
+				const Vertex& v0 = vertices[indices[i]];
+				const Vertex& v1 = vertices[indices[i + 1]];
+				const Vertex& v2 = vertices[indices[i + 2]];
+				worldArea += glm::length(glm::cross(v1.Position - v0.Position, v2.Position - v0.Position));
+				glm::vec2 uv1 = v1.TexCoords - v0.TexCoords;
+				glm::vec2 uv2 = v2.TexCoords - v0.TexCoords;
+				uvArea += fabsf(uv1.x * uv2.y - uv1.y * uv2.x);
+			}
+			mrd.UVDensity = worldArea > 0.0 ? (float)sqrt(uvArea / worldArea) : 0.f;
+		}
+
 		// Register new buffer
 		RenderHandle handle = GenerateRenderHandle();
 		mesh.SetHandle(handle);
@@ -684,21 +852,39 @@ namespace vkmmc
 
 		RenderHandle h = GenerateRenderHandle();
 		MaterialRenderData mrd;
+		BindlessMaterialTable& bindlessTable = m_engine->GetBindlessTable();
+		if (bindlessTable.IsInitialized())
+		{
+			auto getTextureIndex = [this, &bindlessTable](RenderHandle texHandle)
+				{
+					uint32_t index = texHandle.IsValid() ? bindlessTable.GetTextureIndex(texHandle) : UINT32_MAX;
+					return index != UINT32_MAX ? index : bindlessTable.GetTextureIndex(m_engine->GetDefaultTexture());
+				};
+			BindlessMaterialData data;
+			data.DiffuseTexture = getTextureIndex(material.GetDiffuseTexture());
+			data.NormalTexture = getTextureIndex(material.GetNormalTexture());
+			data.SpecularTexture = getTextureIndex(material.GetSpecularTexture());
+			data.Padding = 0;
+			mrd.BindlessIndex = bindlessTable.AddMaterial(m_engine->GetContext(), data);
+
+			material.SetHandle(h);
+			m_renderData.Materials[h] = mrd;
+			m_materialArray.push_back(material);
+			return;
+		}
 		mrd.Init(m_engine->GetContext(), m_engine->GetDescriptorAllocator(), m_engine->GetDescriptorSetLayoutCache());
 
 		auto submitTexture = [this](RenderHandle texHandle, MaterialRenderData& mrd, uint32_t binding, uint32_t arrayIndex)
 			{
-				Texture texture;
-				if (texHandle.IsValid())
-				{
-					texture = m_renderData.Textures[texHandle];
-				}
-				else
-				{
-					RenderHandle defTex = m_engine->GetDefaultTexture();
-					texture = m_renderData.Textures[defTex];
-				}
-				texture.Bind(m_engine->GetContext(), mrd.Set, mrd.Sampler, binding, arrayIndex);
+				if (!texHandle.IsValid())
+					texHandle = m_engine->GetDefaultTexture();
+				// Cached textures may have been replaced by the streamer, take the current one.
+				const Texture* cached = m_engine->GetTextureCache().Get(texHandle);
+				const Texture& texture = cached ? *cached : m_renderData.Textures[texHandle];
+				for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+					texture.Bind(m_engine->GetContext(), mrd.Sets[i], mrd.Sampler, binding, arrayIndex);
+				if (m_engine->GetTextureStreamer().IsStreamed(texHandle))
+					m_engine->GetTextureStreamer().AddBinding(texHandle, mrd.Sets, mrd.Sampler, binding, arrayIndex);
 			};
 		submitTexture(material.GetDiffuseTexture(), mrd, 0, 0);
 		submitTexture(material.GetNormalTexture(), mrd, 0, 1);
@@ -711,19 +897,72 @@ namespace vkmmc
 
 	RenderHandle Scene::LoadTexture(const char* texturePath)
 	{
-		// Load texture from file
+		return LoadTexture(texturePath, TEXTURE_USAGE_COLOR);
+	}
+
+	RenderHandle Scene::LoadTexture(const char* texturePath, ETextureUsage usage)
+	{
+		// Share textures already loaded by other materials or scenes.
+		TextureCache& cache = m_engine->GetTextureCache();
+		RenderHandle cached = cache.Acquire(texturePath, usage);
+		if (cached.IsValid())
+		{
+			if (m_renderData.Textures.contains(cached))
+			{
+				// Scene already owns one reference.
+				cache.Release(m_engine->GetContext(), cached);
+			}
+			else
+			{
+				// Texture copies only share vulkan handles.
+				m_renderData.Textures[cached] = *cache.Get(cached);
+			}
+			return cached;
+		}
+
+		// Load texture from file, block compressed if the device supports it.
+		// Streamed textures only read the description here, the streamer loads the levels it keeps resident.
 		io::TextureRaw texData;
-		if (!io::LoadTexture(texturePath, texData))
+		std::string levelPath = texturePath;
+		bool loaded = false;
+		const bool compressed = globals::CompressTexturesOnImport && Texture::IsFormatSupported(m_engine->GetContext(), FORMAT_BC1_SRGB);
+		if (globals::EnableTextureStreaming)
+			loaded = (!compressed || io::GetCompressedTexturePath(texturePath, usage, levelPath, &m_engine->GetWorkerPool()))
+				&& io::LoadTextureInfo(levelPath.c_str(), texData);
+		else if (compressed)
+			loaded = io::LoadCompressedTexture(texturePath, usage, texData, &m_engine->GetWorkerPool());
+		else
+			loaded = io::LoadTexture(texturePath, texData);
+		if (!loaded)
 		{
 			Logf(LogLevel::Error, "Failed to load texture from %s.\n", texturePath);
 			return InvalidRenderHandle;
 		}
 
+		if (texData.Format != FORMAT_INVALID && !Texture::IsFormatSupported(m_engine->GetContext(), texData.Format))
+		{
+			Logf(LogLevel::Error, "Texture format not supported by device (%s).\n", texturePath);
+			io::FreeTexture(texData.Pixels);
+			return InvalidRenderHandle;
+		}
+
 		// Create gpu buffer with texture specifications
 		Texture texture;
-		texture.Init(m_engine->GetContext(), texData);
 		RenderHandle h = GenerateRenderHandle();
+		if (globals::EnableTextureStreaming)
+		{
+			if (!m_engine->GetTextureStreamer().Register(m_engine->GetContext(), h, levelPath.c_str(), texData, texture))
+			{
+				Logf(LogLevel::Error, "Failed to load texture from %s.\n", levelPath.c_str());
+				return InvalidRenderHandle;
+			}
+		}
+		else
+			texture.Init(m_engine->GetContext(), texData);
 		m_renderData.Textures[h] = texture;
+		cache.Add(texturePath, usage, h, texture, texData);
+		if (m_engine->GetBindlessTable().IsInitialized())
+			m_engine->GetBindlessTable().AddTexture(h);
 
 		// Free raw texture data
 		io::FreeTexture(texData.Pixels);
@@ -814,13 +1053,13 @@ namespace vkmmc
 		return m_renderData.Materials.at(handle);
 	}
 
-	void Scene::Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t materialSetIndex, uint32_t modelSetIndex, VkDescriptorSet modelSet) const
+	void Scene::Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t materialSetIndex, uint32_t modelSetIndex, VkDescriptorSet modelSet, uint32_t frameIndex, uint32_t firstObject, uint32_t lastObject, DrawStats& stats) const
 	{
 		// Iterate scene graph to render models.
 		uint32_t lastMaterialIndex = UINT32_MAX;
 		const Mesh* lastMesh = nullptr;
-		uint32_t nodeCount = GetRenderObjectCount();
-		for (uint32_t i = 0; i < nodeCount; ++i)
+		check(firstObject <= lastObject && lastObject <= GetRenderObjectCount());
+		for (uint32_t i = firstObject; i < lastObject; ++i)
 		{
 			RenderObject renderObject = i;
 			const Mesh* mesh = GetMesh(renderObject);
@@ -832,7 +1071,7 @@ namespace vkmmc
 				uint32_t modelDynamicOffset = i * sizeof(glm::mat4);
 				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
 					pipelineLayout, modelSetIndex, 1, &modelSet, 1, &modelDynamicOffset);
-				++GRenderStats.SetBindingCount;
+				++stats.SetBindingCount;
 
 				// Bind vertex/index buffers just if needed
 				if (lastMesh != mesh)
@@ -840,6 +1079,7 @@ namespace vkmmc
 					check(mesh->GetHandle().IsValid());
 					lastMesh = mesh;
 					mrd.BindBuffers(cmd);
+					stats.BufferBindCount += 2;
 				}
 				// Iterate primitives of current mesh
 				for (uint32_t j = 0; j < (uint32_t)mrd.PrimitiveArray.size(); ++j)
@@ -852,25 +1092,33 @@ namespace vkmmc
 						const Material* material = &GetMaterialArray()[drawData.MaterialIndex];
 						check(material && material->GetHandle().IsValid());
 						const MaterialRenderData& mtl = GetMaterialRenderData(material->GetHandle());
-						vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-							pipelineLayout, materialSetIndex, 1, &mtl.Set, 0, nullptr);
-						++GRenderStats.SetBindingCount;
+						if (mtl.BindlessIndex != UINT32_MAX)
+						{
+							// Textures are already bound, just tell the shader which material to use.
+							vkCmdPushConstants(cmd, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &mtl.BindlessIndex);
+						}
+						else
+						{
+							vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+								pipelineLayout, materialSetIndex, 1, &mtl.Sets[frameIndex], 0, nullptr);
+							++stats.SetBindingCount;
+						}
 					}
 					vkCmdDrawIndexed(cmd, drawData.Count, 1, drawData.FirstIndex, 0, 0);
-					++GRenderStats.DrawCalls;
-					GRenderStats.TrianglesCount += drawData.Count / 3;
+					++stats.DrawCalls;
+					stats.TrianglesCount += drawData.Count / 3;
 				}
 			}
 		}
 	}
 
-	void Scene::Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t modelSetIndex, VkDescriptorSet modelSet) const
+	void Scene::Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t modelSetIndex, VkDescriptorSet modelSet, uint32_t firstObject, uint32_t lastObject, DrawStats& stats) const
 	{
 		// Iterate scene graph to render models.
 		uint32_t lastMaterialIndex = UINT32_MAX;
 		const Mesh* lastMesh = nullptr;
-		uint32_t nodeCount = GetRenderObjectCount();
-		for (uint32_t i = 0; i < nodeCount; ++i)
+		check(firstObject <= lastObject && lastObject <= GetRenderObjectCount());
+		for (uint32_t i = firstObject; i < lastObject; ++i)
 		{
 			RenderObject renderObject = i;
 			const Mesh* mesh = GetMesh(renderObject);
@@ -882,7 +1130,7 @@ namespace vkmmc
 				uint32_t modelDynamicOffset = i * sizeof(glm::mat4);
 				vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
 					pipelineLayout, modelSetIndex, 1, &modelSet, 1, &modelDynamicOffset);
-				++GRenderStats.SetBindingCount;
+				++stats.SetBindingCount;
 
 				// Bind vertex/index buffers just if needed
 				if (lastMesh != mesh)
@@ -890,6 +1138,7 @@ namespace vkmmc
 					check(mesh->GetHandle().IsValid());
 					lastMesh = mesh;
 					mrd.BindBuffers(cmd);
+					stats.BufferBindCount += 2;
 				}
 				// TODO: index buffer is ordered the whole buffer or just by primitive?
 				vkCmdDrawIndexed(cmd, mesh->GetIndexCount(), 1, 0, 0, 0);
@@ -898,8 +1147,8 @@ namespace vkmmc
 				{
 					const PrimitiveMeshData& drawData = mrd.PrimitiveArray[j];
 					vkCmdDrawIndexed(cmd, drawData.Count, 1, drawData.FirstIndex, 0, 0);
-					++GRenderStats.DrawCalls;
-					GRenderStats.TrianglesCount += drawData.Count / 3;
+					++stats.DrawCalls;
+					stats.TrianglesCount += drawData.Count / 3;
 				}
 #endif // 0
 
@@ -1021,6 +1270,33 @@ namespace vkmmc
 		check(buffer->SetUniform(renderContext, UNIFORM_ID_SCENE_MODEL_TRANSFORM_ARRAY, GetRawGlobalTransforms(), GetRenderObjectCount() * sizeof(glm::mat4)));
 	}
 
+	void Scene::RequestTextureMips(TextureStreamer& streamer, const glm::vec3& viewPosition, float projectionScale) const
+	{
+		// Distance is taken from the object origin (no bounds yet).
+		const uint32_t nodeCount = GetRenderObjectCount();
+		for (uint32_t i = 0; i < nodeCount; ++i)
+		{
+			const Mesh* mesh = GetMesh(i);
+			if (!mesh)
+				continue;
+			const MeshRenderData& mrd = GetMeshRenderData(mesh->GetHandle());
+			const glm::mat4& transform = m_globalTransforms[i];
+			const float scale = __max(glm::length(glm::vec3(transform[0])), __max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+			const float distance = __max(glm::length(glm::vec3(transform[3]) - viewPosition), 1e-3f);
+			// Texels per pixel of a texture of size 1: uv per world unit / pixels per world unit.
+			const float texelRatio = scale > 0.f ? mrd.UVDensity * distance / (scale * projectionScale) : 0.f;
+			for (const PrimitiveMeshData& primitive : mrd.PrimitiveArray)
+			{
+				if (primitive.MaterialIndex >= GetMaterialCount())
+					continue;
+				const Material& material = GetMaterialArray()[primitive.MaterialIndex];
+				streamer.Request(material.GetDiffuseTexture(), texelRatio);
+				streamer.Request(material.GetNormalTexture(), texelRatio);
+				streamer.Request(material.GetSpecularTexture(), texelRatio);
+			}
+		}
+	}
+
 	const glm::mat4* Scene::GetRawGlobalTransforms() const
 	{
 		// Dirty check, must be clean
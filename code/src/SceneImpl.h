@@ -6,11 +6,14 @@
 //#include "VulkanRenderEngine.h"
 #include "VulkanBuffer.h"
 #include "Texture.h"
+#include "TextureCompressor.h"
+#include "Globals.h"
 
 
 namespace vkmmc
 {
 	struct RenderContext;
+	struct DrawStats;
 	class IRenderEngine;
 	class DescriptorLayoutCache;
 	class DescriptorAllocator;
@@ -18,9 +21,14 @@ namespace vkmmc
 	struct MaterialRenderData
 	{
 		VkDescriptorSetLayout Layout{ VK_NULL_HANDLE };
-		VkDescriptorSet Set{ VK_NULL_HANDLE };
+		// One set per frame slot so streamed textures can be swapped while other frames are in flight.
+		VkDescriptorSet Sets[globals::MaxOverlappedFrames]{ VK_NULL_HANDLE };
 		VkSampler Sampler{ VK_NULL_HANDLE };
+		// Index in the bindless material table. Sets are not used when valid.
+		uint32_t BindlessIndex{ UINT32_MAX };
 
+		// Same sampler for every material, immutable in the descriptor set layout.
+		static SamplerBuilder GetSamplerBuilder();
 		static VkDescriptorSetLayout GetDescriptorSetLayout(const RenderContext& renderContext, DescriptorLayoutCache& layoutCache);
 		void Init(const RenderContext& renderContext, DescriptorAllocator& descAllocator, DescriptorLayoutCache& layoutCache);
 		void Destroy(const RenderContext& renderContext);
@@ -36,10 +44,12 @@ namespace vkmmc
 
 	struct MeshRenderData
 	{
-		VertexBuffer VertexBuffer;
-		IndexBuffer IndexBuffer;
+		vkmmc::VertexBuffer VertexBuffer;
+		vkmmc::IndexBuffer IndexBuffer;
 		uint32_t IndexCount;
 		std::vector<PrimitiveMeshData> PrimitiveArray;
+		// Square root of uv area per unit of object space area. Used to estimate required texture mips.
+		float UVDensity = 0.f;
 
 		void BindBuffers(VkCommandBuffer cmd) const;
 	};
@@ -92,6 +102,14 @@ namespace vkmmc
 
 		EnvironmentData();
 	};
+	// Environment uniform block in basic.frag
+	STD140_CHECK_SIZE(LightData, 32);
+	STD140_CHECK_SIZE(SpotLightData, 48);
+	STD140_CHECK_OFFSET(EnvironmentData, ViewPosition, 16);
+	STD140_CHECK_OFFSET(EnvironmentData, Lights, 32);
+	STD140_CHECK_OFFSET(EnvironmentData, DirectionalLight, 32 + 32 * EnvironmentData::MaxLights);
+	STD140_CHECK_OFFSET(EnvironmentData, SpotLights, 64 + 32 * EnvironmentData::MaxLights);
+	STD140_CHECK_SIZE(EnvironmentData, 64 + 80 * EnvironmentData::MaxLights);
 
 	class Scene : public IScene
 	{
@@ -129,6 +147,7 @@ namespace vkmmc
 		virtual void SubmitMesh(Mesh& mesh) override;
 		virtual void SubmitMaterial(Material& material) override;
 		virtual RenderHandle LoadTexture(const char* texturePath) override;
+		RenderHandle LoadTexture(const char* texturePath, ETextureUsage usage);
 
 		void MarkAsDirty(RenderObject renderObject);
 
@@ -149,13 +168,16 @@ namespace vkmmc
 		MaterialRenderData& GetMaterialRenderData(RenderHandle handle);
 
 		void UpdateRenderData(const RenderContext& renderContext, UniformBuffer* buffer, const glm::vec3& viewPosition);
+		// Request texture mips to the streamer based on distance to view and uv density of the meshes.
+		// projectionScale: screen pixels per world unit at distance 1.
+		void RequestTextureMips(class TextureStreamer& streamer, const glm::vec3& viewPosition, float projectionScale) const;
 		inline const EnvironmentData& GetEnvironmentData() const { return m_environmentData; }
 		inline EnvironmentData& GetEnvironmentData() { return m_environmentData; }
 
-		// Draw with materials
-		void Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t materialSetIndex, uint32_t modelSetIndex, VkDescriptorSet modelSet) const;
-		// Draw without materials
-		void Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t modelSetIndex, VkDescriptorSet modelSet) const;
+		// Draw render objects in [firstObject, lastObject) with materials. Counters are added to stats.
+		void Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t materialSetIndex, uint32_t modelSetIndex, VkDescriptorSet modelSet, uint32_t frameIndex, uint32_t firstObject, uint32_t lastObject, DrawStats& stats) const;
+		// Draw render objects in [firstObject, lastObject) without materials. Counters are added to stats.
+		void Draw(VkCommandBuffer cmd, VkPipelineLayout pipelineLayout, uint32_t modelSetIndex, VkDescriptorSet modelSet, uint32_t firstObject, uint32_t lastObject, DrawStats& stats) const;
 
 		void ImGuiDraw(bool createWindow = false);
 
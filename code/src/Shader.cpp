@@ -2,7 +2,7 @@
 
 #include "Shader.h"
 
-#include <spirv-cross-main/spirv_glsl.hpp>
+#include <SPIRV-Cross-main/spirv_glsl.hpp>
 
 #include "RenderTypes.h"
 #include "GenericUtils.h"
@@ -10,6 +10,9 @@
 #include "InitVulkanTypes.h"
 #include "RenderDescriptor.h"
 #include "RenderContext.h"
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
 
 namespace vkutils
 {
@@ -63,8 +66,285 @@ namespace vkutils
 	}
 }
 
+namespace shader_internal
+{
+	// Bump when the reflection cache format or the reflected data change.
+	constexpr uint32_t ReflectionCacheVersion = 1;
+	constexpr uint32_t ReflectionCacheMagic = 'V' | 'K' << 8 | 'S' << 16 | 'R' << 24;
+	constexpr uint32_t SpirvMagic = 0x07230203;
+
+	template <typename T>
+	void Write(std::ofstream& file, const T& value)
+	{
+		file.write((const char*)&value, sizeof(T));
+	}
+
+	void WriteString(std::ofstream& file, const std::string& str)
+	{
+		Write(file, (uint32_t)str.size());
+		file.write(str.data(), str.size());
+	}
+
+	template <typename T>
+	bool Read(std::ifstream& file, T& value)
+	{
+		file.read((char*)&value, sizeof(T));
+		return file.good();
+	}
+
+	bool ReadString(std::ifstream& file, std::string& str)
+	{
+		uint32_t size;
+		if (!Read(file, size) || size > 1024)
+			return false;
+		str.resize(size);
+		file.read(str.data(), size);
+		return file.good();
+	}
+}
+
 namespace vkmmc
 {
+	void ShaderLibrary::Init(const char* cacheDirectory)
+	{
+		m_cacheDirectory = cacheDirectory ? cacheDirectory : "";
+		if (!m_cacheDirectory.empty())
+		{
+			std::error_code error;
+			std::filesystem::create_directories(m_cacheDirectory, error);
+		}
+	}
+
+	void ShaderLibrary::Destroy(const RenderContext& renderContext)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto& it : m_shaders)
+			DestroyShader(renderContext, it.second);
+		for (LibraryShader* shader : m_retired)
+			DestroyShader(renderContext, shader);
+		m_retired.clear();
+		Logf(LogLevel::Info, "Shader library: %u shaders, %u hits, %u reflections from cache.\n",
+			(uint32_t)m_shaders.size(), m_hits, m_reflectionCacheHits);
+		m_shaders.clear();
+	}
+
+	const LibraryShader* ShaderLibrary::Get(const RenderContext& renderContext, const char* filepath, VkShaderStageFlagBits stage)
+	{
+		check(filepath && *filepath);
+		const std::string key = std::string(filepath) + '#' + std::to_string((uint32_t)stage);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_shaders.find(key);
+			if (it != m_shaders.end())
+			{
+				++m_hits;
+				++it->second->Users;
+				return it->second;
+			}
+		}
+
+		// Load outside the lock, pipelines may be created from several threads.
+		bool reflectionCached = false;
+		LibraryShader* shader = Load(renderContext, filepath, stage, reflectionCached);
+		if (!shader)
+			return nullptr;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_shaders.find(key);
+		if (it != m_shaders.end())
+		{
+			// Loaded by another thread meanwhile.
+			DestroyShader(renderContext, shader);
+			++m_hits;
+			++it->second->Users;
+			return it->second;
+		}
+		shader->Users = 1;
+		m_shaders[key] = shader;
+		if (reflectionCached)
+			++m_reflectionCacheHits;
+		Logf(LogLevel::Ok, "Shader loaded: [%s: %s]%s\n", vkutils::GetVulkanShaderStageName(stage), filepath,
+			reflectionCached ? " (cached reflection)" : "");
+		return shader;
+	}
+
+	void ShaderLibrary::Release(const RenderContext& renderContext, const LibraryShader* shader)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		LibraryShader* released = const_cast<LibraryShader*>(shader);
+		check(released->Users > 0);
+		if (--released->Users || !released->Retired)
+			return;
+		// Pipelines created with a module do not need it anymore.
+		m_retired.erase(std::find(m_retired.begin(), m_retired.end(), released));
+		DestroyShader(renderContext, released);
+	}
+
+	bool ShaderLibrary::Reload(const RenderContext& renderContext, const char* filepath)
+	{
+		std::vector<std::pair<std::string, VkShaderStageFlagBits>> keys;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (const auto& it : m_shaders)
+			{
+				if (it.second->Filepath == filepath)
+					keys.push_back({ it.first, it.second->Stage });
+			}
+		}
+
+		bool changed = false;
+		for (const auto& key : keys)
+		{
+			bool reflectionCached = false;
+			LibraryShader* shader = Load(renderContext, filepath, key.second, reflectionCached);
+			if (!shader)
+				continue;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			LibraryShader*& current = m_shaders.at(key.first);
+			if (current->Hash == shader->Hash)
+			{
+				DestroyShader(renderContext, shader);
+				continue;
+			}
+			// Pipelines being created with the previous version release it when they finish.
+			if (current->Users)
+			{
+				current->Retired = true;
+				m_retired.push_back(current);
+			}
+			else
+				DestroyShader(renderContext, current);
+			current = shader;
+			changed = true;
+			Logf(LogLevel::Ok, "Shader reloaded: [%s: %s]\n", vkutils::GetVulkanShaderStageName(key.second), filepath);
+		}
+		return changed;
+	}
+
+	void ShaderLibrary::DestroyShader(const RenderContext& renderContext, LibraryShader* shader)
+	{
+		vkDestroyShaderModule(renderContext.Device, shader->Module, nullptr);
+		delete shader;
+	}
+
+	LibraryShader* ShaderLibrary::Load(const RenderContext& renderContext, const char* filepath, VkShaderStageFlagBits stage, bool& reflectionCached) const
+	{
+		check(ShaderCompiler::CheckShaderFileExtension(filepath, stage));
+		LibraryShader* shader = new LibraryShader{ .Filepath = filepath, .Stage = stage, .Hash = 0, .Module = VK_NULL_HANDLE, .Users = 0, .Retired = false };
+		// Files being written by the shader compiler may be incomplete, check at least the SPIR-V magic number.
+		if (!ShaderCompiler::CacheSourceFromFile(filepath, shader->BinarySource) || shader->BinarySource.size() < 5
+			|| shader->BinarySource[0] != shader_internal::SpirvMagic)
+		{
+			Logf(LogLevel::Error, "Failed to read shader file %s.\n", filepath);
+			delete shader;
+			return nullptr;
+		}
+		shader->Hash = hash::Fnv1a(shader->BinarySource.data(), shader->BinarySource.size() * sizeof(uint32_t));
+		shader->Hash = hash::Fnv1a(&stage, sizeof(stage), shader->Hash);
+
+		reflectionCached = false;
+		char cachePath[512];
+		if (!m_cacheDirectory.empty())
+		{
+			GetReflectionCachePath(shader->Hash, cachePath, sizeof(cachePath));
+			reflectionCached = LoadReflection(cachePath, shader->Hash, shader->Reflection);
+		}
+		if (!reflectionCached)
+		{
+			ShaderCompiler::ReflectSource(shader->BinarySource, stage, shader->Reflection);
+			if (!m_cacheDirectory.empty() && !SaveReflection(cachePath, shader->Hash, shader->Reflection))
+				Logf(LogLevel::Warn, "Failed to save shader reflection in cache (%s).\n", cachePath);
+		}
+
+		VkShaderModuleCreateInfo info{ .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO, .pNext = nullptr };
+		info.codeSize = shader->BinarySource.size() * sizeof(uint32_t);
+		info.pCode = shader->BinarySource.data();
+		vkcheck(vkCreateShaderModule(renderContext.Device, &info, nullptr, &shader->Module));
+		return shader;
+	}
+
+	void ShaderLibrary::GetReflectionCachePath(uint64_t hash, char* path, size_t size) const
+	{
+		sprintf_s(path, size, "%s%016llx.refl", m_cacheDirectory.c_str(), (unsigned long long)hash);
+	}
+
+	bool ShaderLibrary::LoadReflection(const char* path, uint64_t hash, ShaderReflectionProperties& properties) const
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return false;
+		uint32_t magic, version, setCount, pushConstantCount;
+		uint64_t fileHash;
+		if (!shader_internal::Read(file, magic) || !shader_internal::Read(file, version) || !shader_internal::Read(file, fileHash)
+			|| magic != shader_internal::ReflectionCacheMagic || version != shader_internal::ReflectionCacheVersion || fileHash != hash)
+			return false;
+
+		ShaderReflectionProperties loaded;
+		if (!shader_internal::Read(file, setCount) || setCount > 64)
+			return false;
+		loaded.DescriptorSetInfoArray.resize(setCount);
+		for (ShaderDescriptorSetInfo& set : loaded.DescriptorSetInfoArray)
+		{
+			uint32_t bindingCount;
+			if (!shader_internal::Read(file, set.SetIndex) || !shader_internal::Read(file, bindingCount) || bindingCount > 1024)
+				return false;
+			set.BindingArray.resize(bindingCount);
+			for (ShaderBindingDescriptorInfo& binding : set.BindingArray)
+			{
+				if (!shader_internal::Read(file, binding.Type) || !shader_internal::Read(file, binding.Size)
+					|| !shader_internal::Read(file, binding.Binding) || !shader_internal::Read(file, binding.ArrayCount)
+					|| !shader_internal::Read(file, binding.Stage) || !shader_internal::ReadString(file, binding.Name))
+					return false;
+			}
+		}
+		if (!shader_internal::Read(file, pushConstantCount) || pushConstantCount > 64)
+			return false;
+		for (uint32_t i = 0; i < pushConstantCount; ++i)
+		{
+			ShaderPushConstantBufferInfo info;
+			if (!shader_internal::Read(file, info.ShaderStage) || !shader_internal::Read(file, info.Offset)
+				|| !shader_internal::Read(file, info.Size) || !shader_internal::ReadString(file, info.Name))
+				return false;
+			loaded.PushConstantMap[info.ShaderStage] = info;
+		}
+		properties = std::move(loaded);
+		return true;
+	}
+
+	bool ShaderLibrary::SaveReflection(const char* path, uint64_t hash, const ShaderReflectionProperties& properties) const
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+		shader_internal::Write(file, shader_internal::ReflectionCacheMagic);
+		shader_internal::Write(file, shader_internal::ReflectionCacheVersion);
+		shader_internal::Write(file, hash);
+		shader_internal::Write(file, (uint32_t)properties.DescriptorSetInfoArray.size());
+		for (const ShaderDescriptorSetInfo& set : properties.DescriptorSetInfoArray)
+		{
+			shader_internal::Write(file, set.SetIndex);
+			shader_internal::Write(file, (uint32_t)set.BindingArray.size());
+			for (const ShaderBindingDescriptorInfo& binding : set.BindingArray)
+			{
+				shader_internal::Write(file, binding.Type);
+				shader_internal::Write(file, binding.Size);
+				shader_internal::Write(file, binding.Binding);
+				shader_internal::Write(file, binding.ArrayCount);
+				shader_internal::Write(file, binding.Stage);
+				shader_internal::WriteString(file, binding.Name);
+			}
+		}
+		shader_internal::Write(file, (uint32_t)properties.PushConstantMap.size());
+		for (const auto& it : properties.PushConstantMap)
+		{
+			shader_internal::Write(file, it.second.ShaderStage);
+			shader_internal::Write(file, it.second.Offset);
+			shader_internal::Write(file, it.second.Size);
+			shader_internal::WriteString(file, it.second.Name);
+		}
+		return file.good();
+	}
+
 	ShaderCompiler::ShaderCompiler(const RenderContext& renderContext) : m_renderContext(renderContext)
 	{}
 
@@ -75,9 +355,12 @@ namespace vkmmc
 
 	void ShaderCompiler::ClearCachedData()
 	{
-		for (auto it : m_cachedBinarySources)
+		for (auto& it : m_cachedBinarySources)
 		{
-			vkDestroyShaderModule(m_renderContext.Device, it.second.CompiledModule, nullptr);
+			if (it.second.LibraryShader)
+				m_renderContext.ShaderLibrary->Release(m_renderContext, it.second.LibraryShader);
+			else
+				vkDestroyShaderModule(m_renderContext.Device, it.second.CompiledModule, nullptr);
 		}
 		m_cachedBinarySources.clear();
 		m_cachedLayoutArray.clear();
@@ -86,13 +369,28 @@ namespace vkmmc
 
 	bool ShaderCompiler::ProcessShaderFile(const char* filepath, VkShaderStageFlagBits shaderStage)
 	{
-		Logf(LogLevel::Ok, "Compiling shader: [%s: %s]\n", vkutils::GetVulkanShaderStageName(shaderStage), filepath);
 		check(!m_cachedBinarySources.contains(shaderStage));
 		CachedBinaryData data;
 		data.ShaderStage = shaderStage;
+		if (m_renderContext.ShaderLibrary)
+		{
+			// Source, reflection and module shared with other pipelines.
+			const LibraryShader* shader = m_renderContext.ShaderLibrary->Get(m_renderContext, filepath, shaderStage);
+			if (!shader)
+				return false;
+			MergeReflection(shader->Reflection);
+			data.CompiledModule = shader->Module;
+			data.LibraryShader = shader;
+			m_cachedBinarySources[shaderStage] = data;
+			return true;
+		}
+
+		Logf(LogLevel::Ok, "Compiling shader: [%s: %s]\n", vkutils::GetVulkanShaderStageName(shaderStage), filepath);
 		check(CheckShaderFileExtension(filepath, shaderStage));
 		check(CacheSourceFromFile(filepath, data.BinarySource));
-		ProcessCachedSource(data);
+		ShaderReflectionProperties properties;
+		ReflectSource(data.BinarySource, shaderStage, properties);
+		MergeReflection(properties);
 		data.CompiledModule = Compile(data.BinarySource, data.ShaderStage);
 		m_cachedBinarySources[shaderStage] = data;
 		Logf(LogLevel::Ok, "Shader compiled and cached successfully: [%s: %s]\n", vkutils::GetVulkanShaderStageName(shaderStage), filepath);
@@ -136,9 +434,9 @@ namespace vkmmc
 		return io::ReadFile(file, outCachedData);
 	}
 
-	void ShaderCompiler::ProcessCachedSource(CachedBinaryData& cachedData)
+	void ShaderCompiler::ReflectSource(const std::vector<uint32_t>& binarySource, VkShaderStageFlagBits shaderStage, ShaderReflectionProperties& properties)
 	{
-		auto processSpirvResource = [this](const spirv_cross::CompilerGLSL& compiler, const spirv_cross::Resource& resource, VkShaderStageFlagBits shaderStage, VkDescriptorType descriptorType)
+		auto processSpirvResource = [&properties](const spirv_cross::CompilerGLSL& compiler, const spirv_cross::Resource& resource, VkShaderStageFlagBits shaderStage, VkDescriptorType descriptorType)
 			{
 				ShaderBindingDescriptorInfo bufferInfo;
 				bufferInfo.Binding = compiler.get_decoration(resource.id, spv::DecorationBinding);
@@ -159,7 +457,7 @@ namespace vkmmc
 				bufferInfo.Stage = shaderStage;
 
 				uint32_t setIndex = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
-				ShaderDescriptorSetInfo& descriptorSetInfo = FindOrCreateDescriptorSet(setIndex);
+				ShaderDescriptorSetInfo& descriptorSetInfo = FindOrCreateDescriptorSet(properties, setIndex);
 				if (descriptorSetInfo.BindingArray.size() < bufferInfo.Binding + 1)
 					descriptorSetInfo.BindingArray.resize(bufferInfo.Binding + 1);
 				descriptorSetInfo.BindingArray[bufferInfo.Binding] = bufferInfo;
@@ -169,51 +467,70 @@ namespace vkmmc
 				return setIndex;
 			};
 
-		const std::vector<uint32_t>& cachedSource = cachedData.BinarySource;
-		check(!cachedSource.empty() && "Invalid cached source.");
-		spirv_cross::CompilerGLSL compiler(cachedSource);
+		check(!binarySource.empty() && "Invalid cached source.");
+		spirv_cross::CompilerGLSL compiler(binarySource);
 		spirv_cross::ShaderResources resources = compiler.get_shader_resources();
 
 		Log(LogLevel::Debug, "Processing shader reflection...\n");
 		
 		for (const spirv_cross::Resource& resource : resources.uniform_buffers)
-			processSpirvResource(compiler, resource, cachedData.ShaderStage, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+			processSpirvResource(compiler, resource, shaderStage, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
 
 		for (const spirv_cross::Resource& resource : resources.storage_buffers)
-			processSpirvResource(compiler, resource, cachedData.ShaderStage, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+			processSpirvResource(compiler, resource, shaderStage, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 
 		for (const spirv_cross::Resource& resource : resources.sampled_images)
-			processSpirvResource(compiler, resource, cachedData.ShaderStage, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+			processSpirvResource(compiler, resource, shaderStage, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
 		for (const spirv_cross::Resource& resource : resources.push_constant_buffers)
 		{
-			check(!m_reflectionProperties.PushConstantMap.contains(cachedData.ShaderStage));
+			check(!properties.PushConstantMap.contains(shaderStage));
 			ShaderPushConstantBufferInfo info;
 			info.Name = resource.name.c_str();
 			info.Offset = compiler.get_decoration(resource.id, spv::DecorationOffset);
 			const spirv_cross::SPIRType& type = compiler.get_type(resource.type_id);
 			info.Size = (uint32_t)compiler.get_declared_struct_size(type);
-			info.ShaderStage = cachedData.ShaderStage;
-			m_reflectionProperties.PushConstantMap[cachedData.ShaderStage] = info;
+			info.ShaderStage = shaderStage;
+			properties.PushConstantMap[shaderStage] = info;
 			Logf(LogLevel::Debug, "> PUSH_CONSTANT [ShaderStage: %s; Name: %s; Offset: %zd; Size: %zd]\n",
-				vkutils::GetVulkanShaderStageName(cachedData.ShaderStage), info.Name.c_str(), info.Offset, info.Size);
+				vkutils::GetVulkanShaderStageName(shaderStage), info.Name.c_str(), info.Offset, info.Size);
 		}
 
 		Log(LogLevel::Debug, "End shader reflection.\n");
 	}
 
-	ShaderDescriptorSetInfo& ShaderCompiler::FindOrCreateDescriptorSet(uint32_t set)
+	void ShaderCompiler::MergeReflection(const ShaderReflectionProperties& stageProperties)
 	{
-		for (uint32_t i = 0; i < (uint32_t)m_reflectionProperties.DescriptorSetInfoArray.size(); ++i)
+		for (const ShaderDescriptorSetInfo& stageSet : stageProperties.DescriptorSetInfoArray)
 		{
-			if (m_reflectionProperties.DescriptorSetInfoArray[i].SetIndex == set)
-				return m_reflectionProperties.DescriptorSetInfoArray[i];
+			ShaderDescriptorSetInfo& descriptorSetInfo = FindOrCreateDescriptorSet(m_reflectionProperties, stageSet.SetIndex);
+			if (descriptorSetInfo.BindingArray.size() < stageSet.BindingArray.size())
+				descriptorSetInfo.BindingArray.resize(stageSet.BindingArray.size());
+			for (uint32_t i = 0; i < (uint32_t)stageSet.BindingArray.size(); ++i)
+			{
+				if (stageSet.BindingArray[i].Type != VK_DESCRIPTOR_TYPE_MAX_ENUM)
+					descriptorSetInfo.BindingArray[i] = stageSet.BindingArray[i];
+			}
+		}
+		for (const auto& it : stageProperties.PushConstantMap)
+		{
+			check(!m_reflectionProperties.PushConstantMap.contains(it.first));
+			m_reflectionProperties.PushConstantMap[it.first] = it.second;
+		}
+	}
+
+	ShaderDescriptorSetInfo& ShaderCompiler::FindOrCreateDescriptorSet(ShaderReflectionProperties& properties, uint32_t set)
+	{
+		for (uint32_t i = 0; i < (uint32_t)properties.DescriptorSetInfoArray.size(); ++i)
+		{
+			if (properties.DescriptorSetInfoArray[i].SetIndex == set)
+				return properties.DescriptorSetInfoArray[i];
 		}
 
 		ShaderDescriptorSetInfo info;
 		info.SetIndex = set;
-		m_reflectionProperties.DescriptorSetInfoArray.push_back(info);
-		return m_reflectionProperties.DescriptorSetInfoArray.back();
+		properties.DescriptorSetInfoArray.push_back(info);
+		return properties.DescriptorSetInfoArray.back();
 	}
 
 	const ShaderDescriptorSetInfo& ShaderCompiler::GetDescriptorSet(uint32_t set) const
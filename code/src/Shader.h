@@ -5,6 +5,7 @@
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <mutex>
 
 namespace vkmmc
 {
@@ -41,6 +42,59 @@ namespace vkmmc
 		std::unordered_map<VkShaderStageFlagBits, ShaderPushConstantBufferInfo> PushConstantMap;
 	};
 
+	// Shader file loaded and reflected once, shared by every pipeline that uses it.
+	struct LibraryShader
+	{
+		std::string Filepath;
+		VkShaderStageFlagBits Stage;
+		// Hash of the SPIR-V words and the stage.
+		uint64_t Hash;
+		std::vector<uint32_t> BinarySource;
+		// Reflection of this stage only.
+		ShaderReflectionProperties Reflection;
+		VkShaderModule Module;
+		// Shader compilers holding it, guarded by the library mutex.
+		uint32_t Users;
+		// Replaced by a reload, destroyed when the last user releases it.
+		bool Retired;
+	};
+
+	/**
+	 * Engine wide shader cache keyed by file path and stage. The .spv file is read, reflected and its
+	 * VkShaderModule created the first time a pipeline asks for it. Reflection is persisted in
+	 * cacheDirectory keyed by content hash, so later runs skip SPIRV-Cross parsing of unchanged shaders.
+	 * Thread safe.
+	 */
+	class ShaderLibrary
+	{
+	public:
+		// cacheDirectory: null to keep reflection only in memory.
+		void Init(const char* cacheDirectory);
+		void Destroy(const RenderContext& renderContext);
+
+		// Null if the file can't be read. Every shader returned must be given back with Release.
+		const LibraryShader* Get(const RenderContext& renderContext, const char* filepath, VkShaderStageFlagBits stage);
+		void Release(const RenderContext& renderContext, const LibraryShader* shader);
+		// Read again every stage loaded from filepath. Returns true if the content changed. Previous versions
+		// stay alive until the pipelines being built with them release them.
+		bool Reload(const RenderContext& renderContext, const char* filepath);
+
+	private:
+		LibraryShader* Load(const RenderContext& renderContext, const char* filepath, VkShaderStageFlagBits stage, bool& reflectionCached) const;
+		static void DestroyShader(const RenderContext& renderContext, LibraryShader* shader);
+		void GetReflectionCachePath(uint64_t hash, char* path, size_t size) const;
+		bool LoadReflection(const char* path, uint64_t hash, ShaderReflectionProperties& properties) const;
+		bool SaveReflection(const char* path, uint64_t hash, const ShaderReflectionProperties& properties) const;
+
+		std::mutex m_mutex;
+		std::unordered_map<std::string, LibraryShader*> m_shaders;
+		// Replaced shaders still in use.
+		std::vector<LibraryShader*> m_retired;
+		std::string m_cacheDirectory;
+		uint32_t m_hits{ 0 };
+		uint32_t m_reflectionCacheHits{ 0 };
+	};
+
 	class ShaderCompiler
 	{
 		struct CachedBinaryData
@@ -48,6 +102,8 @@ namespace vkmmc
 			VkShaderStageFlagBits ShaderStage;
 			std::vector<uint32_t> BinarySource;
 			VkShaderModule CompiledModule;
+			// Module owned by the shader library, released instead of destroyed by the compiler.
+			const vkmmc::LibraryShader* LibraryShader{ nullptr };
 		};
 	public:
 		ShaderCompiler(const RenderContext& renderContext);
@@ -76,9 +132,12 @@ namespace vkmmc
 
 		static bool CacheSourceFromFile(const char* file, std::vector<uint32_t>& outCachedData);
 		static bool CheckShaderFileExtension(const char* filepath, VkShaderStageFlagBits shaderStage);
+		// SPIRV-Cross reflection of one stage.
+		static void ReflectSource(const std::vector<uint32_t>& binarySource, VkShaderStageFlagBits shaderStage, ShaderReflectionProperties& properties);
 	protected:
-		void ProcessCachedSource(CachedBinaryData& cachedData);
-		ShaderDescriptorSetInfo& FindOrCreateDescriptorSet(uint32_t set);
+		// Add the reflection of one stage to the pipeline reflection.
+		void MergeReflection(const ShaderReflectionProperties& stageProperties);
+		static ShaderDescriptorSetInfo& FindOrCreateDescriptorSet(ShaderReflectionProperties& properties, uint32_t set);
 		const ShaderDescriptorSetInfo& GetDescriptorSet(uint32_t set) const;
 		VkDescriptorSetLayout GenerateDescriptorSetLayout(const ShaderDescriptorSetInfo& setInfo, DescriptorLayoutCache& layoutCache) const;
 		VkPushConstantRange GeneratePushConstantInfo(const ShaderPushConstantBufferInfo& pushConstantInfo) const;
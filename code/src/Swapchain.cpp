@@ -23,7 +23,35 @@ namespace vkmmc
 		m_images = swapchain.get_images().value();
 		m_imageViews = swapchain.get_image_views().value();
 		m_imageFormat = types::FormatType(swapchain.image_format);
+		InitDepthBuffer(renderContext, spec);
+		return true;
+	}
 
+	bool Swapchain::InitOffscreen(const RenderContext& renderContext, const SwapchainInitializationSpec& spec, uint32_t imageCount)
+	{
+		check(spec.ImageWidth > 0 && spec.ImageHeight > 0 && imageCount > 0);
+		check(renderContext.Device != VK_NULL_HANDLE);
+		// Same format the swapchain picks by default, pipelines behave as with a window.
+		m_imageFormat = FORMAT_B8G8R8A8;
+		VkExtent3D extent = { spec.ImageWidth, spec.ImageHeight, 1 };
+		for (uint32_t i = 0; i < imageCount; ++i)
+		{
+			VkImageCreateInfo imageInfo = vkinit::ImageCreateInfo(types::FormatType(m_imageFormat),
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, extent);
+			AllocatedImage image = Memory::CreateImage(renderContext.Allocator, imageInfo, MEMORY_USAGE_GPU);
+			VkImageViewCreateInfo viewInfo = vkinit::ImageViewCreateInfo(types::FormatType(m_imageFormat), image.Image, VK_IMAGE_ASPECT_COLOR_BIT);
+			VkImageView view;
+			vkcheck(vkCreateImageView(renderContext.Device, &viewInfo, nullptr, &view));
+			m_offscreenImages.push_back(image);
+			m_images.push_back(image.Image);
+			m_imageViews.push_back(view);
+		}
+		InitDepthBuffer(renderContext, spec);
+		return true;
+	}
+
+	void Swapchain::InitDepthBuffer(const RenderContext& renderContext, const SwapchainInitializationSpec& spec)
+	{
 		// Create depth buffer
 		VkExtent3D depthExtent = { spec.ImageWidth, spec.ImageHeight, 1 };
 		m_depthFormat = types::FormatType(VK_FORMAT_D32_SFLOAT);
@@ -33,7 +61,6 @@ namespace vkmmc
 		// Image view
 		VkImageViewCreateInfo viewInfo = vkinit::ImageViewCreateInfo(types::FormatType(m_depthFormat), m_depthImage.Image, VK_IMAGE_ASPECT_DEPTH_BIT);
 		vkcheck(vkCreateImageView(renderContext.Device, &viewInfo, nullptr, &m_depthImageView));
-		return true;
 	}
 
 	void Swapchain::Destroy(const RenderContext& renderContext)
@@ -45,6 +72,13 @@ namespace vkmmc
 
 		vkDestroyImageView(renderContext.Device, m_depthImageView, nullptr);
 		Memory::DestroyImage(renderContext.Allocator, m_depthImage);
-		vkDestroySwapchainKHR(renderContext.Device, m_swapchain, nullptr);
+		for (AllocatedImage& image : m_offscreenImages)
+			Memory::DestroyImage(renderContext.Allocator, image);
+		m_offscreenImages.clear();
+		if (m_swapchain != VK_NULL_HANDLE)
+		{
+			vkDestroySwapchainKHR(renderContext.Device, m_swapchain, nullptr);
+			m_swapchain = VK_NULL_HANDLE;
+		}
 	}
 }
\ No newline at end of file
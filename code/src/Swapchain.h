@@ -17,8 +17,12 @@ namespace vkmmc
 	{
 	public:
 		bool Init(const RenderContext& renderContext, const SwapchainInitializationSpec& spec);
+		// Headless rendering, images allocated by the engine without surface nor presentation.
+		bool InitOffscreen(const RenderContext& renderContext, const SwapchainInitializationSpec& spec, uint32_t imageCount);
 		void Destroy(const RenderContext& renderContext);
 
+		inline bool IsOffscreen() const { return m_swapchain == VK_NULL_HANDLE; }
+
 		VkSwapchainKHR GetSwapchainHandle() const { return m_swapchain; }
 
 		inline EFormat GetImageFormat() const { return m_imageFormat; }
@@ -33,10 +37,14 @@ namespace vkmmc
 		inline VkImageView GetDepthImageView() const { return m_depthImageView; }
 
 	private:
-		VkSwapchainKHR m_swapchain;
+		void InitDepthBuffer(const RenderContext& renderContext, const SwapchainInitializationSpec& spec);
+
+		VkSwapchainKHR m_swapchain{ VK_NULL_HANDLE };
 		EFormat m_imageFormat;
 		std::vector<VkImage> m_images;
 		std::vector<VkImageView> m_imageViews;
+		// Memory of the images in offscreen mode.
+		std::vector<AllocatedImage> m_offscreenImages;
 
 		EFormat m_depthFormat;
 		AllocatedImage m_depthImage;
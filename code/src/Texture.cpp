@@ -7,7 +7,17 @@
 #include "Debug.h"
 #include "RenderTypes.h"
 #include "RenderContext.h"
+#include "SamplerCache.h"
 #include "InitVulkanTypes.h"
+#include <vector>
+#include <fstream>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VKMMC_TEXTURE_SSE2 1
+#else
+#define VKMMC_TEXTURE_SSE2 0
+#endif
 
 namespace vkutils
 {
@@ -21,6 +31,331 @@ namespace vkutils
 		vkmmc::Logf(vkmmc::LogLevel::Error, "Unsupported number of channels #%d.\n", channels);
 		return vkmmc::FORMAT_INVALID;
 	}
+
+	enum class ETextureContainer
+	{
+		None,
+		DDS,
+		KTX2
+	};
+
+	constexpr uint32_t DDSMagic = 0x20534444; // "DDS "
+	constexpr uint8_t KTX2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	constexpr uint32_t MakeFourCC(char a, char b, char c, char d)
+	{
+		return (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)c << 16) | ((uint32_t)d << 24);
+	}
+
+	struct DDSPixelFormat
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t FourCC;
+		uint32_t RGBBitCount;
+		uint32_t RBitMask;
+		uint32_t GBitMask;
+		uint32_t BBitMask;
+		uint32_t ABitMask;
+	};
+
+	struct DDSHeader
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t Height;
+		uint32_t Width;
+		uint32_t PitchOrLinearSize;
+		uint32_t Depth;
+		uint32_t MipMapCount;
+		uint32_t Reserved1[11];
+		DDSPixelFormat PixelFormat;
+		uint32_t Caps;
+		uint32_t Caps2;
+		uint32_t Caps3;
+		uint32_t Caps4;
+		uint32_t Reserved2;
+	};
+	static_assert(sizeof(DDSHeader) == 124);
+
+	struct DDSHeaderDX10
+	{
+		uint32_t DXGIFormat;
+		uint32_t ResourceDimension;
+		uint32_t MiscFlag;
+		uint32_t ArraySize;
+		uint32_t MiscFlags2;
+	};
+
+	ETextureContainer GetTextureContainer(const std::vector<unsigned char>& data)
+	{
+		if (data.size() >= sizeof(uint32_t) + sizeof(DDSHeader) && *reinterpret_cast<const uint32_t*>(data.data()) == DDSMagic)
+			return ETextureContainer::DDS;
+		if (data.size() >= 80 && !memcmp(data.data(), KTX2Identifier, sizeof(KTX2Identifier)))
+			return ETextureContainer::KTX2;
+		return ETextureContainer::None;
+	}
+
+	template <typename T>
+	T ReadValue(const std::vector<unsigned char>& data, size_t offset)
+	{
+		T value;
+		memcpy(&value, data.data() + offset, sizeof(T));
+		return value;
+	}
+
+	uint32_t GetFormatChannels(vkmmc::EFormat format)
+	{
+		switch (format)
+		{
+		case vkmmc::FORMAT_BC4_UNORM: return 1;
+		case vkmmc::FORMAT_BC5_UNORM: return 2;
+		case vkmmc::FORMAT_R8G8B8:
+		case vkmmc::FORMAT_B8G8R8: return 3;
+		default: return 4;
+		}
+	}
+
+	vkmmc::EFormat GetDDSFormat(const DDSHeader& header, const DDSHeaderDX10* dx10)
+	{
+		if (dx10)
+		{
+			switch (dx10->DXGIFormat)
+			{
+			case 28: return vkmmc::FORMAT_R8G8B8A8_UNORM; // DXGI_FORMAT_R8G8B8A8_UNORM
+			case 29: return vkmmc::FORMAT_R8G8B8A8; // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+			case 71: return vkmmc::FORMAT_BC1_UNORM;
+			case 72: return vkmmc::FORMAT_BC1_SRGB;
+			case 77: return vkmmc::FORMAT_BC3_UNORM;
+			case 78: return vkmmc::FORMAT_BC3_SRGB;
+			case 80: return vkmmc::FORMAT_BC4_UNORM;
+			case 83: return vkmmc::FORMAT_BC5_UNORM;
+			case 98: return vkmmc::FORMAT_BC7_UNORM;
+			case 99: return vkmmc::FORMAT_BC7_SRGB;
+			}
+			return vkmmc::FORMAT_INVALID;
+		}
+		// Legacy fourcc. Color space is not stored, assume srgb for color formats.
+		switch (header.PixelFormat.FourCC)
+		{
+		case MakeFourCC('D', 'X', 'T', '1'): return vkmmc::FORMAT_BC1_SRGB;
+		case MakeFourCC('D', 'X', 'T', '5'): return vkmmc::FORMAT_BC3_SRGB;
+		case MakeFourCC('A', 'T', 'I', '1'):
+		case MakeFourCC('B', 'C', '4', 'U'): return vkmmc::FORMAT_BC4_UNORM;
+		case MakeFourCC('A', 'T', 'I', '2'):
+		case MakeFourCC('B', 'C', '5', 'U'): return vkmmc::FORMAT_BC5_UNORM;
+		}
+		return vkmmc::FORMAT_INVALID;
+	}
+
+	// Enough levels for any 32 bit extent.
+	constexpr uint32_t MaxContainerMipLevels = 32;
+
+	// Dimensions and level count come from the file, reject what the loader cannot index.
+	bool ValidateLevels(const char* path, const vkmmc::io::TextureRaw& out)
+	{
+		if (!out.Width || !out.Height)
+		{
+			vkmmc::Logf(vkmmc::LogLevel::Error, "Invalid texture size %ux%u in %s.\n", out.Width, out.Height, path);
+			return false;
+		}
+		if (out.MipLevels > vkmmc::Texture::ComputeMipLevels(out.Width, out.Height))
+		{
+			vkmmc::Logf(vkmmc::LogLevel::Error, "Invalid mip level count %u for %ux%u in %s.\n", out.MipLevels, out.Width, out.Height, path);
+			return false;
+		}
+		return true;
+	}
+
+	size_t GetContainerLevelSize(const vkmmc::io::TextureRaw& texture, uint32_t mip)
+	{
+		return vkmmc::types::FormatLevelSize(texture.Format, __max(texture.Width >> mip, 1u), __max(texture.Height >> mip, 1u));
+	}
+
+	// Container opened by OpenContainer, level data is read on demand.
+	struct ContainerFile
+	{
+		std::ifstream Stream;
+		size_t Size = 0;
+		vkmmc::io::TextureRaw Desc;
+		size_t LevelOffsets[MaxContainerMipLevels];
+	};
+
+	// Read levels [firstMip, firstMip + levelCount) tightly packed. Allocated with malloc to be released by io::FreeTexture.
+	bool ReadLevels(ContainerFile& file, uint32_t firstMip, uint32_t levelCount, vkmmc::io::TextureRaw& out)
+	{
+		check(firstMip + levelCount <= file.Desc.MipLevels);
+		size_t totalSize = 0;
+		for (uint32_t i = firstMip; i < firstMip + levelCount; ++i)
+			totalSize += GetContainerLevelSize(file.Desc, i);
+		out = file.Desc;
+		out.Width = __max(file.Desc.Width >> firstMip, 1u);
+		out.Height = __max(file.Desc.Height >> firstMip, 1u);
+		out.MipLevels = levelCount;
+		out.Pixels = (unsigned char*)malloc(totalSize);
+		if (!out.Pixels)
+			return false;
+		size_t dstOffset = 0;
+		for (uint32_t i = firstMip; i < firstMip + levelCount; ++i)
+		{
+			const size_t levelSize = GetContainerLevelSize(file.Desc, i);
+			const size_t levelOffset = file.LevelOffsets[i];
+			if (levelOffset > file.Size || levelSize > file.Size - levelOffset
+				|| !file.Stream.seekg(levelOffset) || !file.Stream.read((char*)out.Pixels + dstOffset, levelSize))
+			{
+				free(out.Pixels);
+				out.Pixels = nullptr;
+				return false;
+			}
+			dstOffset += levelSize;
+		}
+		return true;
+	}
+
+	bool ParseDDS(const char* path, const std::vector<unsigned char>& data, vkmmc::io::TextureRaw& out, size_t* levelOffsets)
+	{
+		constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+		DDSHeader header = ReadValue<DDSHeader>(data, sizeof(uint32_t));
+		size_t offset = sizeof(uint32_t) + sizeof(DDSHeader);
+		DDSHeaderDX10 dx10;
+		bool hasDX10 = header.PixelFormat.FourCC == MakeFourCC('D', 'X', '1', '0');
+		if (hasDX10)
+		{
+			if (data.size() < offset + sizeof(DDSHeaderDX10))
+				return false;
+			dx10 = ReadValue<DDSHeaderDX10>(data, offset);
+			offset += sizeof(DDSHeaderDX10);
+		}
+		out.Format = GetDDSFormat(header, hasDX10 ? &dx10 : nullptr);
+		if (out.Format == vkmmc::FORMAT_INVALID)
+		{
+			vkmmc::Logf(vkmmc::LogLevel::Error, "Unsupported dds pixel format in %s.\n", path);
+			return false;
+		}
+		out.Width = header.Width;
+		out.Height = header.Height;
+		out.Channels = GetFormatChannels(out.Format);
+		out.MipLevels = (header.Flags & DDSD_MIPMAPCOUNT) && header.MipMapCount ? header.MipMapCount : 1;
+		if (!ValidateLevels(path, out))
+			return false;
+
+		for (uint32_t i = 0; i < out.MipLevels; ++i)
+		{
+			levelOffsets[i] = offset;
+			offset += GetContainerLevelSize(out, i);
+		}
+		return true;
+	}
+
+	bool ParseKTX2(const char* path, const std::vector<unsigned char>& data, vkmmc::io::TextureRaw& out, size_t* levelOffsets)
+	{
+		// Header fields after the 12 bytes identifier
+		const uint32_t vkFormat = ReadValue<uint32_t>(data, 12);
+		const uint32_t pixelWidth = ReadValue<uint32_t>(data, 20);
+		const uint32_t pixelHeight = ReadValue<uint32_t>(data, 24);
+		const uint32_t pixelDepth = ReadValue<uint32_t>(data, 28);
+		const uint32_t layerCount = ReadValue<uint32_t>(data, 32);
+		const uint32_t faceCount = ReadValue<uint32_t>(data, 36);
+		const uint32_t levelCount = ReadValue<uint32_t>(data, 40);
+		const uint32_t supercompressionScheme = ReadValue<uint32_t>(data, 44);
+		if (supercompressionScheme != 0)
+		{
+			vkmmc::Logf(vkmmc::LogLevel::Error, "Supercompressed ktx2 not supported (%s).\n", path);
+			return false;
+		}
+		if (pixelDepth > 1 || layerCount > 1 || faceCount != 1)
+		{
+			vkmmc::Logf(vkmmc::LogLevel::Error, "Only 2D ktx2 textures are supported (%s).\n", path);
+			return false;
+		}
+		switch (vkFormat)
+		{
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+		case VK_FORMAT_BC5_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+			out.Format = vkmmc::types::FormatType((VkFormat)vkFormat);
+			break;
+		default:
+			vkmmc::Logf(vkmmc::LogLevel::Error, "Unsupported ktx2 vkFormat %u in %s.\n", vkFormat, path);
+			return false;
+		}
+		out.Width = pixelWidth;
+		out.Height = pixelHeight;
+		out.Channels = GetFormatChannels(out.Format);
+		out.MipLevels = levelCount ? levelCount : 1;
+		if (!ValidateLevels(path, out))
+			return false;
+
+		// Level index starts after the index section. Entries ordered from base level.
+		constexpr size_t levelIndexOffset = 80;
+		if (data.size() < levelIndexOffset + out.MipLevels * 3 * sizeof(uint64_t))
+			return false;
+		for (uint32_t i = 0; i < out.MipLevels; ++i)
+			levelOffsets[i] = (size_t)ReadValue<uint64_t>(data, levelIndexOffset + i * 3 * sizeof(uint64_t));
+		return true;
+	}
+
+	// Open path and parse its header when it is a dds or ktx2 file. Returns None for any other file.
+	// Malformed or unsupported containers are logged and leave an empty description (zero size).
+	ETextureContainer OpenContainer(const char* path, ContainerFile& file)
+	{
+		file.Stream.open(path, std::ios::ate | std::ios::binary);
+		if (!file.Stream.is_open())
+			return ETextureContainer::None;
+		file.Size = (size_t)file.Stream.tellg();
+		// Big enough to hold any container header and the ktx2 level index of the longest chain.
+		std::vector<unsigned char> data(__min(file.Size, (size_t)1024));
+		file.Stream.seekg(0);
+		file.Stream.read((char*)data.data(), data.size());
+		const ETextureContainer container = GetTextureContainer(data);
+		bool valid = false;
+		if (container == ETextureContainer::DDS)
+			valid = ParseDDS(path, data, file.Desc, file.LevelOffsets);
+		else if (container == ETextureContainer::KTX2)
+			valid = ParseKTX2(path, data, file.Desc, file.LevelOffsets);
+		if (container != ETextureContainer::None && !valid)
+			file.Desc = vkmmc::io::TextureRaw();
+		return container;
+	}
+
+	bool SupportsBlitMipmaps(const vkmmc::RenderContext& renderContext, VkFormat format)
+	{
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(renderContext.GPUDevice, format, &properties);
+		const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT
+			| VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+		return (properties.optimalTilingFeatures & required) == required;
+	}
+
+	void CmdImageBarrier(VkCommandBuffer cmd, VkImage image, uint32_t baseMip, uint32_t mipCount,
+		VkImageLayout oldLayout, VkImageLayout newLayout,
+		VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+		VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage)
+	{
+		VkImageMemoryBarrier barrier
+		{
+			.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+			.pNext = nullptr,
+			.srcAccessMask = srcAccess,
+			.dstAccessMask = dstAccess,
+			.oldLayout = oldLayout,
+			.newLayout = newLayout,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = image,
+			.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, baseMip, mipCount, 0, 1 },
+		};
+		vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
 }
 
 namespace vkmmc
@@ -31,6 +366,18 @@ namespace vkmmc
 		if (!path || !*path)
 			return false;
 
+		// Check for compressed containers first
+		{
+			vkutils::ContainerFile file;
+			if (vkutils::OpenContainer(path, file) != vkutils::ETextureContainer::None)
+			{
+				const bool result = file.Desc.Width && vkutils::ReadLevels(file, 0, file.Desc.MipLevels, out);
+				if (!result)
+					Logf(LogLevel::Error, "Fail to load texture data from %s.\n", path);
+				return result;
+			}
+		}
+
 		//stbi_set_flip_vertically_on_load(true);
 		int32_t width, height, channels;
 		stbi_uc* pixels = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
@@ -56,80 +403,356 @@ namespace vkmmc
 		stbi_image_free(data);
 	}
 
-	void Texture::Init(const RenderContext& renderContext, const io::TextureRaw& textureRaw)
+	// 2x2 box filter to the next mip level. Odd dimensions clamp to the last row/column.
+	void io::DownsampleBox(const unsigned char* src, uint32_t srcWidth, uint32_t srcHeight, unsigned char* dst, uint32_t channels)
+	{
+		const uint32_t dstWidth = __max(srcWidth >> 1, 1u);
+		const uint32_t dstHeight = __max(srcHeight >> 1, 1u);
+		const size_t srcPitch = srcWidth * channels;
+		for (uint32_t y = 0; y < dstHeight; ++y)
+		{
+			const unsigned char* row0 = src + __min(2 * y, srcHeight - 1) * srcPitch;
+			const unsigned char* row1 = src + __min(2 * y + 1, srcHeight - 1) * srcPitch;
+			unsigned char* dstRow = dst + y * dstWidth * channels;
+			uint32_t x = 0;
+#if VKMMC_TEXTURE_SSE2
+			// RGBA8, 4 destination pixels per iteration while the 8 source pixels of both rows are in range.
+			// Sums in 16 bits so rounding matches the scalar path.
+			if (channels == 4)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i two = _mm_set1_epi16(2);
+				for (; 2 * x + 8 <= srcWidth; x += 4)
+				{
+					const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+					const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x + 16));
+					const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+					const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x + 16));
+					// Vertical sums of source pixels 0-1, 2-3, 4-5 and 6-7.
+					const __m128i v01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+					const __m128i v23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+					const __m128i v45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+					const __m128i v67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+					// Horizontal pairs, one destination pixel per 64 bit lane.
+					const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi64(v01, v23), _mm_unpackhi_epi64(v01, v23));
+					const __m128i s1 = _mm_add_epi16(_mm_unpacklo_epi64(v45, v67), _mm_unpackhi_epi64(v45, v67));
+					const __m128i r0 = _mm_srli_epi16(_mm_add_epi16(s0, two), 2);
+					const __m128i r1 = _mm_srli_epi16(_mm_add_epi16(s1, two), 2);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow + 4 * x), _mm_packus_epi16(r0, r1));
+				}
+			}
+#endif // VKMMC_TEXTURE_SSE2
+			for (; x < dstWidth; ++x)
+			{
+				const uint32_t x0 = __min(2 * x, srcWidth - 1) * channels;
+				const uint32_t x1 = __min(2 * x + 1, srcWidth - 1) * channels;
+				for (uint32_t c = 0; c < channels; ++c)
+					dstRow[x * channels + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+			}
+		}
+	}
+
+	size_t io::GetLevelSize(const TextureRaw& texture, uint32_t mip)
+	{
+		const uint32_t width = __max(texture.Width >> mip, 1u);
+		const uint32_t height = __max(texture.Height >> mip, 1u);
+		if (texture.Format == FORMAT_INVALID)
+			return (size_t)width * height * texture.Channels;
+		return types::FormatLevelSize(texture.Format, width, height);
+	}
+
+	bool io::LoadTextureInfo(const char* path, TextureRaw& out)
+	{
+		if (!path || !*path)
+			return false;
+		vkutils::ContainerFile file;
+		if (vkutils::OpenContainer(path, file) != vkutils::ETextureContainer::None)
+		{
+			out = file.Desc;
+			return out.Width != 0;
+		}
+		// Images decoded by stb_image are expanded to RGBA, levels are generated from the base one.
+		int32_t width, height, channels;
+		if (!stbi_info(path, &width, &height, &channels))
+		{
+			Logf(LogLevel::Error, "Fail to read texture info from %s.\n", path);
+			return false;
+		}
+		out = TextureRaw();
+		out.Width = (uint32_t)width;
+		out.Height = (uint32_t)height;
+		out.Channels = 4;
+		out.MipLevels = Texture::ComputeMipLevels(out.Width, out.Height);
+		return true;
+	}
+
+	bool io::LoadTextureLevels(const char* path, uint32_t firstMip, uint32_t levelCount, TextureRaw& out)
+	{
+		check(levelCount > 0);
+		{
+			vkutils::ContainerFile file;
+			if (vkutils::OpenContainer(path, file) != vkutils::ETextureContainer::None)
+			{
+				if (!file.Desc.Width || firstMip + levelCount > file.Desc.MipLevels)
+					return false;
+				return vkutils::ReadLevels(file, firstMip, levelCount, out);
+			}
+		}
+
+		// Base level has to be decoded, it is downsampled up to the last requested level and dropped as soon as possible.
+		TextureRaw level;
+		if (!LoadTexture(path, level))
+			return false;
+		if (firstMip + levelCount > Texture::ComputeMipLevels(level.Width, level.Height))
+		{
+			FreeTexture(level.Pixels);
+			return false;
+		}
+		TextureRaw desc = level;
+		desc.MipLevels = firstMip + levelCount;
+		size_t size = 0;
+		for (uint32_t i = firstMip; i < desc.MipLevels; ++i)
+			size += GetLevelSize(desc, i);
+		out = desc;
+		out.Width = __max(desc.Width >> firstMip, 1u);
+		out.Height = __max(desc.Height >> firstMip, 1u);
+		out.MipLevels = levelCount;
+		out.Pixels = (unsigned char*)malloc(size);
+		size_t offset = 0;
+		for (uint32_t i = 0; i < desc.MipLevels && out.Pixels; ++i)
+		{
+			const size_t levelSize = GetLevelSize(desc, i);
+			if (i >= firstMip)
+			{
+				memcpy(out.Pixels + offset, level.Pixels, levelSize);
+				offset += levelSize;
+			}
+			if (i + 1 == desc.MipLevels)
+				break;
+			unsigned char* next = (unsigned char*)malloc(GetLevelSize(desc, i + 1));
+			if (next)
+				DownsampleBox(level.Pixels, __max(desc.Width >> i, 1u), __max(desc.Height >> i, 1u), next, desc.Channels);
+			FreeTexture(level.Pixels);
+			level.Pixels = next;
+			if (!next)
+			{
+				free(out.Pixels);
+				out.Pixels = nullptr;
+			}
+		}
+		FreeTexture(level.Pixels);
+		return out.Pixels != nullptr;
+	}
+
+	uint32_t Texture::ComputeMipLevels(uint32_t width, uint32_t height)
+	{
+		uint32_t levels = 1;
+		for (uint32_t size = __max(width, height); size > 1; size >>= 1)
+			++levels;
+		return levels;
+	}
+
+	void Texture::Init(const RenderContext& renderContext, const io::TextureRaw& textureRaw, bool generateMipmaps)
 	{
 		check(!m_image.IsAllocated());
 		check(textureRaw.Pixels && textureRaw.Width && textureRaw.Height);
-		check(textureRaw.Channels == 4 || textureRaw.Channels == 3);
 
-		// Create transit buffer
-		VkDeviceSize size = textureRaw.Width * textureRaw.Height * textureRaw.Channels;
-		EFormat imageFormat = vkutils::GetImageFormatFromChannels(textureRaw.Channels);
+		EFormat imageFormat = textureRaw.Format;
+		if (imageFormat == FORMAT_INVALID)
+		{
+			check(textureRaw.Channels == 4 || textureRaw.Channels == 3);
+			imageFormat = vkutils::GetImageFormatFromChannels(textureRaw.Channels);
+		}
 		VkFormat format = types::FormatType(imageFormat);
+		// Block compressed data can't be blitted or filtered on cpu, use the levels stored in the container.
+		const bool prebuiltMips = textureRaw.MipLevels > 1 || types::IsBlockCompressed(imageFormat);
+		if (prebuiltMips)
+			m_mipLevels = textureRaw.MipLevels;
+		else
+			m_mipLevels = generateMipmaps ? ComputeMipLevels(textureRaw.Width, textureRaw.Height) : 1;
+		// Generate mips on gpu when format supports it, otherwise precompute the whole chain on cpu.
+		const bool gpuMipmaps = !prebuiltMips && m_mipLevels > 1 && vkutils::SupportsBlitMipmaps(renderContext, format);
+
+		// Mip chain layout in the transit buffer
+		std::vector<VkBufferImageCopy> copyRegions;
+		VkDeviceSize size = 0;
+		const uint32_t uploadLevels = gpuMipmaps ? 1 : m_mipLevels;
+		for (uint32_t i = 0; i < uploadLevels; ++i)
+		{
+			VkBufferImageCopy region
+			{
+				.bufferOffset = size,
+				.bufferRowLength = 0,
+				.bufferImageHeight = 0
+			};
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = i;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageExtent = { __max(textureRaw.Width >> i, 1u), __max(textureRaw.Height >> i, 1u), 1 };
+			copyRegions.push_back(region);
+			size += types::FormatLevelSize(imageFormat, region.imageExtent.width, region.imageExtent.height);
+		}
+
+		// Create transit buffer
 		AllocatedBuffer stageBuffer = Memory::CreateBuffer(renderContext.Allocator, size,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MEMORY_USAGE_CPU);
-		Memory::MemCopy(renderContext.Allocator, stageBuffer, textureRaw.Pixels, size);
+		if (uploadLevels == 1 || prebuiltMips)
+		{
+			Memory::MemCopy(renderContext.Allocator, stageBuffer, textureRaw.Pixels, size);
+		}
+		else
+		{
+			std::vector<unsigned char> mipChain(size);
+			memcpy(mipChain.data(), textureRaw.Pixels, textureRaw.Width * textureRaw.Height * textureRaw.Channels);
+			for (uint32_t i = 1; i < uploadLevels; ++i)
+			{
+				const VkBufferImageCopy& src = copyRegions[i - 1];
+				io::DownsampleBox(&mipChain[src.bufferOffset], src.imageExtent.width, src.imageExtent.height,
+					&mipChain[copyRegions[i].bufferOffset], textureRaw.Channels);
+			}
+			Memory::MemCopy(renderContext.Allocator, stageBuffer, mipChain.data(), size);
+		}
+
+		m_format = imageFormat;
+		m_width = textureRaw.Width;
+		m_height = textureRaw.Height;
 
 		// Prepare image creation
 		VkExtent3D extent;
 		extent.width = textureRaw.Width;
 		extent.height = textureRaw.Height;
 		extent.depth = 1;
-		VkImageCreateInfo imageInfo = vkinit::ImageCreateInfo(format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, extent);
+		VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		if (gpuMipmaps)
+			usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		VkImageCreateInfo imageInfo = vkinit::ImageCreateInfo(format, usage, extent, 1, m_mipLevels);
 		m_image = Memory::CreateImage(renderContext.Allocator, imageInfo, MEMORY_USAGE_GPU);
 
+		const uint32_t mipLevels = m_mipLevels;
 		utils::CmdSubmitTransfer(renderContext, 
-			[=](VkCommandBuffer cmd) 
+			[&](VkCommandBuffer cmd) 
 			{
-				VkImageSubresourceRange range{};
-				range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				range.baseMipLevel = 0;
-				range.levelCount = 1;
-				range.baseArrayLayer = 0;
-				range.layerCount = 1;
-				VkImageMemoryBarrier transferBarrier
+				VkImage image = m_image.Image;
+				vkutils::CmdImageBarrier(cmd, image, 0, mipLevels,
+					VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					0, VK_ACCESS_TRANSFER_WRITE_BIT,
+					VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+				// Copy buffer
+				vkCmdCopyBufferToImage(cmd, stageBuffer.Buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+					(uint32_t)copyRegions.size(), copyRegions.data());
+				if (gpuMipmaps)
 				{
-					.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-					.pNext = nullptr,
-					.srcAccessMask = 0,
-					.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-					.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-					.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					.image = m_image.Image,
-					.subresourceRange = range,
-				};
-				vkCmdPipelineBarrier(cmd,
-					VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-					VK_PIPELINE_STAGE_TRANSFER_BIT,
-					0, 0, nullptr, 0, nullptr, 1, &transferBarrier);
-				VkBufferImageCopy copyRegion
+					// Each level is blitted from the previous one, which is moved to shader read once consumed.
+					for (uint32_t i = 1; i < mipLevels; ++i)
+					{
+						vkutils::CmdImageBarrier(cmd, image, i - 1, 1,
+							VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+							VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+							VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+						VkImageBlit blit{};
+						blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i - 1, 0, 1 };
+						blit.srcOffsets[1] = { (int32_t)__max(extent.width >> (i - 1), 1u), (int32_t)__max(extent.height >> (i - 1), 1u), 1 };
+						blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 };
+						blit.dstOffsets[1] = { (int32_t)__max(extent.width >> i, 1u), (int32_t)__max(extent.height >> i, 1u), 1 };
+						vkCmdBlitImage(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+							image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+						vkutils::CmdImageBarrier(cmd, image, i - 1, 1,
+							VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+							VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+							VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+					}
+					vkutils::CmdImageBarrier(cmd, image, mipLevels - 1, 1,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+						VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+				}
+				else
 				{
-					.bufferOffset = 0,
-					.bufferRowLength = 0,
-					.bufferImageHeight = 0
-				};
-				copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				copyRegion.imageSubresource.mipLevel = 0;
-				copyRegion.imageSubresource.baseArrayLayer = 0;
-				copyRegion.imageSubresource.layerCount = 1;
-				copyRegion.imageExtent = extent;
-				// Copy buffer
-				vkCmdCopyBufferToImage(cmd, stageBuffer.Buffer, m_image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-					1, &copyRegion);
-				VkImageMemoryBarrier imageBarrier = transferBarrier;
-				imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-				imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-				vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
-					VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-					0, 0, nullptr, 0, nullptr, 1, &imageBarrier);
+					vkutils::CmdImageBarrier(cmd, image, 0, mipLevels,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+						VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+				}
 			});
 
 		// Destroy transfer buffer.
 		Memory::DestroyBuffer(renderContext.Allocator, stageBuffer);
 
-		// Create Image view
+		CreateImageView(renderContext, format);
+	}
+
+	void Texture::InitEmpty(const RenderContext& renderContext, EFormat format, uint32_t width, uint32_t height, uint32_t mipLevels)
+	{
+		check(!m_image.IsAllocated());
+		check(width && height && mipLevels && mipLevels <= ComputeMipLevels(width, height));
+		m_format = format;
+		m_width = width;
+		m_height = height;
+		m_mipLevels = mipLevels;
+		// Streamed images are the copy source of the next residency change.
+		const VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		VkImageCreateInfo imageInfo = vkinit::ImageCreateInfo(types::FormatType(format), usage, { width, height, 1 }, 1, mipLevels);
+		m_image = Memory::CreateImage(renderContext.Allocator, imageInfo, MEMORY_USAGE_GPU);
+		CreateImageView(renderContext, types::FormatType(format));
+	}
+
+	void Texture::CmdStreamLevels(VkCommandBuffer cmd, VkBuffer buffer, uint32_t uploadLevels, const Texture& previous, uint32_t previousFirstMip) const
+	{
+		check(uploadLevels <= m_mipLevels);
+		const uint32_t copyLevels = m_mipLevels - uploadLevels;
+		vkutils::CmdImageBarrier(cmd, m_image.Image, 0, m_mipLevels,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			0, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+		if (uploadLevels)
+		{
+			std::vector<VkBufferImageCopy> regions(uploadLevels);
+			VkDeviceSize offset = 0;
+			for (uint32_t i = 0; i < uploadLevels; ++i)
+			{
+				VkBufferImageCopy& region = regions[i];
+				region = { .bufferOffset = offset, .bufferRowLength = 0, .bufferImageHeight = 0 };
+				region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1 };
+				region.imageExtent = { __max(m_width >> i, 1u), __max(m_height >> i, 1u), 1 };
+				offset += types::FormatLevelSize(m_format, region.imageExtent.width, region.imageExtent.height);
+			}
+			vkCmdCopyBufferToImage(cmd, buffer, m_image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, uploadLevels, regions.data());
+		}
+		if (copyLevels)
+		{
+			check(previous.m_format == m_format && previousFirstMip + copyLevels == previous.m_mipLevels);
+			// Frames in flight may be sampling the previous image, reads only wait for them.
+			vkutils::CmdImageBarrier(cmd, previous.m_image.Image, previousFirstMip, copyLevels,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				0, VK_ACCESS_TRANSFER_READ_BIT,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+			std::vector<VkImageCopy> regions(copyLevels);
+			for (uint32_t i = 0; i < copyLevels; ++i)
+			{
+				const uint32_t mip = uploadLevels + i;
+				VkImageCopy& region = regions[i];
+				region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, previousFirstMip + i, 0, 1 };
+				region.srcOffset = { 0, 0, 0 };
+				region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1 };
+				region.dstOffset = { 0, 0, 0 };
+				region.extent = { __max(m_width >> mip, 1u), __max(m_height >> mip, 1u), 1 };
+			}
+			vkCmdCopyImage(cmd, previous.m_image.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				m_image.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copyLevels, regions.data());
+			vkutils::CmdImageBarrier(cmd, previous.m_image.Image, previousFirstMip, copyLevels,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		}
+		vkutils::CmdImageBarrier(cmd, m_image.Image, 0, m_mipLevels,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+	}
+
+	void Texture::CreateImageView(const RenderContext& renderContext, VkFormat format)
+	{
 		VkImageViewCreateInfo viewInfo
 		{
 			.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
@@ -139,7 +762,7 @@ namespace vkmmc
 			.format = format,
 		};
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = m_mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -147,6 +770,15 @@ namespace vkmmc
 		vkcheck(vkCreateImageView(renderContext.Device, &viewInfo, nullptr, &m_imageView));
 	}
 
+	bool Texture::IsFormatSupported(const RenderContext& renderContext, EFormat format)
+	{
+		if (types::IsBlockCompressed(format) && !renderContext.GPUFeatures.textureCompressionBC)
+			return false;
+		VkFormatProperties properties;
+		vkGetPhysicalDeviceFormatProperties(renderContext.GPUDevice, types::FormatType(format), &properties);
+		return properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+	}
+
 	void Texture::Destroy(const RenderContext& renderContext)
 	{
 		Memory::DestroyImage(renderContext.Allocator, m_image);
@@ -206,14 +838,53 @@ namespace vkmmc
 	void Sampler::Destroy(const RenderContext& renderContext)
 	{
 		check(m_sampler != VK_NULL_HANDLE);
-		vkDestroySampler(renderContext.Device, m_sampler, nullptr);
+		if (renderContext.SamplerCache)
+			renderContext.SamplerCache->Release(renderContext, m_sampler);
+		else
+			vkDestroySampler(renderContext.Device, m_sampler, nullptr);
+		m_sampler = VK_NULL_HANDLE;
+	}
+
+	VkSamplerMipmapMode GetSamplerMipmapMode(ESamplerMipmapMode mode)
+	{
+		switch (mode)
+		{
+		case SAMPLER_MIPMAP_MODE_NEAREST: return VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		case SAMPLER_MIPMAP_MODE_LINEAR: return VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		default:
+			check(false && "Unreachable");
+		}
+		return VK_SAMPLER_MIPMAP_MODE_MAX_ENUM;
 	}
 
 	Sampler SamplerBuilder::Build(const RenderContext& renderContext) const
 	{
+		VkSamplerCreateInfo info = GetCreateInfo(renderContext);
+		if (renderContext.SamplerCache)
+			return Sampler(renderContext.SamplerCache->Acquire(renderContext, info));
 		VkSampler sampler;
-		VkSamplerCreateInfo info = vkinit::SamplerCreateInfo(GetFilterType(MinFilter), GetSamplerAddressMode(AddressMode.AddressMode.U));
 		vkcheck(vkCreateSampler(renderContext.Device, &info, nullptr, &sampler));
 		return Sampler(sampler);
 	}
+
+	VkSamplerCreateInfo SamplerBuilder::GetCreateInfo(const RenderContext& renderContext) const
+	{
+		VkSamplerCreateInfo info = vkinit::SamplerCreateInfo(GetFilterType(MinFilter), GetSamplerAddressMode(AddressMode.AddressMode.U));
+		info.magFilter = GetFilterType(MaxFilter);
+		info.addressModeV = GetSamplerAddressMode(AddressMode.AddressMode.V);
+		info.addressModeW = GetSamplerAddressMode(AddressMode.AddressMode.W);
+		info.mipmapMode = GetSamplerMipmapMode(MipmapMode);
+		info.minLod = MinLod;
+		info.maxLod = MaxLod;
+		info.mipLodBias = LodBias;
+		// Anisotropy is clamped to device limits and ignored when the feature is not enabled.
+		if (MaxAnisotropy > 1.f && renderContext.GPUFeatures.samplerAnisotropy)
+		{
+			info.anisotropyEnable = VK_TRUE;
+			info.maxAnisotropy = __min(MaxAnisotropy, renderContext.GPUProperties.limits.maxSamplerAnisotropy);
+		}
+		info.compareEnable = CompareEnable ? VK_TRUE : VK_FALSE;
+		info.compareOp = CompareEnable ? CompareOp : VK_COMPARE_OP_NEVER;
+		return info;
+	}
 }
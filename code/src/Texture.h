@@ -14,22 +14,56 @@ namespace vkmmc
 			uint32_t Width = 0;
 			uint32_t Height = 0;
 			uint32_t Channels = 0;
+			// Containers (dds, ktx2) set the stored format and number of prebuilt mip levels.
+			// Pixels holds every level tightly packed starting from the base level.
+			// FORMAT_INVALID means uncompressed data with format deduced from Channels.
+			EFormat Format = FORMAT_INVALID;
+			uint32_t MipLevels = 1;
 		};
+		// Supports dds and ktx2 containers (BC1, BC3, BC4, BC5, BC7 and RGBA8) and any format handled by stb_image.
 		bool LoadTexture(const char* path, TextureRaw& out);
 		void FreeTexture(unsigned char* data);
+		// 2x2 box filter from level data to the next level.
+		void DownsampleBox(const unsigned char* src, uint32_t srcWidth, uint32_t srcHeight, unsigned char* dst, uint32_t channels);
+		// Size in bytes of one level of the texture.
+		size_t GetLevelSize(const TextureRaw& texture, uint32_t mip);
+		// Description of the texture without pixels. Containers read only their header, MipLevels of other images
+		// is the whole chain generated from the base level.
+		bool LoadTextureInfo(const char* path, TextureRaw& out);
+		// Load levels [firstMip, firstMip + levelCount) of the chain described by LoadTextureInfo. Containers read only
+		// those levels, other images are decoded and downsampled up to the last one. Result is released with FreeTexture.
+		bool LoadTextureLevels(const char* path, uint32_t firstMip, uint32_t levelCount, TextureRaw& out);
 	}
 
 	class Texture
 	{
 	public:
-		void Init(const RenderContext& renderContext, const io::TextureRaw& textureRaw);
+		// Full mip chain is generated when generateMipmaps is true.
+		void Init(const RenderContext& renderContext, const io::TextureRaw& textureRaw, bool generateMipmaps = true);
+		// Image with undefined content, written later with CmdStreamLevels in a frame command buffer.
+		void InitEmpty(const RenderContext& renderContext, EFormat format, uint32_t width, uint32_t height, uint32_t mipLevels);
 		void Destroy(const RenderContext& renderContext);
 
+		// Record the content of a texture created with InitEmpty: first uploadLevels levels from buffer (tightly packed
+		// from offset 0), the rest copied from the levels of previous starting at previousFirstMip.
+		// Both textures end in shader read layout.
+		void CmdStreamLevels(VkCommandBuffer cmd, VkBuffer buffer, uint32_t uploadLevels, const Texture& previous, uint32_t previousFirstMip) const;
+
 		VkImageView GetImageView() const { return m_imageView; }
+		uint32_t GetMipLevels() const { return m_mipLevels; }
 		void Bind(const RenderContext& renderContext, VkDescriptorSet set, VkSampler sampler, uint32_t binding, uint32_t arrayIndex = 0) const;
+
+		static uint32_t ComputeMipLevels(uint32_t width, uint32_t height);
+		static bool IsFormatSupported(const RenderContext& renderContext, EFormat format);
 	private:
+		void CreateImageView(const RenderContext& renderContext, VkFormat format);
+
 		AllocatedImage m_image;
 		VkImageView m_imageView;
+		EFormat m_format = FORMAT_INVALID;
+		uint32_t m_width = 0;
+		uint32_t m_height = 0;
+		uint32_t m_mipLevels = 1;
 	};
 
 	enum EFilterType
@@ -50,6 +84,13 @@ namespace vkmmc
 	};
 	VkSamplerAddressMode GetSamplerAddressMode(ESamplerAddressMode mode);
 
+	enum ESamplerMipmapMode
+	{
+		SAMPLER_MIPMAP_MODE_NEAREST,
+		SAMPLER_MIPMAP_MODE_LINEAR,
+	};
+	VkSamplerMipmapMode GetSamplerMipmapMode(ESamplerMipmapMode mode);
+
 	class Sampler
 	{
 	public:
@@ -57,6 +98,7 @@ namespace vkmmc
 		Sampler(VkSampler sampler) : m_sampler(sampler) {}
 		Sampler(const Sampler& other) : m_sampler(other.m_sampler) {}
 		Sampler& operator=(const Sampler& other) { m_sampler = other.m_sampler; return *this; }
+		// Release the reference to the cached sampler.
 		void Destroy(const RenderContext& renderContext);
 		VkSampler GetSampler() const { return m_sampler; }
 	private:
@@ -78,8 +120,19 @@ namespace vkmmc
 			} AddressMode;
 			ESamplerAddressMode AddresModeUVW[3];
 		} AddressMode = { SAMPLER_ADDRESS_MODE_REPEAT, SAMPLER_ADDRESS_MODE_REPEAT, SAMPLER_ADDRESS_MODE_REPEAT };
+		// Trilinear by default. Anisotropy disabled with values <= 1.
+		ESamplerMipmapMode MipmapMode = SAMPLER_MIPMAP_MODE_LINEAR;
+		float MaxAnisotropy = 1.f;
+		float MinLod = 0.f;
+		float MaxLod = VK_LOD_CLAMP_NONE;
+		float LodBias = 0.f;
+		// Depth comparison (shadow map sampling).
+		bool CompareEnable = false;
+		VkCompareOp CompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
 
 		SamplerBuilder() = default;
+		// Shared with other builders with the same state when the render context has a sampler cache.
 		Sampler Build(const RenderContext& renderContext) const;
+		VkSamplerCreateInfo GetCreateInfo(const RenderContext& renderContext) const;
 	};
 }
\ No newline at end of file
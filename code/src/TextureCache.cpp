@@ -0,0 +1,97 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "TextureCache.h"
+#include "Debug.h"
+#include <filesystem>
+
+namespace vkmmc
+{
+	void TextureCache::Destroy(const RenderContext& renderContext)
+	{
+		if (!m_entries.empty())
+			Logf(LogLevel::Warn, "Texture cache destroyed with %u textures still referenced.\n", (uint32_t)m_entries.size());
+		for (auto& it : m_entries)
+			it.second.Texture.Destroy(renderContext);
+		m_entries.clear();
+		m_keys.clear();
+		Logf(LogLevel::Info, "Texture cache: %u hits, %.2f MB of duplicated textures avoided.\n",
+			m_hits, (double)m_savedMemorySize / (1024.0 * 1024.0));
+		m_memorySize = 0;
+	}
+
+	RenderHandle TextureCache::Acquire(const char* path, ETextureUsage usage)
+	{
+		auto it = m_keys.find(BuildKey(path, usage));
+		if (it == m_keys.end())
+			return RenderHandle();
+		Entry& entry = m_entries[it->second];
+		++entry.RefCount;
+		++m_hits;
+		m_savedMemorySize += entry.MemorySize;
+		return it->second;
+	}
+
+	void TextureCache::Add(const char* path, ETextureUsage usage, RenderHandle handle, const Texture& texture, const io::TextureRaw& raw)
+	{
+		check(handle.IsValid() && !m_entries.contains(handle));
+		Entry entry;
+		entry.Texture = texture;
+		entry.Key = BuildKey(path, usage);
+		entry.RefCount = 1;
+		// Only estimation, generated mips are a third of the base level.
+		if (raw.Format != FORMAT_INVALID)
+		{
+			for (uint32_t i = 0; i < raw.MipLevels; ++i)
+				entry.MemorySize += types::FormatLevelSize(raw.Format, raw.Width >> i, raw.Height >> i);
+		}
+		else
+		{
+			size_t baseSize = (size_t)raw.Width * raw.Height * 4;
+			entry.MemorySize = texture.GetMipLevels() > 1 ? baseSize * 4 / 3 : baseSize;
+		}
+		check(!m_keys.contains(entry.Key));
+		m_keys[entry.Key] = handle;
+		m_memorySize += entry.MemorySize;
+		m_entries[handle] = entry;
+	}
+
+	const Texture* TextureCache::Get(RenderHandle handle) const
+	{
+		auto it = m_entries.find(handle);
+		return it != m_entries.end() ? &it->second.Texture : nullptr;
+	}
+
+	void TextureCache::Update(RenderHandle handle, const Texture& texture, size_t memorySize)
+	{
+		auto it = m_entries.find(handle);
+		check(it != m_entries.end());
+		it->second.Texture = texture;
+		m_memorySize = m_memorySize - it->second.MemorySize + memorySize;
+		it->second.MemorySize = memorySize;
+	}
+
+	bool TextureCache::Release(const RenderContext& renderContext, RenderHandle handle)
+	{
+		auto it = m_entries.find(handle);
+		check(it != m_entries.end() && it->second.RefCount > 0);
+		if (--it->second.RefCount)
+			return false;
+		it->second.Texture.Destroy(renderContext);
+		m_memorySize -= it->second.MemorySize;
+		m_keys.erase(it->second.Key);
+		m_entries.erase(it);
+		return true;
+	}
+
+	std::string TextureCache::BuildKey(const char* path, ETextureUsage usage)
+	{
+		// Canonical form so different relative paths to the same file match.
+		std::error_code error;
+		std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+		std::string key = error ? std::string(path) : canonical.generic_string();
+		key += '#';
+		key += std::to_string((uint32_t)usage);
+		return key;
+	}
+}
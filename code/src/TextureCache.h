@@ -0,0 +1,54 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include "RenderHandle.h"
+#include "Texture.h"
+#include "TextureCompressor.h"
+#include <string>
+#include <unordered_map>
+
+namespace vkmmc
+{
+	/**
+	 * Textures loaded from file shared by every material and scene.
+	 * Entries are keyed by canonical path and usage and released when the last reference is gone.
+	 */
+	class TextureCache
+	{
+		struct Entry
+		{
+			vkmmc::Texture Texture;
+			std::string Key;
+			uint32_t RefCount = 0;
+			size_t MemorySize = 0;
+		};
+	public:
+		void Destroy(const RenderContext& renderContext);
+
+		// Returns a valid handle and adds a reference if the texture was already loaded.
+		RenderHandle Acquire(const char* path, ETextureUsage usage);
+		// Register a new texture with one reference.
+		void Add(const char* path, ETextureUsage usage, RenderHandle handle, const Texture& texture, const io::TextureRaw& raw);
+		// Returns true when the texture was destroyed (last reference).
+		bool Release(const RenderContext& renderContext, RenderHandle handle);
+		bool Contains(RenderHandle handle) const { return m_entries.contains(handle); }
+		const Texture* Get(RenderHandle handle) const;
+		// Replace the gpu resource of an entry (texture streaming). Previous one is not destroyed.
+		void Update(RenderHandle handle, const Texture& texture, size_t memorySize);
+
+		size_t GetMemorySize() const { return m_memorySize; }
+		size_t GetSavedMemorySize() const { return m_savedMemorySize; }
+
+	private:
+		static std::string BuildKey(const char* path, ETextureUsage usage);
+
+		std::unordered_map<std::string, RenderHandle> m_keys;
+		std::unordered_map<RenderHandle, Entry, RenderHandle::Hasher> m_entries;
+		// Stats
+		size_t m_memorySize = 0;
+		size_t m_savedMemorySize = 0;
+		uint32_t m_hits = 0;
+	};
+}
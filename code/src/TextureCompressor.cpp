@@ -0,0 +1,421 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "TextureCompressor.h"
+#include "WorkerPool.h"
+#include "Globals.h"
+#include "Debug.h"
+#include "GenericUtils.h"
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+
+namespace bc_internal
+{
+	// Bump when encoders output changes to invalidate the cache.
+	constexpr uint32_t EncoderVersion = 1;
+
+	inline uint16_t To565(const float* rgb)
+	{
+		auto quantize = [](float v, int32_t max)
+			{
+				int32_t q = (int32_t)(v * max / 255.f + 0.5f);
+				return q < 0 ? 0 : (q > max ? max : q);
+			};
+		return (uint16_t)((quantize(rgb[0], 31) << 11) | (quantize(rgb[1], 63) << 5) | quantize(rgb[2], 31));
+	}
+
+	inline void From565(uint16_t c, int32_t* rgb)
+	{
+		int32_t r = (c >> 11) & 31;
+		int32_t g = (c >> 5) & 63;
+		int32_t b = c & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	// Color block with 4 color mode. Endpoints from the extremes of the pixels projected on the principal axis.
+	void EncodeColorBlock(const unsigned char* rgba, unsigned char* out)
+	{
+		float mean[3] = { 0.f, 0.f, 0.f };
+		for (uint32_t i = 0; i < 16; ++i)
+			for (uint32_t c = 0; c < 3; ++c)
+				mean[c] += rgba[i * 4 + c];
+		for (uint32_t c = 0; c < 3; ++c)
+			mean[c] /= 16.f;
+
+		// Covariance matrix (symmetric)
+		float cov[6] = { 0.f };
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			float r = rgba[i * 4 + 0] - mean[0];
+			float g = rgba[i * 4 + 1] - mean[1];
+			float b = rgba[i * 4 + 2] - mean[2];
+			cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+			cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+		}
+
+		// Principal axis by power iteration
+		float axis[3] = { 1.f, 1.f, 1.f };
+		for (uint32_t it = 0; it < 4; ++it)
+		{
+			float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			float m = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+			if (m < 1e-6f)
+				break;
+			axis[0] = x / m; axis[1] = y / m; axis[2] = z / m;
+		}
+
+		uint32_t minIndex = 0, maxIndex = 0;
+		float minDot = FLT_MAX, maxDot = -FLT_MAX;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			float d = rgba[i * 4 + 0] * axis[0] + rgba[i * 4 + 1] * axis[1] + rgba[i * 4 + 2] * axis[2];
+			if (d < minDot) { minDot = d; minIndex = i; }
+			if (d > maxDot) { maxDot = d; maxIndex = i; }
+		}
+		float maxColor[3] = { (float)rgba[maxIndex * 4 + 0], (float)rgba[maxIndex * 4 + 1], (float)rgba[maxIndex * 4 + 2] };
+		float minColor[3] = { (float)rgba[minIndex * 4 + 0], (float)rgba[minIndex * 4 + 1], (float)rgba[minIndex * 4 + 2] };
+		uint16_t c0 = To565(maxColor);
+		uint16_t c1 = To565(minColor);
+		// 4 color mode requires c0 > c1
+		if (c0 < c1)
+		{
+			uint16_t t = c0; c0 = c1; c1 = t;
+		}
+
+		uint32_t indices = 0;
+		if (c0 != c1)
+		{
+			int32_t palette[4][3];
+			From565(c0, palette[0]);
+			From565(c1, palette[1]);
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint32_t best = 0;
+				int32_t bestDist = INT32_MAX;
+				for (uint32_t p = 0; p < 4; ++p)
+				{
+					int32_t dr = rgba[i * 4 + 0] - palette[p][0];
+					int32_t dg = rgba[i * 4 + 1] - palette[p][1];
+					int32_t db = rgba[i * 4 + 2] - palette[p][2];
+					int32_t dist = dr * dr + dg * dg + db * db;
+					if (dist < bestDist)
+					{
+						bestDist = dist;
+						best = p;
+					}
+				}
+				indices |= best << (2 * i);
+			}
+		}
+		memcpy(out + 0, &c0, sizeof(uint16_t));
+		memcpy(out + 2, &c1, sizeof(uint16_t));
+		memcpy(out + 4, &indices, sizeof(uint32_t));
+	}
+
+	// Gather a 4x4 block clamping to image borders.
+	void FetchBlock(const unsigned char* pixels, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, unsigned char* block)
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			uint32_t py = __min(by * 4 + y, height - 1);
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				uint32_t px = __min(bx * 4 + x, width - 1);
+				memcpy(&block[(y * 4 + x) * 4], &pixels[(py * width + px) * 4], 4);
+			}
+		}
+	}
+
+	vkmmc::EFormat GetTargetFormat(const vkmmc::io::TextureRaw& source, vkmmc::ETextureUsage usage)
+	{
+		switch (usage)
+		{
+		case vkmmc::TEXTURE_USAGE_NORMAL: return vkmmc::FORMAT_BC5_UNORM;
+		case vkmmc::TEXTURE_USAGE_MASK: return vkmmc::FORMAT_BC4_UNORM;
+		case vkmmc::TEXTURE_USAGE_COLOR:
+		default:
+			{
+				const size_t pixelCount = (size_t)source.Width * source.Height;
+				for (size_t i = 0; i < pixelCount; ++i)
+				{
+					if (source.Pixels[i * 4 + 3] != 255)
+						return vkmmc::FORMAT_BC3_SRGB;
+				}
+				return vkmmc::FORMAT_BC1_SRGB;
+			}
+		}
+	}
+
+	double ElapsedMs(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	// Cache entry keyed by source content, usage and encoder version.
+	bool GetCachePath(const char* path, vkmmc::ETextureUsage usage, char (&cachePath)[512])
+	{
+		std::vector<unsigned char> fileData;
+		{
+			std::ifstream file(path, std::ios::ate | std::ios::binary);
+			if (!file.is_open())
+				return false;
+			fileData.resize((size_t)file.tellg());
+			file.seekg(0);
+			file.read((char*)fileData.data(), fileData.size());
+		}
+		uint64_t hash = vkmmc::hash::Fnv1a(fileData.data(), fileData.size());
+		const uint32_t key[2] = { (uint32_t)usage, EncoderVersion };
+		hash = vkmmc::hash::Fnv1a(key, sizeof(key), hash);
+		sprintf_s(cachePath, "%s%016llx.ktx2", vkmmc::globals::TextureCacheDirectory, (unsigned long long)hash);
+		return true;
+	}
+}
+
+namespace vkmmc
+{
+	void bc::EncodeBC1(const unsigned char* rgba, unsigned char* out)
+	{
+		bc_internal::EncodeColorBlock(rgba, out);
+	}
+
+	void bc::EncodeBC3(const unsigned char* rgba, unsigned char* out)
+	{
+		EncodeBC4(rgba + 3, 4, out);
+		bc_internal::EncodeColorBlock(rgba, out + 8);
+	}
+
+	void bc::EncodeBC4(const unsigned char* values, uint32_t stride, unsigned char* out)
+	{
+		uint8_t minValue = 255, maxValue = 0;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			uint8_t v = values[i * stride];
+			minValue = __min(minValue, v);
+			maxValue = __max(maxValue, v);
+		}
+		// 8 values mode (a0 > a1): index 0 -> a0, 1 -> a1, 2..7 -> interpolated from a0 to a1.
+		out[0] = maxValue;
+		out[1] = minValue;
+		uint64_t indices = 0;
+		if (maxValue != minValue)
+		{
+			const float scale = 7.f / (float)(maxValue - minValue);
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				uint32_t step = (uint32_t)((maxValue - values[i * stride]) * scale + 0.5f);
+				uint64_t index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+				indices |= index << (3 * i);
+			}
+		}
+		for (uint32_t i = 0; i < 6; ++i)
+			out[2 + i] = (unsigned char)(indices >> (8 * i));
+	}
+
+	void bc::EncodeBC5(const unsigned char* rgba, unsigned char* out)
+	{
+		EncodeBC4(rgba + 0, 4, out);
+		EncodeBC4(rgba + 1, 4, out + 8);
+	}
+
+	bool io::CompressTexture(const TextureRaw& source, ETextureUsage usage, TextureRaw& out, WorkerPool* workerPool)
+	{
+		check(source.Pixels && source.Format == FORMAT_INVALID && source.Channels == 4);
+		out.Width = source.Width;
+		out.Height = source.Height;
+		out.Format = bc_internal::GetTargetFormat(source, usage);
+		out.Channels = usage == TEXTURE_USAGE_MASK ? 1 : (usage == TEXTURE_USAGE_NORMAL ? 2 : 4);
+		out.MipLevels = Texture::ComputeMipLevels(source.Width, source.Height);
+
+		size_t totalSize = 0;
+		for (uint32_t i = 0; i < out.MipLevels; ++i)
+			totalSize += types::FormatLevelSize(out.Format, source.Width >> i, source.Height >> i);
+		out.Pixels = (unsigned char*)malloc(totalSize);
+		if (!out.Pixels)
+			return false;
+
+		const uint32_t blockSize = types::FormatLevelSize(out.Format, 1, 1);
+		std::vector<unsigned char> level(source.Pixels, source.Pixels + (size_t)source.Width * source.Height * 4);
+		std::vector<unsigned char> nextLevel;
+		size_t dstOffset = 0;
+		for (uint32_t mip = 0; mip < out.MipLevels; ++mip)
+		{
+			const uint32_t width = __max(source.Width >> mip, 1u);
+			const uint32_t height = __max(source.Height >> mip, 1u);
+			const uint32_t blocksX = (width + 3) / 4;
+			const uint32_t blocksY = (height + 3) / 4;
+			unsigned char* dst = out.Pixels + dstOffset;
+			const unsigned char* pixels = level.data();
+			const EFormat format = out.Format;
+			// One task per row of blocks
+			auto encodeRow = [=](uint32_t by)
+				{
+					unsigned char block[64];
+					for (uint32_t bx = 0; bx < blocksX; ++bx)
+					{
+						bc_internal::FetchBlock(pixels, width, height, bx, by, block);
+						unsigned char* blockOut = dst + ((size_t)by * blocksX + bx) * blockSize;
+						switch (format)
+						{
+						case FORMAT_BC1_SRGB: bc::EncodeBC1(block, blockOut); break;
+						case FORMAT_BC3_SRGB: bc::EncodeBC3(block, blockOut); break;
+						case FORMAT_BC4_UNORM: bc::EncodeBC4(block, 4, blockOut); break;
+						case FORMAT_BC5_UNORM: bc::EncodeBC5(block, blockOut); break;
+						default: check(false && "Unexpected target format."); break;
+						}
+					}
+				};
+			if (workerPool)
+				workerPool->ParallelFor(blocksY, encodeRow);
+			else
+			{
+				for (uint32_t by = 0; by < blocksY; ++by)
+					encodeRow(by);
+			}
+			dstOffset += types::FormatLevelSize(out.Format, width, height);
+
+			if (mip + 1 < out.MipLevels)
+			{
+				nextLevel.resize((size_t)__max(width >> 1, 1u) * __max(height >> 1, 1u) * 4);
+				DownsampleBox(level.data(), width, height, nextLevel.data(), 4);
+				level.swap(nextLevel);
+			}
+		}
+		return true;
+	}
+
+	bool io::LoadCompressedTexture(const char* path, ETextureUsage usage, TextureRaw& out, WorkerPool* workerPool)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		char cachePath[512];
+		if (!bc_internal::GetCachePath(path, usage, cachePath))
+			return false;
+		std::error_code error;
+		if (std::filesystem::exists(cachePath, error) && LoadTexture(cachePath, out))
+		{
+			Logf(LogLevel::Info, "Texture loaded from cache %s -> %s (%.3f ms).\n", path, cachePath, bc_internal::ElapsedMs(start));
+			return true;
+		}
+
+		TextureRaw source;
+		if (!LoadTexture(path, source))
+			return false;
+		if (source.Format != FORMAT_INVALID)
+		{
+			// Already in a gpu ready container.
+			out = source;
+			return true;
+		}
+
+		auto encodeStart = std::chrono::high_resolution_clock::now();
+		bool result = CompressTexture(source, usage, out, workerPool);
+		const double encodeMs = bc_internal::ElapsedMs(encodeStart);
+		const double mpix = (double)source.Width * source.Height / 1e6;
+		FreeTexture(source.Pixels);
+		if (!result)
+			return false;
+		Logf(LogLevel::Info, "Texture compressed %s [%ux%u, %u mips] in %.3f ms (%.2f MPix/s).\n",
+			path, out.Width, out.Height, out.MipLevels, encodeMs, mpix / (encodeMs * 1e-3));
+
+		std::filesystem::create_directories(globals::TextureCacheDirectory, error);
+		if (!SaveKTX2(cachePath, out))
+			Logf(LogLevel::Warn, "Failed to save compressed texture in cache (%s).\n", cachePath);
+		return true;
+	}
+
+	bool io::GetCompressedTexturePath(const char* path, ETextureUsage usage, std::string& containerPath, WorkerPool* workerPool)
+	{
+		char cachePath[512];
+		if (!bc_internal::GetCachePath(path, usage, cachePath))
+			return false;
+		std::error_code error;
+		if (!std::filesystem::exists(cachePath, error))
+		{
+			TextureRaw texture;
+			if (!LoadCompressedTexture(path, usage, texture, workerPool))
+				return false;
+			FreeTexture(texture.Pixels);
+			if (!std::filesystem::exists(cachePath, error))
+			{
+				// Containers are not copied to the cache. Any other source failed to be saved.
+				TextureRaw info;
+				if (!LoadTextureInfo(path, info) || info.Format == FORMAT_INVALID)
+					return false;
+				containerPath = path;
+				return true;
+			}
+		}
+		containerPath = cachePath;
+		return true;
+	}
+
+	bool io::SaveKTX2(const char* path, const TextureRaw& texture)
+	{
+		check(texture.Format != FORMAT_INVALID && texture.Pixels);
+		constexpr uint8_t identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+		constexpr size_t headerSize = 80;
+		const uint32_t header[9] =
+		{
+			(uint32_t)types::FormatType(texture.Format), // vkFormat
+			1, // typeSize
+			texture.Width,
+			texture.Height,
+			0, // pixelDepth
+			0, // layerCount
+			1, // faceCount
+			texture.MipLevels,
+			0, // supercompressionScheme
+		};
+		// dfd and kvd offset/length (uint32) and sgd offset/length (uint64). All empty.
+		const uint32_t index[8] = { 0 };
+
+		// Level index ordered from base level, data stored from the smallest level as the spec recommends.
+		const size_t levelIndexSize = texture.MipLevels * 3 * sizeof(uint64_t);
+		std::vector<uint64_t> levelIndex(texture.MipLevels * 3);
+		std::vector<uint64_t> srcOffsets(texture.MipLevels);
+		uint64_t srcOffset = 0;
+		for (uint32_t i = 0; i < texture.MipLevels; ++i)
+		{
+			srcOffsets[i] = srcOffset;
+			srcOffset += types::FormatLevelSize(texture.Format, texture.Width >> i, texture.Height >> i);
+		}
+		uint64_t fileOffset = (headerSize + levelIndexSize + 15) & ~15ull;
+		for (int32_t i = (int32_t)texture.MipLevels - 1; i >= 0; --i)
+		{
+			uint64_t levelSize = types::FormatLevelSize(texture.Format, texture.Width >> i, texture.Height >> i);
+			levelIndex[i * 3 + 0] = fileOffset;
+			levelIndex[i * 3 + 1] = levelSize;
+			levelIndex[i * 3 + 2] = levelSize;
+			fileOffset = (fileOffset + levelSize + 15) & ~15ull;
+		}
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+		file.write((const char*)identifier, sizeof(identifier));
+		file.write((const char*)header, sizeof(header));
+		file.write((const char*)index, sizeof(index));
+		file.write((const char*)levelIndex.data(), levelIndexSize);
+		const char padding[16] = { 0 };
+		uint64_t written = headerSize + levelIndexSize;
+		for (int32_t i = (int32_t)texture.MipLevels - 1; i >= 0; --i)
+		{
+			file.write(padding, levelIndex[i * 3 + 0] - written);
+			file.write((const char*)texture.Pixels + srcOffsets[i], levelIndex[i * 3 + 1]);
+			written = levelIndex[i * 3 + 0] + levelIndex[i * 3 + 1];
+		}
+		return file.good();
+	}
+}
@@ -0,0 +1,48 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include "Texture.h"
+#include <string>
+
+namespace vkmmc
+{
+	class WorkerPool;
+
+	// Usage decides the target block compressed format at import time.
+	enum ETextureUsage
+	{
+		TEXTURE_USAGE_COLOR, // BC1 (BC3 with alpha), srgb
+		TEXTURE_USAGE_NORMAL, // BC5, RG channels
+		TEXTURE_USAGE_MASK, // BC4, R channel
+	};
+
+	namespace bc
+	{
+		// Encode a 4x4 block. Input pixels are RGBA8, row major.
+		void EncodeBC1(const unsigned char* rgba, unsigned char* out);
+		void EncodeBC3(const unsigned char* rgba, unsigned char* out);
+		// Single channel blocks read one component every stride bytes.
+		void EncodeBC4(const unsigned char* values, uint32_t stride, unsigned char* out);
+		void EncodeBC5(const unsigned char* rgba, unsigned char* out);
+	}
+
+	namespace io
+	{
+		// Compress an uncompressed RGBA8 texture generating the whole mip chain. Blocks are encoded in parallel
+		// when workerPool is not null. Result is released with FreeTexture.
+		bool CompressTexture(const TextureRaw& source, ETextureUsage usage, TextureRaw& out, WorkerPool* workerPool);
+
+		// Look for the compressed texture in the cache (keyed by source content hash and usage),
+		// compress the source image and save it to the cache if not found.
+		// Containers (dds, ktx2) are returned as they are.
+		bool LoadCompressedTexture(const char* path, ETextureUsage usage, TextureRaw& out, WorkerPool* workerPool);
+		// Path of a container with the compressed texture: the cache entry, or path itself for dds and ktx2 sources.
+		// Nothing is decoded when the entry exists, otherwise it is created as LoadCompressedTexture does.
+		bool GetCompressedTexturePath(const char* path, ETextureUsage usage, std::string& containerPath, WorkerPool* workerPool);
+
+		// Write mip chain in a ktx2 file (without data format descriptor, for internal use of the cache).
+		bool SaveKTX2(const char* path, const TextureRaw& texture);
+	}
+}
@@ -0,0 +1,391 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "TextureStreamer.h"
+#include "TextureCache.h"
+#include "RenderContext.h"
+#include "WorkerPool.h"
+#include "Debug.h"
+#include <algorithm>
+#include <cmath>
+#include <imgui/imgui.h>
+
+namespace vkmmc
+{
+	void TextureStreamer::Init(WorkerPool* workerPool, TextureCache* cache, size_t budget)
+	{
+		check(cache);
+		m_workerPool = workerPool;
+		m_cache = cache;
+		m_budget = budget;
+		Logf(LogLevel::Info, "Texture streaming budget: %.2f MB.\n", (double)budget / (1024.0 * 1024.0));
+	}
+
+	void TextureStreamer::Destroy(const RenderContext& renderContext)
+	{
+		// Loads in flight push their results when done.
+		if (m_workerPool)
+			m_workerPool->Wait();
+		for (LoadResult& result : m_results)
+		{
+			if (result.Success)
+				io::FreeTexture(result.Data.Pixels);
+		}
+		m_results.clear();
+		// Images of pending uploads are current textures, released by the texture cache.
+		for (PendingUpload& upload : m_uploads)
+		{
+			if (upload.Staging.IsAllocated())
+				Memory::DestroyBuffer(renderContext.Allocator, upload.Staging);
+		}
+		m_uploads.clear();
+		for (RetiredBuffer& retired : m_retiredBuffers)
+			Memory::DestroyBuffer(renderContext.Allocator, retired.Buffer);
+		m_retiredBuffers.clear();
+		for (RetiredTexture& retired : m_retired)
+			retired.Texture.Destroy(renderContext);
+		m_retired.clear();
+		// Current textures are released by the texture cache.
+		m_textures.clear();
+		m_committedSize = 0;
+		Logf(LogLevel::Info, "Texture streaming: %u uploads, %u evictions.\n", m_stats.Uploads, m_stats.Evictions);
+	}
+
+	bool TextureStreamer::Register(const RenderContext& renderContext, RenderHandle handle, const char* path, const io::TextureRaw& desc, Texture& texture)
+	{
+		check(!m_textures.contains(handle) && !desc.Pixels);
+		StreamedTexture streamed;
+		streamed.Path = path;
+		streamed.Desc = desc;
+		uint32_t minMip = 0;
+		while (minMip + 1 < desc.MipLevels && __max(desc.Width >> minMip, desc.Height >> minMip) > globals::TextureStreamingResidentSize)
+			++minMip;
+		streamed.MinResidentMip = minMip;
+		streamed.ResidentMip = minMip;
+		streamed.RequestedMip = minMip;
+		streamed.WantedMip = minMip;
+		streamed.TargetMip = minMip;
+
+		io::TextureRaw levels;
+		if (!io::LoadTextureLevels(path, minMip, desc.MipLevels - minMip, levels))
+			return false;
+		streamed.Current = CreateTexture(renderContext, streamed, minMip, levels);
+		io::FreeTexture(levels.Pixels);
+
+		m_committedSize += GetResidentSize(streamed, minMip);
+		m_textures[handle] = streamed;
+		texture = streamed.Current;
+		return true;
+	}
+
+	void TextureStreamer::Unregister(RenderHandle handle)
+	{
+		auto it = m_textures.find(handle);
+		if (it == m_textures.end())
+			return;
+		// Pending loads of this texture are discarded when they finish.
+		m_committedSize -= GetResidentSize(it->second, it->second.TargetMip);
+		// Current image has been released by the texture cache, don't record its upload.
+		const VkImageView view = it->second.Current.GetImageView();
+		for (size_t i = 0; i < m_uploads.size();)
+		{
+			if (m_uploads[i].Destination.GetImageView() == view)
+			{
+				if (m_uploads[i].Staging.IsAllocated())
+					m_retiredBuffers.push_back({ m_uploads[i].Staging, m_frame + globals::MaxOverlappedFrames });
+				m_uploads.erase(m_uploads.begin() + i);
+			}
+			else
+				++i;
+		}
+		m_textures.erase(it);
+	}
+
+	void TextureStreamer::AddBinding(RenderHandle handle, const VkDescriptorSet* sets, VkSampler sampler, uint32_t binding, uint32_t arrayIndex)
+	{
+		auto it = m_textures.find(handle);
+		check(it != m_textures.end());
+		Binding b;
+		for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+			b.Sets[i] = sets[i];
+		b.Sampler = sampler;
+		b.Binding = binding;
+		b.ArrayIndex = arrayIndex;
+		it->second.Bindings.push_back(b);
+	}
+
+	void TextureStreamer::RemoveBindings(VkDescriptorSet set)
+	{
+		for (auto& it : m_textures)
+		{
+			std::vector<Binding>& bindings = it.second.Bindings;
+			bindings.erase(std::remove_if(bindings.begin(), bindings.end(),
+				[set](const Binding& b) { return b.Sets[0] == set; }), bindings.end());
+		}
+	}
+
+	void TextureStreamer::Request(RenderHandle handle, float texelRatio)
+	{
+		auto it = m_textures.find(handle);
+		if (it == m_textures.end())
+			return;
+		StreamedTexture& texture = it->second;
+		// One mip level down each time texels per pixel doubles.
+		const float size = (float)__max(texture.Desc.Width, texture.Desc.Height);
+		const uint32_t mip = (uint32_t)log2f(__max(size * texelRatio, 1.f));
+		texture.RequestedMip = __min(texture.RequestedMip, __min(mip, texture.Desc.MipLevels - 1));
+	}
+
+	void TextureStreamer::Update(const RenderContext& renderContext, uint32_t frameIndex)
+	{
+		++m_frame;
+		// Release images and staging buffers not referenced by any frame in flight.
+		for (size_t i = 0; i < m_retired.size();)
+		{
+			if (m_frame >= m_retired[i].Frame)
+			{
+				m_retired[i].Texture.Destroy(renderContext);
+				m_retired[i] = m_retired.back();
+				m_retired.pop_back();
+			}
+			else
+				++i;
+		}
+		for (size_t i = 0; i < m_retiredBuffers.size();)
+		{
+			if (m_frame >= m_retiredBuffers[i].Frame)
+			{
+				Memory::DestroyBuffer(renderContext.Allocator, m_retiredBuffers[i].Buffer);
+				m_retiredBuffers[i] = m_retiredBuffers.back();
+				m_retiredBuffers.pop_back();
+			}
+			else
+				++i;
+		}
+		ApplyLoads(renderContext);
+		UpdateBindings(renderContext, frameIndex);
+		UpdateResidency(renderContext);
+	}
+
+	void TextureStreamer::RecordUploads(VkCommandBuffer cmd)
+	{
+		for (const PendingUpload& upload : m_uploads)
+		{
+			upload.Destination.CmdStreamLevels(cmd, upload.Staging.IsAllocated() ? upload.Staging.Buffer : VK_NULL_HANDLE,
+				upload.UploadLevels, upload.Previous, upload.PreviousFirstMip);
+			// Read by this frame, free once its fence has signaled.
+			if (upload.Staging.IsAllocated())
+				m_retiredBuffers.push_back({ upload.Staging, m_frame + globals::MaxOverlappedFrames });
+		}
+		m_uploads.clear();
+	}
+
+	size_t TextureStreamer::GetResidentSize(const StreamedTexture& texture, uint32_t firstMip) const
+	{
+		size_t size = 0;
+		for (uint32_t i = firstMip; i < texture.Desc.MipLevels; ++i)
+			size += io::GetLevelSize(texture.Desc, i);
+		return size;
+	}
+
+	Texture TextureStreamer::CreateTexture(const RenderContext& renderContext, const StreamedTexture& texture, uint32_t firstMip, const io::TextureRaw& levels)
+	{
+		// Images without container are decoded to RGBA.
+		const EFormat format = texture.Desc.Format != FORMAT_INVALID ? texture.Desc.Format : FORMAT_R8G8B8A8;
+		const uint32_t mipLevels = texture.Desc.MipLevels - firstMip;
+		Texture newTexture;
+		newTexture.InitEmpty(renderContext, format, __max(texture.Desc.Width >> firstMip, 1u), __max(texture.Desc.Height >> firstMip, 1u), mipLevels);
+
+		PendingUpload upload{ newTexture, {}, levels.MipLevels, texture.Current, 0 };
+		if (levels.MipLevels)
+		{
+			const size_t size = GetResidentSize(texture, firstMip) - GetResidentSize(texture, firstMip + levels.MipLevels);
+			upload.Staging = Memory::CreateBuffer(renderContext.Allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MEMORY_USAGE_CPU);
+			Memory::MemCopy(renderContext.Allocator, upload.Staging, levels.Pixels, size);
+		}
+		// Levels not loaded are the lowest ones of the current image.
+		if (levels.MipLevels < mipLevels)
+			upload.PreviousFirstMip = firstMip + levels.MipLevels - texture.ResidentMip;
+		m_uploads.push_back(upload);
+		return newTexture;
+	}
+
+	void TextureStreamer::SetResident(RenderHandle handle, StreamedTexture& texture, const Texture& newTexture, uint32_t firstMip)
+	{
+		// Previous image lives until every frame slot points to the new one.
+		m_retired.push_back({ texture.Current, m_frame + globals::MaxOverlappedFrames });
+		texture.Current = newTexture;
+		texture.ResidentMip = firstMip;
+		texture.PendingFrameMask = (1 << globals::MaxOverlappedFrames) - 1;
+		m_cache->Update(handle, newTexture, GetResidentSize(texture, texture.ResidentMip));
+	}
+
+	void TextureStreamer::ScheduleLoad(RenderHandle handle, StreamedTexture& texture, uint32_t firstMip)
+	{
+		check(!texture.Loading && firstMip < texture.ResidentMip);
+		texture.Loading = true;
+		m_committedSize = m_committedSize - GetResidentSize(texture, texture.TargetMip) + GetResidentSize(texture, firstMip);
+		texture.TargetMip = firstMip;
+		++m_stats.PendingLoads;
+
+		// Only the missing levels, resident ones are copied from the current image.
+		auto load = [this, handle, firstMip, levelCount = texture.ResidentMip - firstMip, path = texture.Path]()
+			{
+				LoadResult result{ handle, firstMip, {}, false };
+				result.Success = io::LoadTextureLevels(path.c_str(), firstMip, levelCount, result.Data);
+				std::lock_guard<std::mutex> lock(m_resultMutex);
+				m_results.push_back(result);
+			};
+		if (m_workerPool)
+			m_workerPool->Submit(load);
+		else
+			load();
+	}
+
+	void TextureStreamer::Evict(const RenderContext& renderContext, RenderHandle handle, StreamedTexture& texture, uint32_t firstMip)
+	{
+		check(!texture.Loading && firstMip > texture.ResidentMip);
+		// Lower levels are already in gpu memory, nothing to read from disk.
+		m_committedSize = m_committedSize - GetResidentSize(texture, texture.TargetMip) + GetResidentSize(texture, firstMip);
+		texture.TargetMip = firstMip;
+		io::TextureRaw noLevels;
+		noLevels.MipLevels = 0;
+		const Texture newTexture = CreateTexture(renderContext, texture, firstMip, noLevels);
+		SetResident(handle, texture, newTexture, firstMip);
+		++m_stats.Evictions;
+	}
+
+	void TextureStreamer::ApplyLoads(const RenderContext& renderContext)
+	{
+		std::vector<LoadResult> results;
+		{
+			std::lock_guard<std::mutex> lock(m_resultMutex);
+			results.swap(m_results);
+		}
+
+		// Limit upload size per frame to avoid stalls.
+		size_t uploadSize = 0;
+		size_t index = 0;
+		for (; index < results.size() && uploadSize < globals::TextureStreamingUploadSizePerFrame; ++index)
+		{
+			LoadResult& result = results[index];
+			--m_stats.PendingLoads;
+			auto it = m_textures.find(result.Handle);
+			if (it == m_textures.end())
+			{
+				// Unregistered while loading.
+				if (result.Success)
+					io::FreeTexture(result.Data.Pixels);
+				continue;
+			}
+			StreamedTexture& texture = it->second;
+			texture.Loading = false;
+			if (!result.Success || result.FirstMip + result.Data.MipLevels != texture.ResidentMip)
+			{
+				Logf(LogLevel::Error, "Texture streaming failed to load %s (mip %u).\n", texture.Path.c_str(), result.FirstMip);
+				if (result.Success)
+					io::FreeTexture(result.Data.Pixels);
+				m_committedSize = m_committedSize - GetResidentSize(texture, texture.TargetMip) + GetResidentSize(texture, texture.ResidentMip);
+				texture.TargetMip = texture.ResidentMip;
+				texture.Failed = true;
+				continue;
+			}
+
+			const Texture newTexture = CreateTexture(renderContext, texture, result.FirstMip, result.Data);
+			io::FreeTexture(result.Data.Pixels);
+			uploadSize += GetResidentSize(texture, result.FirstMip) - GetResidentSize(texture, texture.ResidentMip);
+			++m_stats.Uploads;
+			SetResident(result.Handle, texture, newTexture, result.FirstMip);
+		}
+
+		if (index < results.size())
+		{
+			std::lock_guard<std::mutex> lock(m_resultMutex);
+			m_results.insert(m_results.begin(), results.begin() + index, results.end());
+		}
+	}
+
+	void TextureStreamer::UpdateBindings(const RenderContext& renderContext, uint32_t frameIndex)
+	{
+		const uint32_t frameBit = 1 << frameIndex;
+		for (auto& it : m_textures)
+		{
+			StreamedTexture& texture = it.second;
+			if (!(texture.PendingFrameMask & frameBit))
+				continue;
+			for (const Binding& b : texture.Bindings)
+				texture.Current.Bind(renderContext, b.Sets[frameIndex], b.Sampler, b.Binding, b.ArrayIndex);
+			texture.PendingFrameMask &= ~frameBit;
+		}
+	}
+
+	void TextureStreamer::UpdateResidency(const RenderContext& renderContext)
+	{
+		std::vector<RenderHandle> upgrades;
+		std::vector<RenderHandle> evictions;
+		m_stats.ResidentSize = 0;
+		m_stats.TextureCount = (uint32_t)m_textures.size();
+		for (auto& it : m_textures)
+		{
+			StreamedTexture& texture = it.second;
+			m_stats.ResidentSize += GetResidentSize(texture, texture.ResidentMip);
+			// Not requested textures go back to the lowest levels.
+			texture.WantedMip = texture.RequestedMip;
+			texture.RequestedMip = texture.MinResidentMip;
+			if (texture.Loading || texture.Failed)
+				continue;
+			if (texture.WantedMip < texture.ResidentMip)
+				upgrades.push_back(it.first);
+			else if (texture.WantedMip > texture.ResidentMip)
+				evictions.push_back(it.first);
+		}
+
+		// Most needed upgrades first, textures with more unneeded levels are evicted first.
+		std::sort(upgrades.begin(), upgrades.end(), [this](RenderHandle a, RenderHandle b)
+			{
+				const StreamedTexture& ta = m_textures.at(a);
+				const StreamedTexture& tb = m_textures.at(b);
+				return ta.ResidentMip - ta.WantedMip > tb.ResidentMip - tb.WantedMip;
+			});
+		std::sort(evictions.begin(), evictions.end(), [this](RenderHandle a, RenderHandle b)
+			{
+				const StreamedTexture& ta = m_textures.at(a);
+				const StreamedTexture& tb = m_textures.at(b);
+				return ta.WantedMip - ta.ResidentMip > tb.WantedMip - tb.ResidentMip;
+			});
+
+		size_t evictionIndex = 0;
+		for (RenderHandle handle : upgrades)
+		{
+			if (m_stats.PendingLoads >= globals::TextureStreamingMaxPendingLoads)
+				break;
+			StreamedTexture& texture = m_textures.at(handle);
+			// One level per load so resolution improves progressively.
+			const uint32_t firstMip = texture.ResidentMip - 1;
+			const size_t extraSize = GetResidentSize(texture, firstMip) - GetResidentSize(texture, texture.ResidentMip);
+			// Evictions are gpu copies recorded right away, they don't take a load slot.
+			while (m_committedSize + extraSize > m_budget && evictionIndex < evictions.size())
+			{
+				RenderHandle evictedHandle = evictions[evictionIndex++];
+				StreamedTexture& evicted = m_textures.at(evictedHandle);
+				Evict(renderContext, evictedHandle, evicted, evicted.WantedMip);
+			}
+			if (m_committedSize + extraSize > m_budget)
+				continue;
+			ScheduleLoad(handle, texture, firstMip);
+		}
+	}
+
+	void TextureStreamer::ImGuiDraw()
+	{
+		ImGui::Begin("Texture streaming");
+		ImGui::Text("Textures:      %u", m_stats.TextureCount);
+		ImGui::Text("Resident:      %.2f MB", (double)m_stats.ResidentSize / (1024.0 * 1024.0));
+		ImGui::Text("Committed:     %.2f MB", (double)m_committedSize / (1024.0 * 1024.0));
+		ImGui::Text("Budget:        %.2f MB", (double)m_budget / (1024.0 * 1024.0));
+		ImGui::Text("Pending loads: %u", m_stats.PendingLoads);
+		ImGui::Text("Uploads:       %u", m_stats.Uploads);
+		ImGui::Text("Evictions:     %u", m_stats.Evictions);
+		ImGui::End();
+	}
+}
@@ -0,0 +1,155 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include "RenderHandle.h"
+#include "Texture.h"
+#include "TextureCompressor.h"
+#include "Globals.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+
+namespace vkmmc
+{
+	class WorkerPool;
+	class TextureCache;
+
+	/**
+	 * Keep resident only the mip levels that the scene needs.
+	 * Textures are registered with their low resolution mips, higher levels are loaded from disk in worker threads
+	 * when requested. Textures are moved to lower mips when the memory budget is exceeded.
+	 * Each residency change creates a new image: only the new levels are read from disk, resident ones are copied
+	 * from the previous image. Copies are recorded at the start of the frame command buffer and staging memory is
+	 * released with the frame fence. Material descriptors are updated per frame slot once the frame slot is not in use.
+	 */
+	class TextureStreamer
+	{
+		struct Binding
+		{
+			VkDescriptorSet Sets[globals::MaxOverlappedFrames];
+			VkSampler Sampler;
+			uint32_t Binding;
+			uint32_t ArrayIndex;
+		};
+
+		struct StreamedTexture
+		{
+			// Levels are read from here, a container or an image whose levels are generated.
+			std::string Path;
+			io::TextureRaw Desc; // Full resolution description without pixels.
+			Texture Current;
+			// First level in gpu memory. Greater values mean lower resolution.
+			uint32_t ResidentMip;
+			// Lowest resolution level, always resident.
+			uint32_t MinResidentMip;
+			// Highest resolution level requested in the current frame and in the last updated one.
+			uint32_t RequestedMip;
+			uint32_t WantedMip;
+			// Level that will be resident when the pending load is done.
+			uint32_t TargetMip;
+			bool Loading = false;
+			// Streaming disabled after a failed load.
+			bool Failed = false;
+			// Frame slots with descriptors pointing to the previous image.
+			uint32_t PendingFrameMask = 0;
+			std::vector<Binding> Bindings;
+		};
+
+		struct LoadResult
+		{
+			RenderHandle Handle;
+			uint32_t FirstMip;
+			io::TextureRaw Data;
+			bool Success;
+		};
+
+		struct RetiredTexture
+		{
+			vkmmc::Texture Texture;
+			uint32_t Frame;
+		};
+
+		struct RetiredBuffer
+		{
+			AllocatedBuffer Buffer;
+			uint32_t Frame;
+		};
+
+		// Content of a new image, recorded in the next frame command buffer.
+		struct PendingUpload
+		{
+			Texture Destination;
+			// First levels of destination, tightly packed. Not allocated when every level comes from previous.
+			AllocatedBuffer Staging;
+			uint32_t UploadLevels;
+			// Remaining levels of destination copied from previous.
+			Texture Previous;
+			uint32_t PreviousFirstMip;
+		};
+
+	public:
+		struct Stats
+		{
+			uint32_t TextureCount = 0;
+			uint32_t PendingLoads = 0;
+			size_t ResidentSize = 0;
+			uint32_t Uploads = 0;
+			uint32_t Evictions = 0;
+		};
+
+		void Init(WorkerPool* workerPool, TextureCache* cache, size_t budget = globals::TextureStreamingBudget);
+		void Destroy(const RenderContext& renderContext);
+
+		// Create a texture with the lowest levels of the texture in path and start tracking it. desc comes from
+		// io::LoadTextureInfo, only the lowest levels are read. Their upload is recorded with the next frame.
+		bool Register(const RenderContext& renderContext, RenderHandle handle, const char* path, const io::TextureRaw& desc, Texture& texture);
+		// Stop tracking. Current texture is owned by the texture cache.
+		void Unregister(RenderHandle handle);
+		bool IsStreamed(RenderHandle handle) const { return m_textures.contains(handle); }
+
+		// Descriptors (one per frame slot) to update when the texture changes its resident levels.
+		void AddBinding(RenderHandle handle, const VkDescriptorSet* sets, VkSampler sampler, uint32_t binding, uint32_t arrayIndex);
+		void RemoveBindings(VkDescriptorSet set);
+
+		// texelRatio: texels per screen pixel that a texture of size 1 would have. Mip is computed with the size of the texture.
+		void Request(RenderHandle handle, float texelRatio);
+
+		// Call at the beginning of the frame, once the frame slot is not in use by the gpu.
+		void Update(const RenderContext& renderContext, uint32_t frameIndex);
+		// Record the uploads and copies of the images created since the last call. Before any pass of the frame.
+		void RecordUploads(VkCommandBuffer cmd);
+
+		void SetBudget(size_t budget) { m_budget = budget; }
+		size_t GetBudget() const { return m_budget; }
+		const Stats& GetStats() const { return m_stats; }
+		void ImGuiDraw();
+
+	private:
+		size_t GetResidentSize(const StreamedTexture& texture, uint32_t firstMip) const;
+		// Image and staging buffer for the levels from firstMip, upload recorded with the next frame.
+		Texture CreateTexture(const RenderContext& renderContext, const StreamedTexture& texture, uint32_t firstMip, const io::TextureRaw& levels);
+		void SetResident(RenderHandle handle, StreamedTexture& texture, const Texture& newTexture, uint32_t firstMip);
+		void ScheduleLoad(RenderHandle handle, StreamedTexture& texture, uint32_t firstMip);
+		void Evict(const RenderContext& renderContext, RenderHandle handle, StreamedTexture& texture, uint32_t firstMip);
+		void ApplyLoads(const RenderContext& renderContext);
+		void UpdateBindings(const RenderContext& renderContext, uint32_t frameIndex);
+		void UpdateResidency(const RenderContext& renderContext);
+
+		WorkerPool* m_workerPool = nullptr;
+		TextureCache* m_cache = nullptr;
+		std::unordered_map<RenderHandle, StreamedTexture, RenderHandle::Hasher> m_textures;
+		std::vector<RetiredTexture> m_retired;
+		std::vector<RetiredBuffer> m_retiredBuffers;
+		std::vector<PendingUpload> m_uploads;
+		std::mutex m_resultMutex;
+		std::vector<LoadResult> m_results;
+		size_t m_budget = 0;
+		// Sum of the texture sizes once pending loads are done.
+		size_t m_committedSize = 0;
+		uint32_t m_frame = 0;
+		Stats m_stats;
+	};
+}
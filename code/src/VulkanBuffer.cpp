@@ -219,75 +219,173 @@ namespace vkmmc
 	{
 		check(m_buffer.IsAllocated());
 		Memory::DestroyBuffer(renderContext.Allocator, m_buffer);
-		m_infoMap.clear();
+		m_items.clear();
 	}
 
-	uint32_t UniformBuffer::AllocUniform(const RenderContext& renderContext, const char* name, uint32_t size)
+	const UniformBuffer::Item* UniformBuffer::FindItem(UniformId id) const
+	{
+		for (const Item& item : m_items)
+		{
+			if (item.Hash == id.Hash)
+				return &item;
+		}
+		return nullptr;
+	}
+
+	uint32_t UniformBuffer::AllocUniform(const RenderContext& renderContext, UniformId id, uint32_t size)
 	{
 		check(m_buffer.IsAllocated());
 		check(m_maxMemoryAllocated > 0 && size > 0);
-		check(name && *name);
+		check(id.Name && *id.Name);
 		check(m_freeMemoryOffset < m_maxMemoryAllocated);
-		if (!m_infoMap.contains(name))
+		if (const Item* item = FindItem(id))
 		{
-			ItemMapInfo info;
-			info.Size = size;
-			info.Offset = m_freeMemoryOffset;
-			m_infoMap[name] = info;
-			m_freeMemoryOffset += Memory::PadOffsetAlignment((uint32_t)renderContext.GPUProperties.limits.minUniformBufferOffsetAlignment, size);
-			return info.Offset;
+			check(!strcmp(item->Name, id.Name) && "Uniform id hash collision.");
+			return UINT32_MAX;
 		}
-		return UINT32_MAX;
+		Item item{ .Hash = id.Hash, .Name = id.Name, .Info = { .Size = size, .Offset = m_freeMemoryOffset } };
+		m_items.push_back(item);
+		m_freeMemoryOffset += Memory::PadOffsetAlignment((uint32_t)renderContext.GPUProperties.limits.minUniformBufferOffsetAlignment, size);
+		return item.Info.Offset;
 	}
 
-	void UniformBuffer::DestroyUniform(const char* name)
+	void UniformBuffer::DestroyUniform(UniformId id)
 	{
-		if (m_infoMap.contains(name))
-		{
-			m_infoMap.erase(name);
-		}
+		if (const Item* item = FindItem(id))
+			m_items.erase(m_items.begin() + (item - m_items.data()));
 	}
 
-	bool UniformBuffer::SetUniform(const RenderContext& renderContext, const char* name, const void* source, uint32_t size, uint32_t dstOffset)
+	bool UniformBuffer::SetUniform(const RenderContext& renderContext, UniformId id, const void* source, uint32_t size, uint32_t dstOffset)
 	{
-		if (m_infoMap.contains(name))
+		if (const Item* item = FindItem(id))
 		{
-			const ItemMapInfo& info = m_infoMap[name];
-			check(size <= dstOffset + info.Size);
-			Memory::MemCopy(renderContext.Allocator, m_buffer, source, size, dstOffset + info.Offset);
+			check(size <= dstOffset + item->Info.Size);
+			Memory::MemCopy(renderContext.Allocator, m_buffer, source, size, dstOffset + item->Info.Offset);
 			return true;
 		}
 		return false;
 	}
 
-	UniformBuffer::ItemMapInfo UniformBuffer::GetLocationInfo(const char* name) const
+	UniformBuffer::ItemMapInfo UniformBuffer::GetLocationInfo(UniformId id) const
 	{
-		if (m_infoMap.contains(name))
-			return m_infoMap.at(name);
-		return ItemMapInfo();
+		const Item* item = FindItem(id);
+		return item ? item->Info : ItemMapInfo();
 	}
 
-	VkDescriptorBufferInfo UniformBuffer::GenerateDescriptorBufferInfo(const char* name) const
+	VkDescriptorBufferInfo UniformBuffer::GenerateDescriptorBufferInfo(UniformId id) const
 	{
-		check(m_infoMap.contains(name) && m_buffer.IsAllocated());
+		const Item* item = FindItem(id);
+		check(item && m_buffer.IsAllocated());
 		VkDescriptorBufferInfo descInfo;
-		ItemMapInfo locationInfo = GetLocationInfo(name);
 		descInfo.buffer = GetBuffer();
-		descInfo.offset = locationInfo.Offset;
-		descInfo.range = locationInfo.Size;
+		descInfo.offset = item->Info.Offset;
+		descInfo.range = item->Info.Size;
 		return descInfo;
 	}
 
-	VkDescriptorBufferInfo UniformBuffer::GenerateDescriptorBufferDynamicInfo(const char* name, uint32_t size) const
+	VkDescriptorBufferInfo UniformBuffer::GenerateDescriptorBufferDynamicInfo(UniformId id, uint32_t size) const
 	{
-		check(m_infoMap.contains(name) && m_buffer.IsAllocated());
+		const Item* item = FindItem(id);
+		check(item && m_buffer.IsAllocated());
 		VkDescriptorBufferInfo descInfo;
-		ItemMapInfo locationInfo = GetLocationInfo(name);
 		descInfo.buffer = GetBuffer();
-		descInfo.offset = locationInfo.Offset;
-		check(size > 0 && size <= locationInfo.Size);
-		descInfo.range = locationInfo.Size;
+		descInfo.offset = item->Info.Offset;
+		check(size > 0 && size <= item->Info.Size);
+		descInfo.range = item->Info.Size;
 		return descInfo;
 	}
 
-}
\ No newline at end of file
+	void TransientBuffer::Init(const RenderContext& renderContext, uint32_t bufferSize)
+	{
+		check(!m_buffer.IsAllocated() && bufferSize > 0);
+		const VkPhysicalDeviceLimits& limits = renderContext.GPUProperties.limits;
+		m_defaultAlignment = (uint32_t)__max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+		m_size = Memory::PadOffsetAlignment(m_defaultAlignment, bufferSize);
+		VkBufferUsageFlags usageFlags = vkutils::GetVulkanBufferUsage(BUFFER_USAGE_UNIFORM | BUFFER_USAGE_STORAGE | BUFFER_USAGE_VERTEX | BUFFER_USAGE_INDEX);
+		m_buffer = Memory::CreateBuffer(renderContext.Allocator, m_size, usageFlags, MEMORY_USAGE_CPU_TO_GPU);
+		check(m_buffer.Mapped);
+		m_head = m_tail = m_frameBegin = 0;
+	}
+
+	void TransientBuffer::Destroy(const RenderContext& renderContext)
+	{
+		check(m_buffer.IsAllocated());
+		Logf(LogLevel::Info, "Transient buffer: %.2f KB used at most of %.2f KB.\n", (double)m_maxUsedSize / 1024.0, (double)m_size / 1024.0);
+		Memory::DestroyBuffer(renderContext.Allocator, m_buffer);
+		m_buffer = AllocatedBuffer();
+	}
+
+	void TransientBuffer::BeginFrame(uint32_t frameIndex)
+	{
+		check(frameIndex < globals::MaxOverlappedFrames);
+		// Frames finish in order, everything allocated up to the end of this slot is free.
+		m_tail = __max(m_tail, m_frameEnds[frameIndex]);
+		m_frameIndex = frameIndex;
+		m_frameBegin = m_head;
+		m_frameEnds[frameIndex] = m_head;
+	}
+
+	void TransientBuffer::Flush(const RenderContext& renderContext)
+	{
+		if (m_head == m_frameBegin)
+			return;
+		const uint64_t begin = m_frameBegin % m_size;
+		const uint64_t end = (m_head - 1) % m_size + 1;
+		if (begin < end)
+			Memory::Flush(renderContext.Allocator, m_buffer, begin, end - begin);
+		else
+		{
+			// Frame data wraps around the end of the buffer.
+			Memory::Flush(renderContext.Allocator, m_buffer, begin, m_size - begin);
+			Memory::Flush(renderContext.Allocator, m_buffer, 0, end);
+		}
+	}
+
+	TransientBuffer::Allocation TransientBuffer::Allocate(uint32_t size, uint32_t alignment)
+	{
+		check(m_buffer.IsAllocated() && size > 0 && size <= m_size);
+		if (!alignment)
+			alignment = m_defaultAlignment;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint64_t position = (m_head + alignment - 1) / alignment * alignment;
+		// Allocations are contiguous, skip the end of the buffer if it does not fit.
+		if (position % m_size + size > m_size)
+			position = (position / m_size + 1) * m_size;
+		if (position + size - m_tail > m_size)
+		{
+			Logf(LogLevel::Error, "Transient buffer overflow allocating %u bytes. Increase globals::TransientBufferSize (Current: %u)\n", size, m_size);
+			return Allocation();
+		}
+		m_head = position + size;
+		m_frameEnds[m_frameIndex] = m_head;
+		m_maxUsedSize = __max(m_maxUsedSize, m_head - m_tail);
+
+		Allocation allocation;
+		allocation.Offset = (uint32_t)(position % m_size);
+		allocation.Data = static_cast<char*>(m_buffer.Mapped) + allocation.Offset;
+		allocation.Buffer = m_buffer.Buffer;
+		return allocation;
+	}
+
+	TransientBuffer::Allocation TransientBuffer::Push(const void* data, uint32_t size, uint32_t alignment)
+	{
+		check(data);
+		Allocation allocation = Allocate(size, alignment);
+		if (allocation.Data)
+		{
+			memcpy_s(allocation.Data, size, data, size);
+			GRenderStats.UploadBytes += size;
+		}
+		return allocation;
+	}
+
+	VkDescriptorBufferInfo TransientBuffer::GenerateDescriptorBufferDynamicInfo(uint32_t range) const
+	{
+		check(m_buffer.IsAllocated() && range > 0 && range <= m_size);
+		VkDescriptorBufferInfo descInfo;
+		descInfo.buffer = GetBuffer();
+		descInfo.offset = 0;
+		descInfo.range = range;
+		return descInfo;
+	}
+}
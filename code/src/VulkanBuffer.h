@@ -3,9 +3,12 @@
 #pragma once
 
 #include <vulkan/vulkan.h>
+#include <cstddef>
 #include <vector>
 #include <functional>
+#include <mutex>
 #include "RenderTypes.h"
+#include "Globals.h"
 
 namespace vkmmc
 {
@@ -86,6 +89,30 @@ namespace vkmmc
 		void Bind(VkCommandBuffer cmd) const;
 	};
 
+	/**
+	 * Uniform name hashed at compile time (FNV-1a). Built from string literals like UNIFORM_ID_CAMERA,
+	 * so uniform lookups do not build strings nor hash at runtime.
+	 */
+	struct UniformId
+	{
+		uint32_t Hash;
+		const char* Name;
+
+		consteval UniformId(const char* name) : Hash(HashName(name)), Name(name) {}
+
+		static constexpr uint32_t HashName(const char* name)
+		{
+			uint32_t hash = 2166136261u;
+			for (; *name; ++name)
+				hash = (hash ^ (uint32_t)(uint8_t)*name) * 16777619u;
+			return hash;
+		}
+	};
+
+	// Compile time validation of C++ structs uploaded to std140 uniform blocks.
+#define STD140_CHECK_OFFSET(type, member, offset) static_assert(offsetof(type, member) == (offset), #type "::" #member " does not match std140 offset")
+#define STD140_CHECK_SIZE(type, size) static_assert(sizeof(type) == (size) && sizeof(type) % 16 == 0, #type " does not match std140 size")
+
 	class UniformBuffer
 	{
 	public:
@@ -98,18 +125,74 @@ namespace vkmmc
 		void Init(const RenderContext& renderContext, uint32_t bufferSize, EBufferUsageBits usage);
 		void Destroy(const RenderContext& renderContext);
 
-		uint32_t AllocUniform(const RenderContext& renderContext, const char* name, uint32_t size);
-		void DestroyUniform(const char* name);
-		bool SetUniform(const RenderContext& renderContext, const char* name, const void* source, uint32_t size, uint32_t dstOffset = 0);
-		ItemMapInfo GetLocationInfo(const char* name) const;
+		uint32_t AllocUniform(const RenderContext& renderContext, UniformId id, uint32_t size);
+		void DestroyUniform(UniformId id);
+		bool SetUniform(const RenderContext& renderContext, UniformId id, const void* source, uint32_t size, uint32_t dstOffset = 0);
+		ItemMapInfo GetLocationInfo(UniformId id) const;
+		VkBuffer GetBuffer() const { return m_buffer.Buffer; }
+		VkDescriptorBufferInfo GenerateDescriptorBufferInfo(UniformId id) const;
+		VkDescriptorBufferInfo GenerateDescriptorBufferDynamicInfo(UniformId id, uint32_t size) const;
+
+	private:
+		struct Item
+		{
+			uint32_t Hash;
+			const char* Name;
+			ItemMapInfo Info;
+		};
+		const Item* FindItem(UniformId id) const;
+
+		// Just a few uniforms per buffer, linear search over hashes.
+		std::vector<Item> m_items;
+		uint32_t m_freeMemoryOffset{ 0 };
+		uint32_t m_maxMemoryAllocated{ 0 };
+		AllocatedBuffer m_buffer;
+	};
+
+	/**
+	 * Linear ring allocator for data written every frame (per draw constants, debug geometry...).
+	 * Memory is released when the fence of the frame that allocated it signals, so nothing is reserved at init.
+	 */
+	class TransientBuffer
+	{
+	public:
+		struct Allocation
+		{
+			// Persistently mapped memory to write the data. Null if the buffer is full.
+			void* Data{ nullptr };
+			// Offset in the buffer, to use as dynamic offset or bind offset.
+			uint32_t Offset{ 0 };
+			VkBuffer Buffer{ VK_NULL_HANDLE };
+		};
+
+		void Init(const RenderContext& renderContext, uint32_t bufferSize);
+		void Destroy(const RenderContext& renderContext);
+
+		// Frame slot fence has signaled, memory allocated the last time this slot was recorded is free.
+		void BeginFrame(uint32_t frameIndex);
+		// Make the writes of the current frame visible to the device. Call before submit.
+		void Flush(const RenderContext& renderContext);
+
+		// alignment 0 is valid for uniform and storage buffer offsets.
+		Allocation Allocate(uint32_t size, uint32_t alignment = 0);
+		Allocation Push(const void* data, uint32_t size, uint32_t alignment = 0);
+
 		VkBuffer GetBuffer() const { return m_buffer.Buffer; }
-		VkDescriptorBufferInfo GenerateDescriptorBufferInfo(const char* name) const;
-		VkDescriptorBufferInfo GenerateDescriptorBufferDynamicInfo(const char* name, uint32_t size) const;
+		// For dynamic uniform buffer bindings, offset is set when the descriptor set is bound.
+		VkDescriptorBufferInfo GenerateDescriptorBufferDynamicInfo(uint32_t range) const;
 
 	private:
-		std::unordered_map<std::string, ItemMapInfo> m_infoMap;
-		uint32_t m_freeMemoryOffset;
-		uint32_t m_maxMemoryAllocated;
 		AllocatedBuffer m_buffer;
+		uint32_t m_size{ 0 };
+		uint32_t m_defaultAlignment{ 0 };
+		// Positions increase monotonically, offset in buffer is position % m_size.
+		uint64_t m_head{ 0 };
+		uint64_t m_tail{ 0 };
+		uint64_t m_frameBegin{ 0 };
+		uint64_t m_frameEnds[globals::MaxOverlappedFrames]{};
+		uint32_t m_frameIndex{ 0 };
+		uint64_t m_maxUsedSize{ 0 };
+		// Renderers allocate from recording threads.
+		std::mutex m_mutex;
 	};
 }
\ No newline at end of file
@@ -50,7 +50,7 @@ namespace vkmmc_debug
 		return VK_FALSE;
 	}
 
-	void ImGuiDraw()
+	void ImGuiDraw(const vkmmc::Allocator* allocator, const vkmmc::GpuProfiler& gpuProfiler, const vkmmc::FrameMetricsRecorder& frameMetrics)
 	{
 		ImGuiWindowFlags flags = ImGuiWindowFlags_NoMove
 			| ImGuiWindowFlags_NoDecoration
@@ -61,14 +61,16 @@ namespace vkmmc_debug
 		ImGui::SetNextWindowBgAlpha(0.5f);
 		ImGui::SetNextWindowPos({ 0.f, 0.f });
 		ImGui::Begin("Render stats", nullptr, flags);
-		for (auto item : vkmmc::GRenderStats.Profiler.m_items)
+		for (const vkmmc::CpuProfiler::ZoneStats& stats : vkmmc::GCpuProfiler.GetFrameStats())
 		{
-			ImGui::Text("%s:\t%.4f ms", item.first.c_str(), item.second.m_elapsed);
+			if (stats.Calls && !stats.Zone->Counter)
+				ImGui::Text("%*s%s:\t%.4f ms", stats.Depth * 2, "", stats.Zone->Name, stats.Milliseconds);
 		}
+		gpuProfiler.ImGuiDraw();
 		ImGui::Separator();
-		ImGui::Text("Draw calls:	%u", vkmmc::GRenderStats.DrawCalls);
-		ImGui::Text("Triangles:		%u", vkmmc::GRenderStats.TrianglesCount);
-		ImGui::Text("Binding count: %u", vkmmc::GRenderStats.SetBindingCount);
+		frameMetrics.ImGuiDraw();
+		ImGui::Separator();
+		vkmmc::MemoryTelemetry::Gather(allocator).ImGuiDraw();
 		ImGui::End();
 		ImGui::PopStyleColor();
 	}
@@ -76,44 +78,6 @@ namespace vkmmc_debug
 
 namespace vkmmc
 {
-	vkmmc::RenderStats GRenderStats;
-
-	void ProfilingTimer::Start()
-	{
-		m_start = std::chrono::high_resolution_clock::now();
-	}
-
-	double ProfilingTimer::Stop()
-	{
-		auto stop = std::chrono::high_resolution_clock::now();
-		auto diff = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - m_start);
-		double s = (double)diff.count() * 1e-6;
-		return s;
-	}
-
-	ScopedTimer::ScopedTimer(const char* nameId, Profiler* profiler)
-		: m_nameId(nameId), m_profiler(profiler)
-	{
-		m_timer.Start();
-	}
-
-	ScopedTimer::~ScopedTimer()
-	{
-		double elapsed = m_timer.Stop();
-		if (!m_profiler->m_items.contains(m_nameId))
-			m_profiler->m_items[m_nameId] = ProfilerItem{ 0.0 };
-		m_profiler->m_items[m_nameId].m_elapsed += elapsed;
-	}
-
-	void RenderStats::Reset()
-	{
-		TrianglesCount = 0;
-		DrawCalls = 0;
-		SetBindingCount = 0;
-		for (auto& it : Profiler.m_items)
-			it.second.m_elapsed = 0.0;
-	}
-
 
 	RenderHandle GenerateRenderHandle()
 	{
@@ -148,16 +112,74 @@ namespace vkmmc
 #endif // _DEBUG
 
 		Log(LogLevel::Info, "Initialize render engine.\n");
-		SDL_Init(SDL_INIT_VIDEO);
-		m_window = Window::Create(spec.WindowWidth, spec.WindowHeight, spec.WindowTitle);
+		m_headless = spec.Headless;
+		if (!m_headless)
+		{
+			SDL_Init(SDL_INIT_VIDEO);
+			m_window = Window::Create(spec.WindowWidth, spec.WindowHeight, spec.WindowTitle);
+			Log(LogLevel::Ok, "Window created successfully!\n");
+		}
+		else
+		{
+			// Only the size, renderers take the viewport from the window.
+			m_window.Width = spec.WindowWidth;
+			m_window.Height = spec.WindowHeight;
+			strcpy_s(m_window.Title, spec.WindowTitle);
+			Logf(LogLevel::Info, "Headless mode, rendering offscreen at %ux%u.\n", m_window.Width, m_window.Height);
+		}
 		m_renderContext.Window = &m_window;
-		Log(LogLevel::Ok, "Window created successfully!\n");
 		
+		// Worker threads for async engine tasks (texture compression...)
+		m_workerPool.Init();
+		m_shutdownStack.Add(
+			[this]()
+			{
+				m_workerPool.Destroy();
+			}
+		);
+
 		// Init vulkan context
 		check(InitVulkan());
+		m_renderContext.SamplerCache = &m_samplerCache;
+		m_shutdownStack.Add(
+			[this]()
+			{
+				m_samplerCache.Destroy(m_renderContext);
+				m_renderContext.SamplerCache = nullptr;
+			}
+		);
+		m_shutdownStack.Add(
+			[this]()
+			{
+				m_textureCache.Destroy(m_renderContext);
+			}
+		);
+		m_textureStreamer.Init(&m_workerPool, &m_textureCache);
+		m_shutdownStack.Add(
+			[this]()
+			{
+				m_textureStreamer.Destroy(m_renderContext);
+			}
+		);
+		// Bindless materials when descriptor indexing is available, descriptor set per material otherwise.
+		if (globals::EnableBindlessTextures && BindlessMaterialTable::IsSupported(m_renderContext))
+		{
+			m_bindlessTable.Init(m_renderContext, &m_textureCache, &m_textureStreamer);
+			m_shutdownStack.Add(
+				[this]()
+				{
+					m_bindlessTable.Destroy(m_renderContext);
+				}
+			);
+			for (uint32_t i = 0; i < globals::MaxOverlappedFrames; ++i)
+				m_frameContextArray[i].BindlessSet = m_bindlessTable.GetSet(i);
+		}
 
-		// Swapchain
-		check(m_swapchain.Init(m_renderContext, { spec.WindowWidth, spec.WindowHeight }));
+		// Swapchain, offscreen images without presentation in headless mode.
+		if (m_headless)
+			check(m_swapchain.InitOffscreen(m_renderContext, { spec.WindowWidth, spec.WindowHeight }, globals::MaxOverlappedFrames));
+		else
+			check(m_swapchain.Init(m_renderContext, { spec.WindowWidth, spec.WindowHeight }));
 		m_shutdownStack.Add(
 			[this]()
 			{
@@ -191,33 +213,55 @@ namespace vkmmc
 			for (uint32_t j = 0; j < globals::MaxShadowMapAttachments; ++j)
 				rendererCreateInfo.ShadowMapAttachments[i].push_back(m_shadowMapAttachments[i].ImageViewArray[j]);
 		}
+		rendererCreateInfo.TransientBuffer = &m_transientBuffer;
+		rendererCreateInfo.PipelineQueue = &m_pipelineQueue;
 
+		rendererCreateInfo.BindlessLayout = m_bindlessTable.GetLayout();
 		rendererCreateInfo.ConstantRange = nullptr;
 		rendererCreateInfo.ConstantRangeCount = 0;
 
 		m_renderers[RENDER_PASS_SHADOW_MAP].push_back(new ShadowMapRenderer());
 		m_renderers[RENDER_PASS_LIGHTING].push_back(new LightingRenderer());
 		m_renderers[RENDER_PASS_LIGHTING].push_back(new DebugRenderer());
-		m_renderers[RENDER_PASS_LIGHTING].push_back(new UIRenderer());
+		if (!m_headless)
+			m_renderers[RENDER_PASS_LIGHTING].push_back(new UIRenderer());
 		for (uint32_t i = 0; i < RENDER_PASS_COUNT; i++)
 		{
 			for (IRendererBase* renderer : m_renderers[i])
 				renderer->Init(rendererCreateInfo);
 		}
-
-		AddImGuiCallback(&vkmmc_debug::ImGuiDraw);
+		// Pipelines registered by the renderers, compiled in the worker threads.
+		if (globals::EnableShaderHotReload)
+			m_pipelineHotReload.Init(m_renderContext, globals::ShaderHotReloadPollMs);
+		m_pipelineQueue.Flush(m_renderContext, m_workerPool, globals::EnableShaderHotReload ? &m_pipelineHotReload : nullptr);
+		m_frameMetrics.Init(spec.FrameStatsHistory ? spec.FrameStatsHistory : globals::FrameMetricsHistory,
+			spec.FrameMetricsFile ? spec.FrameMetricsFile : globals::FrameMetricsFile);
+
+		AddImGuiCallback([this]() { vkmmc_debug::ImGuiDraw(m_renderContext.Allocator, m_gpuProfiler, m_frameMetrics); });
 		AddImGuiCallback([this]() { ImGuiDraw(); });
 		AddImGuiCallback([this]() { if (m_scene) m_scene->ImGuiDraw(true); });
+		if (globals::EnableTextureStreaming)
+			AddImGuiCallback([this]() { m_textureStreamer.ImGuiDraw(); });
 
 		return true;
 	}
 
 	bool VulkanRenderEngine::RenderProcess()
 	{
+		GCpuProfiler.NewFrame();
 		PROFILE_SCOPE(Process);
+		// Close the stats of the frame that just ended.
+		PROFILE_COUNTER(DrawCalls, GRenderStats.DrawCalls.load());
+		PROFILE_COUNTER(Triangles, GRenderStats.TrianglesCount.load());
+		PROFILE_COUNTER(SetBindings, GRenderStats.SetBindingCount.load());
+		PROFILE_COUNTER(BufferBinds, GRenderStats.BufferBindCount.load());
+		PROFILE_COUNTER(UploadBytes, GRenderStats.UploadBytes.load());
+		if (m_frameCounter)
+			m_frameMetrics.Record(m_frameCounter - 1, m_gpuProfiler, m_renderContext.Allocator);
+		GRenderStats.Reset();
 		bool res = true;
 		SDL_Event e;
-		while (SDL_PollEvent(&e))
+		while (!m_headless && SDL_PollEvent(&e))
 		{
 			ImGui_ImplSDL2_ProcessEvent(&e);
 			switch (e.type)
@@ -229,9 +273,12 @@ namespace vkmmc
 		}
 
 		BeginFrame();
-		for (auto& fn : m_imguiCallbackArray)
-			fn();
-		GRenderStats.Reset();
+		// No ImGui context without window.
+		if (!m_headless)
+		{
+			for (auto& fn : m_imguiCallbackArray)
+				fn();
+		}
 		Draw();
 		return res;
 	}
@@ -242,6 +289,15 @@ namespace vkmmc
 
 		for (size_t i = 0; i < globals::MaxOverlappedFrames; ++i)
 			WaitFence(m_frameContextArray[i].RenderFence);
+		// Stop rebuilding before the renderers release the pipelines and layouts.
+		m_pipelineHotReload.Destroy(m_renderContext);
+
+		// Dump before releasing resources, capacity planning wants the memory of a loaded scene.
+		if (globals::MemoryTelemetryFile)
+			GetMemoryTelemetry().WriteJson(globals::MemoryTelemetryFile);
+		// Every pipeline is created by now, next runs skip driver compilation.
+		m_pipelineCache.Save(m_renderContext);
+		m_frameMetrics.Destroy();
 
 		if (m_scene)
 			IScene::DestroyScene(m_scene);
@@ -257,11 +313,13 @@ namespace vkmmc
 
 		m_shutdownStack.Flush();
 		vkDestroyDevice(m_renderContext.Device, nullptr);
-		vkDestroySurfaceKHR(m_renderContext.Instance, m_renderContext.Surface, nullptr);
+		if (m_renderContext.Surface != VK_NULL_HANDLE)
+			vkDestroySurfaceKHR(m_renderContext.Instance, m_renderContext.Surface, nullptr);
 		vkb::destroy_debug_utils_messenger(m_renderContext.Instance,
 			m_renderContext.DebugMessenger);
 		vkDestroyInstance(m_renderContext.Instance, nullptr);
-		SDL_DestroyWindow(m_window.WindowInstance);
+		if (m_window.WindowInstance)
+			SDL_DestroyWindow(m_window.WindowInstance);
 
 		Log(LogLevel::Ok, "Render engine terminated.\n");
 		if (vkmmc_debug::GTerminatedWithErrors)
@@ -276,6 +334,16 @@ namespace vkmmc
 		m_cameraData.ViewProjection = m_cameraData.Projection * m_cameraData.View;
 	}
 
+	FrameStatsSummary VulkanRenderEngine::GetFrameStatsSummary() const
+	{
+		return m_frameMetrics.ComputeStatsSummary();
+	}
+
+	void VulkanRenderEngine::ResetFrameStats()
+	{
+		m_frameMetrics.Reset();
+	}
+
 	IScene* VulkanRenderEngine::GetScene()
 	{
 		return m_scene;
@@ -316,10 +384,25 @@ namespace vkmmc
 
 	void VulkanRenderEngine::BeginFrame()
 	{
-		// Update scene graph data
+		// Wait for the frame slot before writing any frame data.
 		RenderFrameContext& frameContext = GetFrameContext();
+		frameContext.Scene = static_cast<Scene*>(m_scene);
+		WaitFence(frameContext.RenderFence);
+		m_transientBuffer.BeginFrame(frameContext.FrameIndex);
+		m_frameDescriptorAllocator.BeginFrame(frameContext.FrameIndex);
+		m_frameCommandPool.BeginFrame(m_renderContext, frameContext.FrameIndex);
+		m_gpuProfiler.BeginFrame(m_renderContext, frameContext.FrameIndex, m_frameCounter);
+		// Pipelines rebuilt after a shader change, never waits for the compilation.
+		m_pipelineHotReload.BeginFrame(m_renderContext, m_frameCounter);
+
+		// Update scene graph data
 		glm::vec3 cameraPos = math::GetPos(glm::inverse(frameContext.CameraData->View));
 		frameContext.Scene->UpdateRenderData(m_renderContext, &frameContext.GlobalBuffer, cameraPos);
+		if (globals::EnableTextureStreaming)
+		{
+			const float projectionScale = frameContext.CameraData->Projection[1][1] * 0.5f * (float)m_window.Height;
+			frameContext.Scene->RequestTextureMips(m_textureStreamer, cameraPos, projectionScale);
+		}
 
 		// Renderers do your things...
 		for (uint32_t i = 0; i < RENDER_PASS_COUNT; i++)
@@ -333,8 +416,15 @@ namespace vkmmc
 	{
 		PROFILE_SCOPE(Draw);
 		RenderFrameContext& frameContext = GetFrameContext();
-		frameContext.Scene = static_cast<Scene*>(m_scene);
-		WaitFence(frameContext.RenderFence);
+
+		// Frame slot is free, swap streamed textures.
+		if (globals::EnableTextureStreaming)
+		{
+			PROFILE_SCOPE(TextureStreaming);
+			m_textureStreamer.Update(m_renderContext, frameContext.FrameIndex);
+		}
+		if (m_bindlessTable.IsInitialized())
+			m_bindlessTable.Update(m_renderContext, frameContext.FrameIndex);
 
 		{
 			PROFILE_SCOPE(UpdateBuffers);
@@ -343,11 +433,13 @@ namespace vkmmc
 		}
 
 		VkCommandBuffer cmd = frameContext.GraphicsCommand;
-		uint32_t swapchainImageIndex;
+		// Offscreen images belong to a frame slot, free once its fence has signaled.
+		uint32_t swapchainImageIndex = frameContext.FrameIndex;
 		{
 			PROFILE_SCOPE(PrepareFrame);
 			// Acquire render image from swapchain
-			vkcheck(vkAcquireNextImageKHR(m_renderContext.Device, m_swapchain.GetSwapchainHandle(), 1000000000, frameContext.PresentSemaphore, nullptr, &swapchainImageIndex));
+			if (!m_headless)
+				vkcheck(vkAcquireNextImageKHR(m_renderContext.Device, m_swapchain.GetSwapchainHandle(), 1000000000, frameContext.PresentSemaphore, nullptr, &swapchainImageIndex));
 
 			// Reset command buffer
 			vkcheck(vkResetCommandBuffer(frameContext.GraphicsCommand, 0));
@@ -360,35 +452,17 @@ namespace vkmmc
 			cmdBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 			// Begin command buffer
 			vkcheck(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
+			m_gpuProfiler.ResetQueries(cmd);
+			// Streamed levels are ready before any pass samples them.
+			if (globals::EnableTextureStreaming)
+				m_textureStreamer.RecordUploads(cmd);
 		}
 
-		{
-			uint32_t frameIndex = GetFrameIndex();
-			RenderPass& shadowMapPass = m_renderPassArray[RENDER_PASS_SHADOW_MAP];
-			uint32_t shadowCount = globals::MaxShadowMapAttachments; 
-			check(shadowCount <= (uint32_t)m_shadowMapAttachments[frameIndex].FramebufferArray.size());
-			for (uint32_t i = 0; i < shadowCount; ++i)
-			{
-				shadowMapPass.BeginPass(cmd, m_shadowMapAttachments[frameIndex].FramebufferArray[i]);
-				for (IRendererBase* it : m_renderers[RENDER_PASS_SHADOW_MAP])
-				{
-					it->RecordCmd(m_renderContext, frameContext, i);
-				}
-				shadowMapPass.EndPass(cmd);
-			}
-
-			RenderPass& colorPass = m_renderPassArray[RENDER_PASS_LIGHTING];
-			colorPass.BeginPass(cmd, m_swapchainAttachments[swapchainImageIndex].FramebufferArray[0]);
-			for (IRendererBase* it : m_renderers[RENDER_PASS_LIGHTING])
-			{
-				it->RecordCmd(m_renderContext, frameContext, 0);
-			}
-			colorPass.EndPass(cmd);
-		}
-
+		RecordPasses(cmd, swapchainImageIndex);
 
 		// Terminate command buffer
 		vkcheck(vkEndCommandBuffer(cmd));
+		m_transientBuffer.Flush(m_renderContext);
 
 		{
 			PROFILE_SCOPE(QueueSubmit);
@@ -398,11 +472,11 @@ namespace vkmmc
 			submitInfo.pNext = nullptr;
 			VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 			submitInfo.pWaitDstStageMask = &waitStage;
-			// Wait for last frame terminates present image
-			submitInfo.waitSemaphoreCount = 1;
+			// Wait for last frame terminates present image. Nothing to wait nor signal without presentation.
+			submitInfo.waitSemaphoreCount = m_headless ? 0 : 1;
 			submitInfo.pWaitSemaphores = &frameContext.PresentSemaphore;
 			// Make wait present process until this Queue has finished.
-			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.signalSemaphoreCount = m_headless ? 0 : 1;
 			submitInfo.pSignalSemaphores = &frameContext.RenderSemaphore;
 			// The command buffer will be procesed
 			submitInfo.commandBufferCount = 1;
@@ -410,6 +484,7 @@ namespace vkmmc
 			vkcheck(vkQueueSubmit(m_renderContext.GraphicsQueue, 1, &submitInfo, frameContext.RenderFence));
 		}
 
+		if (!m_headless)
 		{
 			PROFILE_SCOPE(Present);
 			// Present
@@ -424,10 +499,116 @@ namespace vkmmc
 			presentInfo.pImageIndices = &swapchainImageIndex;
 			vkcheck(vkQueuePresentKHR(m_renderContext.GraphicsQueue, &presentInfo));
 		}
+		// Next frame uses the next slot, its fence guards the data of the frame before.
+		++m_frameCounter;
+	}
+
+	void VulkanRenderEngine::RecordPasses(VkCommandBuffer cmd, uint32_t swapchainImageIndex)
+	{
+		PROFILE_SCOPE(RecordPasses);
+		struct PassRecord
+		{
+			ERenderPassType Type;
+			VkFramebuffer Framebuffer;
+			uint32_t FirstJob;
+			uint32_t JobCount;
+			uint32_t GpuScope;
+		};
+		struct JobRecord
+		{
+			IRendererBase* Renderer;
+			uint32_t PassIndex;
+			RecordJob Job;
+			// Renderer timestamps are written by its first and last jobs.
+			uint32_t BeginGpuScope;
+			uint32_t EndGpuScope;
+			uint32_t GpuStatisticsQuery;
+		};
+
+		// Jobs of every pass in submission order.
+		const RenderFrameContext& frameContext = GetFrameContext();
+		std::vector<PassRecord> passes;
+		std::vector<JobRecord> jobs;
+		auto addPass = [&](ERenderPassType type, VkFramebuffer framebuffer, uint32_t attachmentIndex, const char* name)
+			{
+				PassRecord pass{ .Type = type, .Framebuffer = framebuffer, .FirstJob = (uint32_t)jobs.size(), .JobCount = 0 };
+				pass.GpuScope = m_gpuProfiler.AddScope(name, 0);
+				for (IRendererBase* renderer : m_renderers[type])
+				{
+					const uint32_t jobCount = renderer->GetRecordJobCount(frameContext);
+					const uint32_t gpuScope = jobCount ? m_gpuProfiler.AddScope(renderer->GetName(), 1) : GpuProfiler::InvalidQuery;
+					for (uint32_t i = 0; i < jobCount; ++i)
+					{
+						RecordJob job{ .Cmd = VK_NULL_HANDLE, .AttachmentIndex = attachmentIndex, .Index = i, .Count = jobCount };
+						jobs.push_back({ .Renderer = renderer, .PassIndex = (uint32_t)passes.size(), .Job = job,
+							.BeginGpuScope = i == 0 ? gpuScope : GpuProfiler::InvalidQuery,
+							.EndGpuScope = i == jobCount - 1 ? gpuScope : GpuProfiler::InvalidQuery,
+							.GpuStatisticsQuery = m_gpuProfiler.AddStatisticsQuery(gpuScope) });
+					}
+				}
+				pass.JobCount = (uint32_t)jobs.size() - pass.FirstJob;
+				passes.push_back(pass);
+			};
+		const uint32_t frameIndex = frameContext.FrameIndex;
+		const uint32_t shadowCount = globals::MaxShadowMapAttachments;
+		check(shadowCount <= (uint32_t)m_shadowMapAttachments[frameIndex].FramebufferArray.size());
+		for (uint32_t i = 0; i < shadowCount; ++i)
+		{
+			char passName[32];
+			sprintf_s(passName, "ShadowMapPass %u", i);
+			addPass(RENDER_PASS_SHADOW_MAP, m_shadowMapAttachments[frameIndex].FramebufferArray[i], i, passName);
+		}
+		addPass(RENDER_PASS_LIGHTING, m_swapchainAttachments[swapchainImageIndex].FramebufferArray[0], 0, "LightingPass");
+
+		auto recordJob = [&](uint32_t jobIndex)
+			{
+				JobRecord& record = jobs[jobIndex];
+				const PassRecord& pass = passes[record.PassIndex];
+				DrawStats stats;
+				record.Job.Stats = &stats;
+				record.Job.Cmd = m_frameCommandPool.BeginSecondary(m_renderContext, m_renderPassArray[pass.Type].RenderPass, pass.Framebuffer);
+				m_gpuProfiler.WriteBeginTimestamp(record.Job.Cmd, record.BeginGpuScope);
+				m_gpuProfiler.BeginStatistics(record.Job.Cmd, record.GpuStatisticsQuery);
+				record.Renderer->RecordCmd(m_renderContext, frameContext, record.Job);
+				m_gpuProfiler.EndStatistics(record.Job.Cmd, record.GpuStatisticsQuery);
+				m_gpuProfiler.WriteEndTimestamp(record.Job.Cmd, record.EndGpuScope);
+				m_frameCommandPool.EndSecondary(record.Job.Cmd);
+				record.Job.Stats = nullptr;
+				GRenderStats.Add(stats);
+			};
+		if (globals::EnableParallelRecording)
+		{
+			m_workerPool.ParallelFor((uint32_t)jobs.size(), [&](uint32_t jobIndex)
+				{
+					if (jobs[jobIndex].Renderer->IsParallelRecordingSupported())
+						recordJob(jobIndex);
+				});
+		}
+		for (uint32_t i = 0; i < (uint32_t)jobs.size(); ++i)
+		{
+			if (!globals::EnableParallelRecording || !jobs[i].Renderer->IsParallelRecordingSupported())
+				recordJob(i);
+		}
+
+		// Execute in the primary command buffer in the same order the renderers were registered.
+		std::vector<VkCommandBuffer> commands(jobs.size());
+		for (uint32_t i = 0; i < (uint32_t)jobs.size(); ++i)
+			commands[i] = jobs[i].Job.Cmd;
+		for (const PassRecord& pass : passes)
+		{
+			const RenderPass& renderPass = m_renderPassArray[pass.Type];
+			m_gpuProfiler.WriteBeginTimestamp(cmd, pass.GpuScope);
+			renderPass.BeginPass(cmd, pass.Framebuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			if (pass.JobCount)
+				vkCmdExecuteCommands(cmd, pass.JobCount, &commands[pass.FirstJob]);
+			renderPass.EndPass(cmd);
+			m_gpuProfiler.WriteEndTimestamp(cmd, pass.GpuScope);
+		}
 	}
 
 	void VulkanRenderEngine::ImGuiDraw()
 	{
+		GCpuProfiler.ImGuiDraw();
 		for (uint32_t passIndex = 0; passIndex < RENDER_PASS_COUNT; ++passIndex)
 		{
 			for (uint32_t i = 0; i < (uint32_t)m_renderers[passIndex].size(); ++i)
@@ -441,6 +622,11 @@ namespace vkmmc
 		vkcheck(vkResetFences(m_renderContext.Device, 1, &fence));
 	}
 
+	MemoryTelemetry VulkanRenderEngine::GetMemoryTelemetry() const
+	{
+		return MemoryTelemetry::Gather(m_renderContext.Allocator);
+	}
+
 	RenderFrameContext& VulkanRenderEngine::GetFrameContext()
 	{
 		return m_frameContextArray[m_frameCounter % globals::MaxOverlappedFrames];
@@ -463,28 +649,78 @@ namespace vkmmc
 			.require_api_version(1, 1, 0)
 			//.use_default_debug_messenger()
 			.set_debug_callback(&vkmmc_debug::DebugVulkanCallback)
+			.set_headless(m_headless)
 			.build();
 		vkb::Instance instance = instanceReturn.value();
 		m_renderContext.Instance = instance.instance;
 		m_renderContext.DebugMessenger = instance.debug_messenger;
 
 		// Physical device
-		SDL_Vulkan_CreateSurface(m_window.WindowInstance, m_renderContext.Instance, &m_renderContext.Surface);
 		vkb::PhysicalDeviceSelector selector(instance);
-		vkb::PhysicalDevice physicalDevice = selector
-			.set_minimum_version(1, 1)
-			.set_surface(m_renderContext.Surface)
-			.select()
-			.value();
+		selector.set_minimum_version(1, 1)
+			.add_desired_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
+			.add_desired_extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+		// Headless accepts devices without presentation support (software rasterizers).
+		m_renderContext.Surface = VK_NULL_HANDLE;
+		if (m_headless)
+			selector.defer_surface_initialization();
+		else
+		{
+			SDL_Vulkan_CreateSurface(m_window.WindowInstance, m_renderContext.Instance, &m_renderContext.Surface);
+			selector.set_surface(m_renderContext.Surface);
+		}
+		vkb::PhysicalDevice physicalDevice = selector.select().value();
+		// Optional features, enabled just when available.
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(physicalDevice.physical_device, &supportedFeatures);
+		physicalDevice.features.samplerAnisotropy = supportedFeatures.samplerAnisotropy;
+		physicalDevice.features.textureCompressionBC = supportedFeatures.textureCompressionBC;
+		physicalDevice.features.shaderSampledImageArrayDynamicIndexing = supportedFeatures.shaderSampledImageArrayDynamicIndexing;
+		physicalDevice.features.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
 		vkb::DeviceBuilder deviceBuilder{ physicalDevice };
 		VkPhysicalDeviceShaderDrawParametersFeatures shaderDrawParamsFeatures = {};
 		shaderDrawParamsFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES;
 		shaderDrawParamsFeatures.pNext = nullptr;
 		shaderDrawParamsFeatures.shaderDrawParameters = VK_TRUE;
 		deviceBuilder.add_pNext(&shaderDrawParamsFeatures);
+		// Descriptor indexing for bindless materials.
+		VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+		indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+		bool descriptorIndexing = false;
+		if (globals::EnableBindlessTextures)
+		{
+			std::vector<std::string> extensions = physicalDevice.get_extensions();
+			if (std::find(extensions.begin(), extensions.end(), VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) != extensions.end())
+			{
+				VkPhysicalDeviceFeatures2 features2 = {};
+				features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+				features2.pNext = &indexingFeatures;
+				vkGetPhysicalDeviceFeatures2(physicalDevice.physical_device, &features2);
+				// Texture index is the same for the whole draw, dynamic indexing is enough.
+				descriptorIndexing = indexingFeatures.runtimeDescriptorArray
+					&& indexingFeatures.descriptorBindingPartiallyBound
+					&& supportedFeatures.shaderSampledImageArrayDynamicIndexing;
+			}
+			if (descriptorIndexing)
+			{
+				indexingFeatures = {};
+				indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+				indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+				indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+				deviceBuilder.add_pNext(&indexingFeatures);
+			}
+			else
+				Log(LogLevel::Warn, "Descriptor indexing not supported, bindless materials disabled.\n");
+		}
 		vkb::Device device = deviceBuilder.build().value();
 		m_renderContext.Device = device.device;
 		m_renderContext.GPUDevice = physicalDevice.physical_device;
+		m_renderContext.GPUFeatures = physicalDevice.features;
+		m_renderContext.DescriptorIndexing = descriptorIndexing;
+		std::vector<std::string> deviceExtensions = physicalDevice.get_extensions();
+		m_renderContext.MemoryBudget = std::find(deviceExtensions.begin(), deviceExtensions.end(), VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) != deviceExtensions.end();
+		if (!m_renderContext.MemoryBudget)
+			Log(LogLevel::Warn, "VK_EXT_memory_budget not supported, memory telemetry without heap budgets.\n");
 
 		// Graphics queue from device
 		m_renderContext.GraphicsQueue = device.get_queue(vkb::QueueType::graphics).value();
@@ -497,7 +733,7 @@ namespace vkmmc
 			deviceProperties.deviceName, deviceProperties.deviceID, deviceProperties.vendorID);
 
 		// Init memory allocator
-		Memory::Init(m_renderContext.Allocator, m_renderContext.Instance, m_renderContext.Device, m_renderContext.GPUDevice);
+		Memory::Init(m_renderContext.Allocator, m_renderContext.Instance, m_renderContext.Device, m_renderContext.GPUDevice, m_renderContext.MemoryBudget);
 		m_shutdownStack.Add([this]()
 			{
 				Memory::Destroy(m_renderContext.Allocator);
@@ -526,6 +762,19 @@ namespace vkmmc
 			);
 		}
 
+		// Secondary command buffers for the main thread and every worker thread.
+		m_frameCommandPool.Init(m_renderContext, m_workerPool.GetThreadCount() + 1);
+		m_shutdownStack.Add([this]()
+			{
+				m_frameCommandPool.Destroy(m_renderContext);
+			}
+		);
+		if (globals::EnableGpuProfiler)
+		{
+			m_gpuProfiler.Init(m_renderContext);
+			m_shutdownStack.Add([this]() { m_gpuProfiler.Destroy(m_renderContext); });
+		}
+
 		vkcheck(vkCreateCommandPool(m_renderContext.Device, &poolInfo, nullptr, &m_renderContext.TransferContext.CommandPool));
 		VkCommandBufferAllocateInfo allocInfo = vkinit::CommandBufferCreateAllocateInfo(m_renderContext.TransferContext.CommandPool, 1);
 		vkcheck(vkAllocateCommandBuffers(m_renderContext.Device, &allocInfo, &m_renderContext.TransferContext.CommandBuffer));
@@ -576,7 +825,7 @@ namespace vkmmc
 			dependencies[1].dependencyFlags = 0;
 
 			m_renderPassArray[RENDER_PASS_LIGHTING].RenderPass = RenderPassBuilder::Create()
-				.AddColorAttachmentDescription(m_swapchain.GetImageFormat(), true)
+				.AddColorAttachmentDescription(m_swapchain.GetImageFormat(), !m_headless)
 				.AddDepthAttachmentDescription(FORMAT_D32)
 				.AddSubpass(
 					{ 0 }, // Color attachments
@@ -737,19 +986,47 @@ namespace vkmmc
 
 	bool VulkanRenderEngine::InitPipeline()
 	{
+		// Driver pipeline cache, before any pipeline is created.
+		m_pipelineCache.Init(m_renderContext, globals::PipelineCacheFile);
+		m_renderContext.PipelineCache = m_pipelineCache.GetHandle();
+		m_shutdownStack.Add([this]()
+			{
+				m_renderContext.PipelineCache = VK_NULL_HANDLE;
+				m_pipelineCache.Destroy(m_renderContext);
+			});
+		m_shaderLibrary.Init(globals::ShaderCacheDirectory);
+		m_renderContext.ShaderLibrary = &m_shaderLibrary;
+		m_shutdownStack.Add([this]()
+			{
+				m_renderContext.ShaderLibrary = nullptr;
+				m_shaderLibrary.Destroy(m_renderContext);
+			});
+
 		// Pipeline descriptors
 		m_descriptorLayoutCache.Init(m_renderContext);
-		m_descriptorAllocator.Init(m_renderContext, DescriptorPoolSizes::GetDefault());
+		// Long lived sets (materials, frame globals) and per frame sets come from different pools.
+		m_descriptorAllocator.Init(m_renderContext, DescriptorPoolSizes::GetDefault(), &m_descriptorLayoutCache);
+		m_frameDescriptorAllocator.Init(m_renderContext, DescriptorPoolSizes::GetDefault(), &m_descriptorLayoutCache, m_workerPool.GetThreadCount() + 1);
 		m_shutdownStack.Add([this]() mutable
 			{
+				m_frameDescriptorAllocator.Destroy();
 				m_descriptorAllocator.Destroy();
 				m_descriptorLayoutCache.Destroy();
 			});
 
+		m_transientBuffer.Init(m_renderContext, globals::TransientBufferSize);
+		m_shutdownStack.Add([this]()
+			{
+				m_transientBuffer.Destroy(m_renderContext);
+			});
+
 		for (size_t i = 0; i < globals::MaxOverlappedFrames; ++i)
 		{
 			RenderFrameContext& frameContext = m_frameContextArray[i];
 			frameContext.CameraData = &m_cameraData;
+			frameContext.FrameIndex = (uint32_t)i;
+			frameContext.TransientBuffer = &m_transientBuffer;
+			frameContext.FrameDescriptorAllocator = &m_frameDescriptorAllocator;
 
 			// Size for uniform frame buffer
 			uint32_t size = 1024 * 1024; // 1MB
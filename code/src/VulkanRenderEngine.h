@@ -16,12 +16,27 @@
 #include "FunctionStack.h"
 #include "Framebuffer.h"
 #include "Scene.h"
+#include "WorkerPool.h"
+#include "TextureCache.h"
+#include "SamplerCache.h"
+#include "TextureStreamer.h"
+#include "BindlessMaterialTable.h"
+#include "MemoryTelemetry.h"
+#include "FrameCommandPool.h"
+#include "PipelineCache.h"
+#include "Shader.h"
+#include "PipelineHotReload.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "FrameMetrics.h"
 #include <cstdio>
 
 #include <SDL.h>
 #include <SDL_vulkan.h>
 #include <string.h>
 #include <chrono>
+#include <atomic>
+#include <mutex>
 #include "Globals.h"
 
 namespace vkmmc
@@ -30,45 +45,6 @@ namespace vkmmc
 	class IRendererBase;
 	struct ShaderModuleLoadDescription;
 
-	struct ProfilingTimer
-	{
-		std::chrono::high_resolution_clock::time_point m_start;
-
-		void Start();
-		double Stop();
-	};
-
-	struct ProfilerItem
-	{
-		double m_elapsed;
-	};
-
-	struct Profiler
-	{
-		std::unordered_map<std::string, ProfilerItem> m_items;
-	};
-
-	struct ScopedTimer
-	{
-		ScopedTimer(const char* nameId, Profiler* profiler);
-		~ScopedTimer();
-
-		std::string m_nameId;
-		Profiler* m_profiler;
-		ProfilingTimer m_timer;
-	};
-
-	struct RenderStats
-	{
-		Profiler Profiler;
-		uint32_t TrianglesCount{ 0 };
-		uint32_t DrawCalls{ 0 };
-		uint32_t SetBindingCount{ 0 };
-		void Reset();
-	};
-	extern RenderStats GRenderStats;
-#define PROFILE_SCOPE(name) vkmmc::ScopedTimer __timer##name(#name, &vkmmc::GRenderStats.Profiler)
-
 	struct Window
 	{
 		SDL_Window* WindowInstance;
@@ -90,6 +66,10 @@ namespace vkmmc
 		glm::mat4 Projection;
 		glm::mat4 ViewProjection;
 	};
+	// CameraBuffer uniform block in basic.vert
+	STD140_CHECK_OFFSET(CameraData, Projection, 64);
+	STD140_CHECK_OFFSET(CameraData, ViewProjection, 128);
+	STD140_CHECK_SIZE(CameraData, 192);
 
 	
 
@@ -122,15 +102,28 @@ namespace vkmmc
 
 		virtual RenderHandle GetDefaultTexture() const;
 		virtual Material GetDefaultMaterial() const;
+		virtual FrameStatsSummary GetFrameStatsSummary() const override;
+		virtual void ResetFrameStats() override;
 		const RenderContext& GetContext() const { return m_renderContext; }
 		VkDescriptorSet AllocateDescriptorSet(VkDescriptorSetLayout layout);
 		inline DescriptorLayoutCache& GetDescriptorSetLayoutCache() { return m_descriptorLayoutCache; }
 		inline DescriptorAllocator& GetDescriptorAllocator() { return m_descriptorAllocator; }
+		inline FrameDescriptorAllocator& GetFrameDescriptorAllocator() { return m_frameDescriptorAllocator; }
+		inline WorkerPool& GetWorkerPool() { return m_workerPool; }
+		inline TextureCache& GetTextureCache() { return m_textureCache; }
+		inline TextureStreamer& GetTextureStreamer() { return m_textureStreamer; }
+		inline BindlessMaterialTable& GetBindlessTable() { return m_bindlessTable; }
+		inline const GpuProfiler& GetGpuProfiler() const { return m_gpuProfiler; }
+		inline const FrameMetricsRecorder& GetFrameMetrics() const { return m_frameMetrics; }
 		inline uint32_t GetFrameIndex() const { return m_frameCounter % globals::MaxOverlappedFrames; }
 		inline uint32_t GetFrameCounter() const { return m_frameCounter; }
+		// Device memory per heap, memory type and resource category.
+		MemoryTelemetry GetMemoryTelemetry() const;
 	protected:
 		void BeginFrame();
 		void Draw();
+		// Record the renderers of the frame in secondary command buffers and execute them in order in cmd.
+		void RecordPasses(VkCommandBuffer cmd, uint32_t swapchainImageIndex);
 		void ImGuiDraw();
 		void WaitFence(VkFence fence, uint64_t timeoutSeconds = 1e9);
 		RenderFrameContext& GetFrameContext();
@@ -146,6 +139,8 @@ namespace vkmmc
 	private:
 
 		Window m_window;
+		// Offscreen rendering without window, surface nor present.
+		bool m_headless{ false };
 		
 		RenderContext m_renderContext;
 
@@ -158,10 +153,23 @@ namespace vkmmc
 		std::vector<RenderPassAttachment> m_swapchainAttachments;
 
 		RenderFrameContext m_frameContextArray[globals::MaxOverlappedFrames];
-		uint32_t m_frameCounter;
+		// Secondary command buffers per frame in flight and recording thread.
+		FrameCommandPool m_frameCommandPool;
+		// Transient per frame data of every frame in flight.
+		TransientBuffer m_transientBuffer;
+		// Timestamps and pipeline statistics of passes and renderers.
+		GpuProfiler m_gpuProfiler;
+		// Metrics of the last frames, streamed to disk when enabled.
+		FrameMetricsRecorder m_frameMetrics;
+		uint32_t m_frameCounter{ 0 };
 
 		DescriptorAllocator m_descriptorAllocator;
+		FrameDescriptorAllocator m_frameDescriptorAllocator;
 		DescriptorLayoutCache m_descriptorLayoutCache;
+		PipelineCache m_pipelineCache;
+		ShaderLibrary m_shaderLibrary;
+		PipelineBuildQueue m_pipelineQueue;
+		PipelineHotReload m_pipelineHotReload;
 
 		VkDescriptorSetLayout m_globalDescriptorLayout;
 
@@ -170,6 +178,13 @@ namespace vkmmc
 		Scene* m_scene;
 		CameraData m_cameraData;
 
+		WorkerPool m_workerPool;
+		// Textures shared between scenes
+		TextureCache m_textureCache;
+		SamplerCache m_samplerCache;
+		TextureStreamer m_textureStreamer;
+		BindlessMaterialTable m_bindlessTable;
+
 		FunctionStack m_shutdownStack;
 		typedef std::function<void()> ImGuiCallback;
 		std::vector<ImGuiCallback> m_imguiCallbackArray;
@@ -0,0 +1,141 @@
+// Autogenerated code for vkmmc project
+// Source file
+
+#include "WorkerPool.h"
+#include "Debug.h"
+#include <algorithm>
+
+namespace vkmmc
+{
+	thread_local uint32_t GThreadIndex = 0;
+
+	uint32_t WorkerPool::GetThreadIndex()
+	{
+		return GThreadIndex;
+	}
+
+	void WorkerPool::Init(uint32_t threadCount)
+	{
+		check(m_threads.empty());
+		if (!threadCount)
+		{
+			uint32_t cores = std::thread::hardware_concurrency();
+			threadCount = cores > 1 ? cores - 1 : 1;
+		}
+		m_exit = false;
+		for (uint32_t i = 0; i < threadCount; ++i)
+			m_threads.emplace_back([this, i]() { WorkerLoop(i + 1); });
+		Logf(LogLevel::Info, "Worker pool initialized with %u threads.\n", threadCount);
+	}
+
+	void WorkerPool::Destroy()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_exit = true;
+		}
+		m_taskCondition.notify_all();
+		for (std::thread& thread : m_threads)
+			thread.join();
+		m_threads.clear();
+		m_tasks.clear();
+		m_pendingTasks = 0;
+	}
+
+	void WorkerPool::Submit(Task&& task)
+	{
+		if (m_threads.empty())
+		{
+			// Not initialized, run inline.
+			task();
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.push_back(std::move(task));
+			++m_pendingTasks;
+		}
+		m_taskCondition.notify_one();
+	}
+
+	void WorkerPool::Wait()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_doneCondition.wait(lock, [this]() { return m_pendingTasks == 0; });
+	}
+
+	void WorkerPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& fn)
+	{
+		if (!count)
+			return;
+		ParallelJob job;
+		job.Fn = &fn;
+		job.Count = count;
+		const uint32_t helpers = __min(GetThreadCount(), count - 1);
+		if (helpers)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_parallelJobs.push_back(&job);
+			}
+			for (uint32_t i = 0; i < helpers; ++i)
+				m_taskCondition.notify_one();
+		}
+		RunIterations(job);
+		if (!helpers)
+			return;
+		// Workers that joined may still be running their last iteration, job lives in this stack frame.
+		std::unique_lock<std::mutex> lock(m_mutex);
+		RemoveParallelJob(&job);
+		m_parallelDoneCondition.wait(lock, [&job]() { return job.Workers == 0; });
+	}
+
+	void WorkerPool::RunIterations(ParallelJob& job)
+	{
+		for (uint32_t i = job.Next++; i < job.Count; i = job.Next++)
+			(*job.Fn)(i);
+	}
+
+	void WorkerPool::RemoveParallelJob(ParallelJob* job)
+	{
+		auto it = std::find(m_parallelJobs.begin(), m_parallelJobs.end(), job);
+		if (it != m_parallelJobs.end())
+			m_parallelJobs.erase(it);
+	}
+
+	void WorkerPool::WorkerLoop(uint32_t threadIndex)
+	{
+		GThreadIndex = threadIndex;
+		while (true)
+		{
+			Task task;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_taskCondition.wait(lock, [this]() { return m_exit || !m_parallelJobs.empty() || !m_tasks.empty(); });
+				if (!m_parallelJobs.empty())
+				{
+					// Parallel jobs first, their caller is blocked until they finish.
+					ParallelJob* job = m_parallelJobs.front();
+					++job->Workers;
+					lock.unlock();
+					RunIterations(*job);
+					lock.lock();
+					RemoveParallelJob(job);
+					if (--job->Workers == 0)
+						m_parallelDoneCondition.notify_all();
+					continue;
+				}
+				if (m_exit && m_tasks.empty())
+					return;
+				task = std::move(m_tasks.front());
+				m_tasks.pop_front();
+			}
+			task();
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				--m_pendingTasks;
+			}
+			m_doneCondition.notify_all();
+		}
+	}
+}
@@ -0,0 +1,66 @@
+// Autogenerated code for vkmmc project
+// Header file
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+namespace vkmmc
+{
+	/**
+	 * Fixed set of worker threads consuming tasks from a shared queue.
+	 * ParallelFor jobs have their own queue, served by workers before any task.
+	 */
+	class WorkerPool
+	{
+		// Iterations of one ParallelFor, lives in the stack of the calling thread.
+		struct ParallelJob
+		{
+			const std::function<void(uint32_t)>* Fn;
+			uint32_t Count;
+			std::atomic<uint32_t> Next{ 0 };
+			// Workers running iterations of the job, guarded by the pool mutex.
+			uint32_t Workers{ 0 };
+		};
+	public:
+		typedef std::function<void()> Task;
+
+		// threadCount = 0 uses one thread per hardware core minus the calling thread.
+		void Init(uint32_t threadCount = 0);
+		void Destroy();
+
+		void Submit(Task&& task);
+		// Block until every submitted task has finished.
+		void Wait();
+		// Run fn(i) for i in [0, count). Calling thread takes part of the iterations, never other tasks,
+		// and returns when all iterations are done.
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& fn);
+
+		uint32_t GetThreadCount() const { return (uint32_t)m_threads.size(); }
+		// 0 for threads outside the pool, i + 1 for worker i. Indexes per thread data.
+		static uint32_t GetThreadIndex();
+
+	private:
+		void WorkerLoop(uint32_t threadIndex);
+		static void RunIterations(ParallelJob& job);
+		// Job does not take more workers once its iterations are all taken. Requires the mutex.
+		void RemoveParallelJob(ParallelJob* job);
+
+		std::vector<std::thread> m_threads;
+		std::deque<Task> m_tasks;
+		std::vector<ParallelJob*> m_parallelJobs;
+		std::mutex m_mutex;
+		std::condition_variable m_taskCondition;
+		std::condition_variable m_doneCondition;
+		std::condition_variable m_parallelDoneCondition;
+		uint32_t m_pendingTasks = 0;
+		bool m_exit = false;
+	};
+}